@@ -0,0 +1,51 @@
+#include <at/address.hpp>
+#include <benchmark/benchmark.h>
+
+static void BM_AddressBase58Check(benchmark::State& state)
+{
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(
+            at::address::isValid("BTC", "1A1zP1eP5QGefi2DMPTfTL5SLmv7DivfNa"));
+    }
+}
+BENCHMARK(BM_AddressBase58Check);
+
+static void BM_AddressSegwit(benchmark::State& state)
+{
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(at::address::isValid(
+            "BTC", "bc1qar0srrr7xfkvy5l643lydnw9re59gtzzwf5mdq"));
+    }
+}
+BENCHMARK(BM_AddressSegwit);
+
+static void BM_AddressEIP55(benchmark::State& state)
+{
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(at::address::isValid(
+            "ETH", "0x5aAeb6053F3E94C9b9A09f33669435E7Ef1BeAed"));
+    }
+}
+BENCHMARK(BM_AddressEIP55);
+
+static void BM_AddressMonero(benchmark::State& state)
+{
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(at::address::isValid(
+            "XMR",
+            "44AFFq5kSiGBoZ4NMDwYtN18obc8AemS33DBLWs3H7otXft3XjrpDtQGv7SqSsaBYB"
+            "b98uNbr2VBBEt7f2wfn3RVGQBEP3A"));
+    }
+}
+BENCHMARK(BM_AddressMonero);
+
+static void BM_AddressBatch(benchmark::State& state)
+{
+    std::vector<at::hash_t> addresses(state.range(0),
+                                      "1A1zP1eP5QGefi2DMPTfTL5SLmv7DivfNa");
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(at::address::isValid("BTC", addresses));
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_AddressBatch)->Range(8, 1024);
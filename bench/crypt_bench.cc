@@ -0,0 +1,76 @@
+#include <at/crypt/namespace.hpp>
+#include <at/kraken.hpp>
+#include <at/request.hpp>
+#include <at/transport.hpp>
+#include <benchmark/benchmark.h>
+
+// Answers every request from memory, without network
+class MemoryTransport : public at::Transport {
+public:
+    at::http_response_t perform(const at::http_request_t&) override
+    {
+        return at::http_response_t{200, R"({"error":[],"result":{}})", {}};
+    }
+};
+
+// A secret in the format of the Kraken API secrets: base64 of 64 bytes
+static const std::string secret =
+    "kQH5HW/8p1uGOVjbgWA7FunAmGO8lsSUXNsu3eow76sz84Q18fWxnyRzBHCd3pd5nE9qa9"
+    "9HAZtuZuj6F1huXg==";
+
+static const std::string postdata =
+    "nonce=1539900000123456789&pair=XXBTZEUR&type=buy&ordertype=limit&"
+    "price=6500.0&volume=0.002";
+
+static void BM_Sha256(benchmark::State& state)
+{
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(at::crypt::sha256(postdata));
+    }
+}
+BENCHMARK(BM_Sha256);
+
+static void BM_HmacSha512(benchmark::State& state)
+{
+    const auto key = at::crypt::base64_decode(secret);
+    const std::vector<unsigned char> data(postdata.begin(), postdata.end());
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(at::crypt::hmac_sha512(data, key));
+    }
+}
+BENCHMARK(BM_HmacSha512);
+
+static void BM_Base64Encode(benchmark::State& state)
+{
+    const std::vector<unsigned char> data(state.range(0), 0xa5);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(at::crypt::base64_encode(data));
+    }
+    state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_Base64Encode)->Arg(64)->Arg(1024);
+
+static void BM_Base64Decode(benchmark::State& state)
+{
+    const std::string data = at::crypt::base64_encode(
+        std::vector<unsigned char>(state.range(0), 0xa5));
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(at::crypt::base64_decode(data));
+    }
+    state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_Base64Decode)->Arg(64)->Arg(1024);
+
+// A private call without network: nonce, form body, signature and the
+// parse of an empty result
+static void BM_KrakenSignedRequest(benchmark::State& state)
+{
+    auto network = at::Request::transport();
+    at::Request::transport(std::make_shared<MemoryTransport>());
+    at::Kraken kraken("key", secret);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(kraken.balance());
+    }
+    at::Request::transport(network);
+}
+BENCHMARK(BM_KrakenSignedRequest);
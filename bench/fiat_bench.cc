@@ -0,0 +1,25 @@
+#include <at/fiat.hpp>
+#include <benchmark/benchmark.h>
+
+#include "fixtures.hpp"
+
+// Parsing of eurofxref-daily.xml and build of the cross-rate matrix
+static void BM_FiatParse(benchmark::State& state)
+{
+    const std::string xml = fixture("eurofxref-daily.xml");
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(at::Fiat::parse(xml));
+    }
+}
+BENCHMARK(BM_FiatParse);
+
+// Refresh that keeps the currency ids of the previous rates
+static void BM_FiatParsePrevious(benchmark::State& state)
+{
+    const std::string xml = fixture("eurofxref-daily.xml");
+    const at::fiat_rates_t previous = at::Fiat::parse(xml);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(at::Fiat::parse(xml, &previous));
+    }
+}
+BENCHMARK(BM_FiatParsePrevious);
@@ -0,0 +1,26 @@
+#ifndef AT_BENCH_FIXTURES_H_
+#define AT_BENCH_FIXTURES_H_
+
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+// Directory of the recorded payloads, set by bench/CMakeLists.txt
+#ifndef OPENAT_BENCH_FIXTURES
+#define OPENAT_BENCH_FIXTURES "fixtures/"
+#endif
+
+// Returns the content of the fixture name
+inline std::string fixture(const std::string& name)
+{
+    std::ifstream file(OPENAT_BENCH_FIXTURES + name, std::ios::binary);
+    if (!file) {
+        throw std::runtime_error("Unable to open fixture " + name);
+    }
+    std::ostringstream content;
+    content << file.rdbuf();
+    return content.str();
+}
+
+#endif  // AT_BENCH_FIXTURES_H_
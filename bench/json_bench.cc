@@ -0,0 +1,112 @@
+#include <at/kraken.hpp>
+#include <at/types.hpp>
+#include <benchmark/benchmark.h>
+
+#include <map>
+
+#include "fixtures.hpp"
+
+using at::json;
+
+// Parsing of the recorded payloads
+static void BM_JsonParse(benchmark::State& state, const char* name)
+{
+    const std::string payload = fixture(name);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(json::parse(payload));
+    }
+    state.SetBytesProcessed(state.iterations() * payload.size());
+}
+BENCHMARK_CAPTURE(BM_JsonParse, kraken_ticker, "kraken_ticker.json");
+BENCHMARK_CAPTURE(BM_JsonParse, kraken_depth, "kraken_depth.json");
+BENCHMARK_CAPTURE(BM_JsonParse, shapeshift_marketinfo,
+                  "shapeshift_marketinfo.json");
+BENCHMARK_CAPTURE(BM_JsonParse, shapeshift_getcoins,
+                  "shapeshift_getcoins.json");
+BENCHMARK_CAPTURE(BM_JsonParse, coinmarketcap_ticker,
+                  "coinmarketcap_ticker.json");
+
+// Extraction of the order book from a parsed Depth response
+static void BM_KrakenDepth(benchmark::State& state)
+{
+    const json res =
+        json::parse(fixture("kraken_depth.json"))["result"].begin().value();
+    for (auto _ : state) {
+        auto book = at::Kraken::parseOrderBook(res);
+        benchmark::DoNotOptimize(book.data());
+    }
+}
+BENCHMARK(BM_KrakenDepth);
+
+static void BM_FromJsonCoins(benchmark::State& state)
+{
+    const json res = json::parse(fixture("shapeshift_getcoins.json"));
+    for (auto _ : state) {
+        std::map<std::string, at::coin_t> coins;
+        for (auto it = res.begin(); it != res.end(); ++it) {
+            coins[it.key()] = it.value().get<at::coin_t>();
+        }
+        benchmark::DoNotOptimize(coins.size());
+    }
+}
+BENCHMARK(BM_FromJsonCoins);
+
+static void BM_FromJsonCMTicker(benchmark::State& state)
+{
+    const json res = json::parse(fixture("coinmarketcap_ticker.json"));
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(res.get<std::vector<at::cm_ticker_t>>());
+    }
+    state.SetItemsProcessed(state.iterations() * res.size());
+}
+BENCHMARK(BM_FromJsonCMTicker);
+
+// exchange_info_t and market_info_t in the format of to_json, built from
+// the recorded Shapeshift markets
+static json exchange_infos()
+{
+    json ret = json::array();
+    const json markets = json::parse(fixture("shapeshift_marketinfo.json"));
+    for (const auto& market : markets) {
+        ret.push_back(json{
+            {"pair", market.at("pair")},
+            {"limit",
+             {{"min", market.at("min")}, {"max", market.at("limit")}}},
+            {"rate", std::stod(market.at("rate").get<std::string>())},
+            {"miner_fee", market.at("minerFee")},
+            {"maker_fee", 0.16},
+            {"taker_fee", 0.26}});
+    }
+    return ret;
+}
+
+static void BM_FromJsonExchangeInfo(benchmark::State& state)
+{
+    const json res = exchange_infos();
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(res.get<std::vector<at::exchange_info_t>>());
+    }
+    state.SetItemsProcessed(state.iterations() * res.size());
+}
+BENCHMARK(BM_FromJsonExchangeInfo);
+
+static void BM_FromJsonMarketInfo(benchmark::State& state)
+{
+    const json res = exchange_infos();
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(res.get<std::vector<at::market_info_t>>());
+    }
+    state.SetItemsProcessed(state.iterations() * res.size());
+}
+BENCHMARK(BM_FromJsonMarketInfo);
+
+static void BM_ToJsonMarketInfo(benchmark::State& state)
+{
+    const auto markets = exchange_infos().get<std::vector<at::market_info_t>>();
+    for (auto _ : state) {
+        json j = markets;
+        benchmark::DoNotOptimize(j.dump());
+    }
+    state.SetItemsProcessed(state.iterations() * markets.size());
+}
+BENCHMARK(BM_ToJsonMarketInfo);
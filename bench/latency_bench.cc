@@ -0,0 +1,26 @@
+#include <at/latency.hpp>
+#include <benchmark/benchmark.h>
+
+// Cost of recording a duration, from concurrent threads
+static void BM_LatencyRecord(benchmark::State& state)
+{
+    static at::LatencyHistogram histogram;
+    int64_t ns = 1000 + state.thread_index();
+    for (auto _ : state) {
+        histogram.record(std::chrono::nanoseconds(ns));
+        ns = (ns * 7 + 13) % 10000000;
+    }
+}
+BENCHMARK(BM_LatencyRecord)->ThreadRange(1, 8);
+
+static void BM_LatencySummary(benchmark::State& state)
+{
+    at::LatencyHistogram histogram;
+    for (int64_t ns = 1; ns < 10000000; ns = ns * 3 / 2 + 1) {
+        histogram.record(std::chrono::nanoseconds(ns));
+    }
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(histogram.summary());
+    }
+}
+BENCHMARK(BM_LatencySummary);
@@ -0,0 +1,55 @@
+#include <at/marketlog.hpp>
+#include <benchmark/benchmark.h>
+
+#include <cstdio>
+
+static const char* bench_log = "marketlog_bench.bin";
+
+static void BM_MarketRecorderTicker(benchmark::State& state)
+{
+    std::remove(bench_log);
+    {
+        const at::currency_pair_t pair("BTC", "EUR");
+        at::MarketRecorder recorder(bench_log);
+        at::ticker_t ticker = {};
+        ticker.bid.amount = 1;
+        ticker.ask.amount = 2;
+        std::time_t t = 1500000000;
+        for (auto _ : state) {
+            ++t;
+            ticker.bid.price = 8000 + (t % 100) * 0.1;
+            ticker.ask.price = ticker.bid.price + 0.1;
+            ticker.bid.time = ticker.ask.time = t;
+            recorder.ticker(pair, ticker);
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * 2);
+    std::remove(bench_log);
+}
+BENCHMARK(BM_MarketRecorderTicker);
+
+static void BM_MarketLogNext(benchmark::State& state)
+{
+    std::remove(bench_log);
+    {
+        const at::currency_pair_t pair("BTC", "EUR");
+        at::MarketRecorder recorder(bench_log);
+        for (std::time_t t = 0; t < 1000000; ++t) {
+            recorder.trade(pair, at::order_action_t::buy,
+                           at::quotation_t{.price = 8000 + (t % 100) * 0.1,
+                                           .amount = 1,
+                                           .time = t});
+        }
+    }
+    at::MarketLog log(bench_log);
+    at::market_event_t event;
+    for (auto _ : state) {
+        if (!log.next(event)) {
+            log.rewind();
+        }
+        benchmark::DoNotOptimize(event);
+    }
+    state.SetItemsProcessed(state.iterations());
+    std::remove(bench_log);
+}
+BENCHMARK(BM_MarketLogNext);
@@ -0,0 +1,51 @@
+#include <at/kraken.hpp>
+#include <benchmark/benchmark.h>
+
+#include <mutex>
+
+#include "../tests/mockserver.hpp"
+
+// Mock Kraken server shared by the benchmarks
+static std::string kraken_url()
+{
+    static at::MockServer server;
+    static std::once_flag routes;
+    std::call_once(routes, [] { server.kraken(); });
+    return server.url();
+}
+
+// Load test of the client stack (request, connection, parsing) against
+// the local mock server: every thread requests the Kraken ticker
+static void BM_MockKrakenTicker(benchmark::State& state)
+{
+    at::Kraken kraken("key", "c2VjcmV0", kraken_url());
+    const at::currency_pair_t pair("BTC", "EUR");
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(kraken.ticker(pair));
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_MockKrakenTicker)->ThreadRange(1, 8)->UseRealTime();
+
+// Order book of 100 levels per side
+static void BM_MockKrakenOrderBook(benchmark::State& state)
+{
+    at::Kraken kraken("key", "c2VjcmV0", kraken_url());
+    const at::currency_pair_t pair("BTC", "EUR");
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(kraken.orderBook(pair));
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_MockKrakenOrderBook)->UseRealTime();
+
+// Authenticated requests: nonce, signature and form encoded body
+static void BM_MockKrakenBalance(benchmark::State& state)
+{
+    at::Kraken kraken("key", "c2VjcmV0", kraken_url());
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(kraken.balance());
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_MockKrakenBalance)->UseRealTime();
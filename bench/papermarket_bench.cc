@@ -0,0 +1,63 @@
+#include <at/papermarket.hpp>
+#include <benchmark/benchmark.h>
+
+// Strategy-like flow against a fed book of 100 levels per side:
+// limit orders around the spread (some crossing), market orders and
+// cancellations of the stale orders; the book is fed again every 1000
+// orders
+static void BM_PaperMarketPlace(benchmark::State& state)
+{
+    const at::currency_pair_t pair("BTC", "EUR");
+    at::PaperMarket paper(
+        {at::market_info_t{.pair = pair,
+                           .limit = at::min_max_t{.min = 0, .max = 0},
+                           .maker_fee = 0.16,
+                           .taker_fee = 0.26}},
+        {{"BTC", 1e12}, {"EUR", 1e12}}, 0.1);
+
+    std::vector<at::ticker_t> book;
+    for (int i = 0; i < 100; ++i) {
+        book.push_back(at::ticker_t{
+            .bid = {.price = 9999.0 - i, .amount = 1, .time = 0},
+            .ask = {.price = 10001.0 + i, .amount = 1, .time = 0}});
+    }
+    paper.feed(pair, book);
+
+    std::vector<at::order_t> placed(64);
+    at::order_t order = {};
+    order.pair = pair;
+    std::size_t i = 0;
+    for (auto _ : state) {
+        ++i;
+        auto& stale = placed[i % placed.size()];
+        if (stale.status == at::tx_status_t::open) {
+            try {
+                paper.cancel(stale);
+            }
+            catch (const at::response_error&) {
+                // executed in the meantime
+            }
+        }
+
+        order.action = i % 2 ? at::order_action_t::buy
+                             : at::order_action_t::sell;
+        if (i % 8 == 0) {
+            order.type = at::order_type_t::market;
+            order.volume = 0.5;
+        }
+        else {
+            order.type = at::order_type_t::limit;
+            order.volume = 1;
+            double offset = static_cast<double>(i % 7) - 1;
+            order.price = i % 2 ? 10000.0 - offset : 10000.0 + offset;
+        }
+        paper.place(order);
+        stale = order;
+
+        if (i % 1000 == 0) {
+            paper.feed(pair, book);
+        }
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_PaperMarketPlace);
@@ -0,0 +1,72 @@
+#include <at/rategraph.hpp>
+#include <benchmark/benchmark.h>
+
+#include <limits>
+
+#include "fixtures.hpp"
+
+using at::json;
+
+// The recorded Shapeshift markets: 30 currencies, every pair traded
+static std::vector<at::exchange_info_t> markets()
+{
+    std::vector<at::exchange_info_t> ret;
+    const json markets = json::parse(fixture("shapeshift_marketinfo.json"));
+    for (const auto& market : markets) {
+        auto pair = market.at("pair").get<std::string>();
+        auto delimiter = pair.find('_');
+        ret.push_back(at::exchange_info_t{
+            .pair = at::currency_pair_t(pair.substr(0, delimiter),
+                                        pair.substr(delimiter + 1)),
+            .limit = {.min = market.at("min").get<double>(),
+                      .max = market.at("limit").get<double>()},
+            .rate = std::stod(market.at("rate").get<std::string>()),
+            .miner_fee = market.at("minerFee").get<double>(),
+        });
+    }
+    return ret;
+}
+
+// Best conversion with at most state.range(0) hops
+static void BM_RateGraphBest(benchmark::State& state)
+{
+    const at::RateGraph graph(markets());
+    const auto hops = static_cast<std::size_t>(state.range(0));
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(graph.best("BTC", "DOGE", 1, hops));
+    }
+    state.counters["currencies"] = static_cast<double>(graph.size());
+}
+BENCHMARK(BM_RateGraphBest)->DenseRange(1, 6);
+
+// Update with an unchanged snapshot
+static void BM_RateGraphUpdate(benchmark::State& state)
+{
+    const auto info = markets();
+    at::RateGraph graph(info);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(graph.update(info));
+    }
+    state.SetItemsProcessed(state.iterations() * info.size());
+}
+BENCHMARK(BM_RateGraphUpdate);
+
+// Best conversion with at most state.range(0) hops over the Shapeshift
+// currencies traded without limits nor fees: no path is pruned, the
+// worst case of the search
+static void BM_RateGraphBestUnlimited(benchmark::State& state)
+{
+    auto info = markets();
+    for (auto& market : info) {
+        market.limit.min = 0;
+        market.limit.max = std::numeric_limits<double>::max();
+        market.miner_fee = 0;
+    }
+    const at::RateGraph graph(info);
+    const auto hops = static_cast<std::size_t>(state.range(0));
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(graph.best("BTC", "DOGE", 1, hops));
+    }
+    state.counters["currencies"] = static_cast<double>(graph.size());
+}
+BENCHMARK(BM_RateGraphBestUnlimited)->DenseRange(1, 6);
@@ -0,0 +1,54 @@
+#include <at/replay.hpp>
+#include <benchmark/benchmark.h>
+
+#include <cstdio>
+
+// Replay of state.range(0) logs of tickers and 10 levels order books,
+// merged by time
+static void BM_Replay(benchmark::State& state)
+{
+    const std::size_t logs = static_cast<std::size_t>(state.range(0));
+    const std::vector<std::string> symbols = {"BTC", "ETH", "LTC", "XMR"};
+    std::vector<std::string> paths;
+    std::vector<at::market_info_t> markets;
+    for (std::size_t i = 0; i < logs; ++i) {
+        paths.push_back("replay_bench_" + std::to_string(i) + ".bin");
+        std::remove(paths.back().c_str());
+        at::currency_pair_t pair(symbols[i % symbols.size()], "EUR");
+        markets.push_back(at::market_info_t{.pair = pair,
+                                            .limit = {.min = 0, .max = 0},
+                                            .maker_fee = 0.16,
+                                            .taker_fee = 0.26});
+
+        at::MarketRecorder recorder(paths.back());
+        std::vector<at::ticker_t> book(10);
+        for (std::time_t t = 0; t < 100000; ++t) {
+            double mid = 1000 + (t % 200) - 100;
+            for (std::size_t level = 0; level < book.size(); ++level) {
+                book[level].bid = {
+                    .price = mid - 1 - level, .amount = 1, .time = t};
+                book[level].ask = {
+                    .price = mid + 1 + level, .amount = 1, .time = t};
+            }
+            if (t % 10 == 0) {
+                recorder.orderBook(pair, book, t);
+            }
+            else {
+                recorder.ticker(pair, book[0]);
+            }
+        }
+    }
+
+    std::size_t events = 0;
+    for (auto _ : state) {
+        at::PaperMarket market(markets, {{"EUR", 1e9}}, 0.01);
+        at::Replay replay(market, paths);
+        events += replay.run();
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(events));
+
+    for (const auto& path : paths) {
+        std::remove(path.c_str());
+    }
+}
+BENCHMARK(BM_Replay)->Arg(1)->Arg(4)->Unit(benchmark::kMillisecond);
@@ -0,0 +1,72 @@
+#include <at/kraken.hpp>
+#include <at/request.hpp>
+#include <at/transport.hpp>
+#include <benchmark/benchmark.h>
+
+#include <cstdio>
+
+#include "../tests/mockserver.hpp"
+
+// Kraken client stack without network: the responses are recorded once
+// from the mock server and replayed from the memory mapped recording
+static void BM_ReplayKraken(benchmark::State& state)
+{
+    const std::string path = "transport_bench.bin";
+    std::remove(path.c_str());
+    auto network = at::Request::transport();
+    const at::currency_pair_t pair("BTC", "EUR");
+    std::string host;
+    {
+        at::MockServer server;
+        server.kraken();
+        host = server.url();
+        at::Kraken kraken("key", "c2VjcmV0", host);
+        at::Request::transport(
+            std::make_shared<at::RecordingTransport>(network, path));
+        kraken.ticker(pair);
+        kraken.orderBook(pair);
+        kraken.balance();
+    }
+    at::Request::transport(std::make_shared<at::ReplayTransport>(path));
+
+    at::Kraken kraken("key", "c2VjcmV0", host);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(kraken.ticker(pair));
+        benchmark::DoNotOptimize(kraken.orderBook(pair));
+        benchmark::DoNotOptimize(kraken.balance());
+    }
+    state.SetItemsProcessed(state.iterations() * 3);
+
+    at::Request::transport(network);
+    std::remove(path.c_str());
+}
+BENCHMARK(BM_ReplayKraken);
+
+// Transfer of a large response, e.g. the full CoinMarketCap ticker
+static void BM_CurlTransportLarge(benchmark::State& state)
+{
+    at::MockServer server;
+    std::string body = "[";
+    while (body.size() < static_cast<std::size_t>(state.range(0))) {
+        body += R"({"id":"bitcoin","price_usd":"6512.3","volume":"4e9"},)";
+    }
+    body.back() = ']';
+    server.route("GET", "/large", at::mock_response_t{200, body,
+                                                      "application/json"});
+    at::CurlTransport transport;
+    at::http_request_t request = {};
+    request.method = "GET";
+    request.url = server.url() + "large";
+    for (auto _ : state) {
+        auto response = transport.perform(request);
+        benchmark::DoNotOptimize(response.body.data());
+        at::Transport::recycle(std::move(response.body));
+    }
+    state.SetBytesProcessed(state.iterations() *
+                            static_cast<int64_t>(body.size()));
+}
+BENCHMARK(BM_CurlTransportLarge)
+    ->Arg(64 << 10)
+    ->Arg(4 << 20)
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
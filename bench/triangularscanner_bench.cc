@@ -0,0 +1,44 @@
+#include <at/triangularscanner.hpp>
+#include <benchmark/benchmark.h>
+
+// 30 currencies traded against 5 quote currencies, that are traded
+// among themselves
+static void BM_TriangularScannerUpdate(benchmark::State& state)
+{
+    const std::vector<std::string> quotes = {"BTC", "ETH", "EUR", "USD",
+                                             "JPY"};
+    std::vector<at::market_info_t> markets;
+    auto add = [&](const std::string& base, const std::string& quote) {
+        markets.push_back(
+            at::market_info_t{.pair = at::currency_pair_t(base, quote),
+                              .limit = {.min = 0, .max = 0},
+                              .maker_fee = 0.16,
+                              .taker_fee = 0.26});
+    };
+    for (std::size_t i = 0; i < quotes.size(); ++i) {
+        for (std::size_t j = i + 1; j < quotes.size(); ++j) {
+            add(quotes[i], quotes[j]);
+        }
+    }
+    for (int i = 0; i < 30; ++i) {
+        for (const auto& quote : quotes) {
+            add("C" + std::to_string(i), quote);
+        }
+    }
+    at::TriangularScanner scanner(markets);
+    const at::ticker_t ticker = {
+        .bid = {.price = 1, .amount = 1, .time = 0},
+        .ask = {.price = 1.01, .amount = 1, .time = 0},
+    };
+    for (const auto& market : markets) {
+        scanner.update(market.pair, ticker);
+    }
+
+    std::size_t i = 0;
+    for (auto _ : state) {
+        const auto& market = markets[i++ % markets.size()];
+        benchmark::DoNotOptimize(scanner.update(market.pair, ticker));
+    }
+    state.counters["cycles"] = static_cast<double>(scanner.size());
+}
+BENCHMARK(BM_TriangularScannerUpdate);
@@ -0,0 +1,59 @@
+#include <at/types.hpp>
+#include <benchmark/benchmark.h>
+
+#include <map>
+
+static void BM_CurrencyPairConstruct(benchmark::State& state)
+{
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(at::currency_pair_t("xbt", "eur"));
+    }
+}
+BENCHMARK(BM_CurrencyPairConstruct);
+
+static void BM_CurrencyPairEqual(benchmark::State& state)
+{
+    const at::currency_pair_t a("XBT", "EUR"), b("XBT", "USD");
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(a == b);
+    }
+}
+BENCHMARK(BM_CurrencyPairEqual);
+
+static void BM_CurrencyPairLess(benchmark::State& state)
+{
+    const at::currency_pair_t a("XBT", "EUR"), b("XBT", "USD");
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(a < b);
+    }
+}
+BENCHMARK(BM_CurrencyPairLess);
+
+// Lookup in a std::map keyed by currency_pair_t, as Kraken::_minimumLimits
+// and the books of ConsolidatedBook
+static void BM_CurrencyPairMapFind(benchmark::State& state)
+{
+    const std::vector<std::string> symbols = {
+        "XBT", "ETH", "LTC", "XMR", "ZEC", "DASH", "DOGE", "BCH",
+        "ETC", "REP", "GNO", "XRP", "XLM", "EOS", "USDT", "EUR"};
+    std::map<at::currency_pair_t, double> pairs;
+    for (const auto& base : symbols) {
+        for (const auto& quote : symbols) {
+            pairs[at::currency_pair_t(base, quote)] = 1;
+        }
+    }
+    const at::currency_pair_t key("XMR", "EUR");
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(pairs.find(key));
+    }
+}
+BENCHMARK(BM_CurrencyPairMapFind);
+
+static void BM_Normalize(benchmark::State& state)
+{
+    const at::currency_pair_t pair("XXBT", "ZEUR");
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(at::normalize(pair));
+    }
+}
+BENCHMARK(BM_Normalize);
@@ -0,0 +1,79 @@
+/* Copyright 2017 Paolo Galeone <nessuno@nerdz.eu>. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.*/
+
+#ifndef AT_ADDRESS_H_
+#define AT_ADDRESS_H_
+
+#include <at/types.hpp>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Offline validation of cryptocurrency addresses.
+// No request is made: the format and the checksum of the address are
+// verified locally.
+namespace at::address {
+
+// Returns true if the addresses of symbol can be validated offline
+bool isSupported(std::string symbol);
+
+/* Returns true if address is a valid address for symbol.
+ * Supported formats:
+ *  - Base58Check (BTC, BCH legacy, LTC, DOGE, DASH, ZEC transparent)
+ *  - Bech32 and Bech32m segwit addresses (BTC, LTC)
+ *  - EIP-55 checksummed hex (ETH, ETC)
+ *  - Ripple Base58Check (XRP)
+ *  - Monero standard, integrated and subaddresses (XMR)
+ *
+ * Throws std::invalid_argument if symbol is not supported. */
+bool isValid(std::string symbol, const hash_t& address);
+
+/* Batch version of isValid: ret[i] = isValid(symbol, addresses[i]) */
+std::vector<bool> isValid(std::string symbol,
+                          const std::vector<hash_t>& addresses);
+
+// Format checks, independent from the currency
+
+// Version prefix of a Base58Check address: value on size (1 or 2) bytes
+typedef struct {
+    uint16_t value;
+    std::size_t size;
+} base58_version_t;
+
+/* Returns true if address is Base58Check encoded (with the bitcoin or the
+ * ripple alphabet) and its version prefix is one of versions, with the
+ * payload of 20 bytes.
+ * Both the value and the size of the version must match: 0x0005 on 2
+ * bytes is not the version 0x05 on 1 byte. */
+bool isBase58Check(const std::string& address,
+                   const std::vector<base58_version_t>& versions,
+                   bool ripple = false);
+
+/* Returns true if address is a segwit address encoded in Bech32 (witness
+ * version 0) or Bech32m (witness version 1 to 16) with the human
+ * readable part hrp. */
+bool isSegwit(const std::string& address, const std::string& hrp);
+
+/* Returns true if address is a 0x prefixed 20 bytes hex address, and if it
+ * is mixed case the EIP-55 checksum matches. */
+bool isEIP55(const std::string& address);
+
+/* Returns true if address is a Monero address with one of the network
+ * prefixes */
+bool isMonero(const std::string& address,
+              const std::vector<uint64_t>& prefixes);
+
+}  // end namespace at::address
+
+#endif  // AT_ADDRESS_H_
@@ -0,0 +1,137 @@
+/* Copyright 2017 Paolo Galeone <nessuno@nerdz.eu>. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.*/
+
+#ifndef AT_ARBITRAGEDETECTOR_H_
+#define AT_ARBITRAGEDETECTOR_H_
+
+#include <at/exchange.hpp>
+#include <at/market.hpp>
+#include <at/types.hpp>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace at {
+
+/* Arbitrage between a market and an exchange: amount of from is
+ * converted to to on the market (order of type action on market_pair),
+ * then to is converted back to from on the exchange (exchange_pair).
+ * output is the amount of from obtained, after the market fee, the
+ * exchange rate and its miner fee. */
+typedef struct {
+    std::string from, to;
+    currency_pair_t market_pair;
+    order_action_t action;
+    currency_pair_t exchange_pair;
+    double amount, output, ratio;  // ratio = output / amount
+    // time from the update that generated the opportunity to the callback
+    std::chrono::nanoseconds latency;
+} arbitrage_t;
+
+// Latency from an update to the emission of its opportunities
+typedef struct {
+    uint64_t count;
+    std::chrono::nanoseconds min, max, total;
+} arbitrage_latency_t;
+
+/* Detects the arbitrages between the books of a Market (e.g. Kraken) and
+ * the rates of an Exchange (e.g. Shapeshift).
+ *
+ * Prices are kept in a matrix of the normalized currencies (normalize()):
+ * cell (i, j) of the market contains the rate to convert i into j
+ * (fee included) and the amount available at the top of the book,
+ * cell (i, j) of the exchange the rate, the miner fee and the deposit
+ * limits to convert i into j.
+ *
+ * Every cycle market (i -> j) + exchange (j -> i) depends only on two
+ * cells, thus an update recomputes only the cycles of the cells changed:
+ * two for a ticker, one for an exchange rate. The amount of a cycle is the
+ * largest one allowed by the book and by the deposit limits.
+ *
+ * The opportunities with ratio > 1 + threshold are passed to callback.
+ * The latency between the update and the callback is measured.
+ *
+ * Updates can be pushed (update) or pulled from the sources (refresh).
+ * All the methods are thread safe; callback is called without holding
+ * any lock. */
+class ArbitrageDetector {
+public:
+    typedef std::function<void(const arbitrage_t&)> callback_t;
+
+private:
+    typedef struct {
+        // market: rate and amount available (in units of the row currency)
+        double market_rate, market_amount;
+        currency_pair_t market_pair;
+        order_action_t action;
+        // exchange
+        double exchange_rate, miner_fee;
+        min_max_t limit;
+        currency_pair_t exchange_pair;
+    } cell_t;
+
+    Market& _market;
+    Exchange& _exchange;
+    const callback_t _callback;
+    const double _threshold;
+
+    std::mutex _mux;
+    std::map<std::string, std::size_t> _ids;
+    std::vector<std::string> _currencies;
+    // _stride^2 cells, row major: the rows have room for _stride currencies
+    std::vector<cell_t> _cells;
+    std::size_t _stride = 0;
+    arbitrage_latency_t _latency{0, std::chrono::nanoseconds::max(),
+                                 std::chrono::nanoseconds(0),
+                                 std::chrono::nanoseconds(0)};
+
+    // Id of currency, growing the matrix if needed. Requires _mux
+    std::size_t _id(const std::string& currency);
+    cell_t& _cell(std::size_t from, std::size_t to);
+
+    // Evaluates the cycle market (from -> to) + exchange (to -> from) and
+    // appends it to found if profitable. Requires _mux
+    void _evaluate(std::size_t from, std::size_t to,
+                   std::vector<arbitrage_t>& found);
+
+    void _emit(std::vector<arbitrage_t>& found,
+               std::chrono::steady_clock::time_point start);
+
+public:
+    /* Detects the arbitrages between market and exchange with a ratio
+     * greater than 1 + threshold */
+    ArbitrageDetector(Market& market, Exchange& exchange, callback_t callback,
+                      double threshold = 0);
+
+    /* Updates the market cells of pair with ticker, using the taker fee
+     * of info */
+    void update(const market_info_t& info, const ticker_t& ticker);
+
+    /* Updates the exchange cell of info.pair */
+    void update(const exchange_info_t& info);
+
+    /* Fetches the tickers of pairs (and their fees) from the market and
+     * the rates of the exchange, updating the matrix */
+    void refresh(const std::vector<currency_pair_t>& pairs);
+
+    arbitrage_latency_t latency();
+};
+
+}  // end namespace at
+
+#endif  // AT_ARBITRAGEDETECTOR_H_
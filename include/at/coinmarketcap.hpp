@@ -20,6 +20,7 @@
 
 #include <at/exceptions.hpp>
 #include <at/market.hpp>
+#include <at/tickertable.hpp>
 #include <at/types.hpp>
 #include <chrono>
 
@@ -38,12 +39,16 @@ namespace at {
 class CoinMarketCap : private Thrower {
 private:
     // const std::string _host = "https://api.coinmarketcap.com/v1/";
-    const std::string _host = "https://api.alternative.me/v1/";
-    const std::string _reverse_host = "https://coinmarketcap.com/";
+    const std::string _host, _reverse_host;
     std::map<std::string, std::string> _symbol_to_id;
 
 public:
-    CoinMarketCap()
+    /* host is the JSON API, reverse_host the website scraped by markets().
+     * They can be replaced, e.g. by a local mock server. */
+    explicit CoinMarketCap(
+        std::string host = "https://api.alternative.me/v1/",
+        std::string reverse_host = "https://coinmarketcap.com/")
+        : _host(host), _reverse_host(reverse_host)
     {
         auto infos = ticker();
         for (const auto& info : infos) {
@@ -52,9 +57,22 @@ public:
     }
     ~CoinMarketCap() {}
 
+    /* Resolves, connects and completes the TLS handshake with host and
+     * reverse_host ahead of the next calls of the calling thread */
+    void warmup();
+
     std::vector<cm_ticker_t> ticker();
     std::vector<cm_ticker_t> ticker(uint32_t limit);
     cm_ticker_t ticker(std::string currency_symbol);
+
+    /* Incremental version of ticker(): fetches the ticker list and merges it
+     * into table, updating only the rows whose last_updated changed.
+     * If limit is 0 the complete list is fetched and the coins no more
+     * listed are removed from the table, otherwise only the page of limit
+     * rows starting from start is fetched and merged.
+     * Returns the set of rows added, updated and removed. */
+    cm_ticker_changes_t refresh(TickerTable& table, uint32_t start = 0,
+                                uint32_t limit = 0);
     std::vector<cm_market_t> markets(std::string currency_symbol);
     gm_data_t global();
 };
@@ -0,0 +1,125 @@
+/* Copyright 2017 Paolo Galeone <nessuno@nerdz.eu>. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.*/
+
+#ifndef AT_CONSOLIDATEDBOOK_H_
+#define AT_CONSOLIDATEDBOOK_H_
+
+#include <at/market.hpp>
+#include <at/types.hpp>
+#include <cstddef>
+#include <exception>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace at {
+
+// Level of a venue in the consolidated book
+typedef struct {
+    std::size_t venue;
+    double price;      // price on the venue
+    double effective;  // price including the taker fee of the venue
+    double amount;
+} venue_quotation_t;
+
+// Order to place on a venue, part of a routed order
+typedef struct {
+    std::size_t venue;
+    order_t order;
+} child_order_t;
+
+/* Order book consolidated from the books of several markets (venues).
+ *
+ * Pairs are normalized (normalize()), hence XBT_EUR on Kraken and BTC_EUR
+ * on another venue are the same book. Every level is ranked by its
+ * effective price: the price plus (asks) or minus (bids) the taker fee
+ * of the venue.
+ *
+ * The consolidated book is updated incrementally: an update of a venue
+ * replaces only the levels of that venue, thus the cost of an update is
+ * proportional to the depth of the venue book and the best levels are
+ * always at the top of the book.
+ *
+ * This class is not thread safe. */
+class ConsolidatedBook {
+private:
+    // levels sorted by effective price, best first: asks are keyed by
+    // effective price, bids by -effective price
+    typedef std::multimap<double, venue_quotation_t> side_t;
+
+    typedef struct {
+        currency_pair_t pair;  // pair on the venue
+        double taker_fee;
+        double min_volume;
+        std::vector<side_t::iterator> bids, asks;
+    } venue_book_t;
+
+    typedef struct {
+        side_t bids, asks;
+        std::vector<venue_book_t> venues;
+    } book_t;
+
+    std::vector<Market*> _venues;
+    std::map<currency_pair_t, book_t> _books;  // normalized pair
+
+    const book_t& _book(const currency_pair_t& pair) const;
+
+public:
+    /* Consolidates the books of venues. The venue id used by the other
+     * methods is the index in venues. */
+    explicit ConsolidatedBook(std::vector<Market*> venues);
+
+    /* Fetches the order book and the fees of pair from venue and replaces
+     * its levels in the consolidated book */
+    void update(std::size_t venue, const currency_pair_t& pair);
+
+    /* Replaces the levels of venue with book (in the format returned by
+     * Market::orderBook) and market info, without any request */
+    void update(std::size_t venue, const market_info_t& info,
+                const std::vector<ticker_t>& book);
+
+    /* Removes the levels of venue for pair */
+    void remove(std::size_t venue, const currency_pair_t& pair);
+
+    /* Best levels of pair, at most depth, best effective price first.
+     * Throws std::out_of_range if there are no books for pair. */
+    std::vector<venue_quotation_t> bids(const currency_pair_t& pair,
+                                        std::size_t depth = 1) const;
+    std::vector<venue_quotation_t> asks(const currency_pair_t& pair,
+                                        std::size_t depth = 1) const;
+
+    /* Splits parent across the venues, consuming the levels with the best
+     * effective price first. A limit parent uses only the levels with an
+     * effective price not worse than parent.price.
+     *
+     * Every child order is a limit order on the venue pair, with the price
+     * of the worst level used on that venue. A venue whose share would be
+     * below its minimum volume is skipped and its share is taken from the
+     * next best levels of the other venues. The sum of the children
+     * volumes is less than parent.volume only if the book is not deep
+     * enough. */
+    std::vector<child_order_t> route(const order_t& parent) const;
+
+    /* Places the child orders on their venues, in a single
+     * Market::place(std::vector<order_t>&) per venue. Returns the outcome
+     * of every child, in the same order: nullptr if it has been placed,
+     * the exception thrown otherwise (std::out_of_range for an unknown
+     * venue) */
+    std::vector<std::exception_ptr> place(
+        std::vector<child_order_t>& children);
+};
+
+}  // end namespace at
+
+#endif  // AT_CONSOLIDATEDBOOK_H_
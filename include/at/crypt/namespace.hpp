@@ -22,6 +22,8 @@
 namespace at::crypt {
 
 std::vector<unsigned char> sha256(const std::string& data);
+// Original Keccak-256 (as used by Ethereum and Monero), not SHA3-256
+std::vector<unsigned char> keccak256(const std::string& data);
 std::vector<unsigned char> base64_decode(const std::string& data);
 std::string base64_encode(const std::vector<unsigned char>& data);
 std::vector<unsigned char> hmac_sha512(const std::vector<unsigned char>& data,
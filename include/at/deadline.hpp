@@ -0,0 +1,59 @@
+/* Copyright 2017 Paolo Galeone <nessuno@nerdz.eu>. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.*/
+
+#ifndef AT_DEADLINE_H_
+#define AT_DEADLINE_H_
+
+#include <chrono>
+
+namespace at {
+
+/* Deadline of the API calls of the calling thread, for the lifetime of
+ * the instance, e.g.
+ *
+ *  {
+ *      at::Deadline deadline(std::chrono::milliseconds(200));
+ *      auto book = market.orderBook(pair);  // at most 200 ms
+ *  }
+ *
+ * Every Request performed in the scope, by any Market or Exchange method,
+ * is bounded by the time left and throws a deadline_exceeded once it is
+ * over: the retries stop and no request is sent after the deadline.
+ *
+ * Deadlines nest: an inner deadline can't extend an outer one. */
+class Deadline {
+private:
+    std::chrono::steady_clock::time_point _previous;
+
+public:
+    explicit Deadline(std::chrono::steady_clock::time_point at);
+    explicit Deadline(std::chrono::steady_clock::duration budget)
+        : Deadline(std::chrono::steady_clock::now() + budget)
+    {
+    }
+    Deadline(const Deadline&) = delete;
+    Deadline& operator=(const Deadline&) = delete;
+    ~Deadline();
+
+    /* Whether the calling thread is in the scope of a deadline */
+    static bool active();
+
+    /* Time left before the deadline of the calling thread, negative once
+     * it is over. Without a deadline, the maximum duration */
+    static std::chrono::nanoseconds remaining();
+};
+
+}  // end namespace at
+
+#endif  // AT_DEADLINE_H_
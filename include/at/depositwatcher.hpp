@@ -0,0 +1,147 @@
+/* Copyright 2017 Paolo Galeone <nessuno@nerdz.eu>. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.*/
+
+#ifndef AT_DEPOSITWATCHER_H_
+#define AT_DEPOSITWATCHER_H_
+
+#include <at/exchange.hpp>
+#include <at/types.hpp>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace at {
+
+// Change of status of a watched deposit address
+typedef struct {
+    hash_t address;
+    deposit_status_t previous, current;
+    uint32_t seconds_remaining;  // valid only if current == no_deposists
+} deposit_event_t;
+
+// Polling intervals of a DepositWatcher
+typedef struct {
+    // wheel resolution: every interval is rounded to a multiple of tick
+    std::chrono::milliseconds tick = std::chrono::seconds(1);
+    // interval of the addresses with a deposit in progress and lower bound
+    // of the interval of the addresses waiting for a deposit
+    std::chrono::milliseconds min = std::chrono::seconds(2);
+    // upper bound of the interval of the addresses waiting for a deposit
+    std::chrono::milliseconds max = std::chrono::seconds(60);
+    // interval of the settled addresses
+    std::chrono::milliseconds settled = std::chrono::minutes(5);
+} deposit_watcher_intervals_t;
+
+/* Watches a set of deposit addresses, polling their status on an Exchange
+ * and notifying every status change.
+ *
+ * The polls are scheduled on a timing wheel with adaptive intervals:
+ * an address waiting for a deposit is polled more frequently as its
+ * expiration time approaches, an address with a deposit in progress is
+ * polled every intervals.min and a settled address every
+ * intervals.settled. Once an address reaches a final status
+ * (complete, failed or expired) it is no more watched.
+ *
+ * The requests are executed by a fixed pool of worker threads, hence the
+ * number of concurrent requests to the exchange is bounded.
+ * An address is polled again only after the callback of its last change
+ * returns: the events of an address are delivered in order and never
+ * concurrently, while the events of different addresses can be.
+ * An exception thrown by the callback is ignored.
+ * A failed poll doubles the interval of the address, up to intervals.max
+ * or the interval of its status if longer.
+ *
+ * The exchange is used only through the Exchange interface
+ * (depositStatus and timeRemeaningForTransaction), thus any
+ * implementation of the interface can be used as a mock. */
+class DepositWatcher {
+private:
+    typedef struct {
+        deposit_status_t status;
+        uint32_t seconds_remaining;
+        std::chrono::milliseconds interval;
+        uint64_t generation;  // changes on every (re)watch
+        bool busy;  // polling or delivering an event
+    } watched_t;
+
+    typedef struct {
+        hash_t address;
+        uint64_t rounds;
+        uint64_t generation;
+    } wheel_entry_t;
+
+    Exchange& _exchange;
+    const std::function<void(const deposit_event_t&)> _callback;
+    const deposit_watcher_intervals_t _intervals;
+
+    std::mutex _mux;
+    std::condition_variable _cv;
+    bool _stop = false;
+    uint64_t _generation = 0;
+    std::unordered_map<hash_t, watched_t> _watched;
+
+    // timing wheel, advanced by _timer every _intervals.tick
+    std::vector<std::vector<wheel_entry_t>> _wheel;
+    std::size_t _cursor = 0;
+
+    // addresses ready to be polled by the _workers
+    std::deque<std::pair<hash_t, uint64_t>> _ready;
+
+    std::thread _timer;
+    std::vector<std::thread> _workers;
+
+    // Inserts address in the wheel, to be polled after delay.
+    // Requires _mux
+    void _schedule(const hash_t& address, uint64_t generation,
+                   std::chrono::milliseconds delay);
+
+    // Returns the polling interval for the status
+    std::chrono::milliseconds _interval(deposit_status_t status,
+                                        uint32_t seconds_remaining) const;
+
+    void _timer_loop();
+    void _worker_loop();
+
+public:
+    /* Creates a watcher that polls exchange with workers concurrent
+     * requests and calls callback (from a worker thread) on every status
+     * change. */
+    DepositWatcher(Exchange& exchange,
+                   std::function<void(const deposit_event_t&)> callback,
+                   std::size_t workers = 4,
+                   deposit_watcher_intervals_t intervals = {});
+    DepositWatcher(const DepositWatcher&) = delete;
+    DepositWatcher& operator=(const DepositWatcher&) = delete;
+    ~DepositWatcher();
+
+    /* Starts watching address. The first poll is executed immediately. */
+    void watch(const hash_t& address);
+    void watch(const std::vector<hash_t>& addresses);
+
+    /* Stops watching address */
+    void unwatch(const hash_t& address);
+
+    /* Number of watched addresses */
+    std::size_t size();
+};
+
+}  // end namespace at
+
+#endif  // AT_DEPOSITWATCHER_H_
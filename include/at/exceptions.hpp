@@ -26,6 +26,33 @@ public:
     server_error(std::string message) : runtime_error(message) {}
 };
 
+// The request has not been sent: the host can't be resolved or
+// connected. It is always safe to perform it again
+class connection_error : public server_error {
+public:
+    connection_error(std::string message) : server_error(message) {}
+};
+
+// The request has not been sent: the circuit breaker of the host is open
+class circuit_open_error : public server_error {
+public:
+    circuit_open_error(std::string message) : server_error(message) {}
+};
+
+// The host refused the request because of its rate limit (HTTP 429, or
+// the rate limit error of an API): it can be performed again after a wait
+class rate_limit_error : public server_error {
+public:
+    rate_limit_error(std::string message) : server_error(message) {}
+};
+
+// The deadline of the call is over (see Deadline). It is not a
+// server_error: the server may be fine, the caller can't wait longer
+class deadline_exceeded : public std::runtime_error {
+public:
+    deadline_exceeded(std::string message) : runtime_error(message) {}
+};
+
 class response_error : public std::runtime_error {
 public:
     response_error(std::string message) : runtime_error(message) {}
@@ -33,28 +60,27 @@ public:
 
 // Inherit from this class to use the method _throw_error_if_any
 // in order to throw a response_error if the json response contains
-// the "error" key
+// the "error" key. The errors thrown are counted in Metrics, on the host
+// of the last request of the thread
 class Thrower {
 protected:
-    static void _throw_error_if_any(const json& res)
+    // Returns the message of the "error" key, empty if there is no error
+    static std::string _error_message(const json& res)
     {
         const auto e = res.find("error");
         if (e != res.end()) {
             auto val = *e;
             if (val.is_string()) {
-                auto message = val.get<std::string>();
-                if (!message.empty()) {
-                    throw response_error(message);
-                }
+                return val.get<std::string>();
             }
             else if (val.is_array() && val.size() > 0) {
-                auto message = val[0].get<std::string>();
-                if (!message.empty()) {
-                    throw response_error(message);
-                }
+                return val[0].get<std::string>();
             }
         }
+        return "";
     }
+
+    static void _throw_error_if_any(const json& res);
 };
 
 }  // end namespace at
@@ -28,6 +28,12 @@ class Exchange {
 public:
     virtual ~Exchange() {}
 
+    /* Resolves, connects and completes the TLS handshake with the servers
+     * of the exchange ahead of the first call. Call it from the thread
+     * that will use the exchange: the connections are kept by the thread
+     * that warmed them up. Does nothing by default */
+    virtual void warmup() {}
+
     // Pure virtual methods
 
     /* Gets the current rate offered by the exchange for the
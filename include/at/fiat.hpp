@@ -19,16 +19,46 @@
 #include <at/market.hpp>
 #include <at/types.hpp>
 #include <chrono>
+#include <cstdint>
+#include <condition_variable>
 #include <ctime>
 #include <iomanip>
+#include <memory>
+#include <mutex>
 #include <rapidxml.hpp>
+#include <thread>
+#include <vector>
 
 namespace at {
 
+// Small integer that identifies a currency in a fiat_rates_t
+typedef uint16_t fiat_id_t;
+
+// Exchange rates published by the ECB for a certain day.
+// A published fiat_rates_t is never modified: a refresh creates a new one.
+typedef struct {
+    std::time_t date;  // day of the reference rates, 00:00 UTC
+    std::map<std::string, double> eur_to_currency;
+
+    // Dense cross-rate matrix. Given N = currencies.size():
+    // cross[to * N + from] = amount of `to` for 1 unit of `from`.
+    // The ids of the currencies are kept across refreshes, a currency no
+    // more published has NaN rates.
+    std::vector<std::string> currencies;  // fiat_id_t -> currency
+    std::map<std::string, fiat_id_t> ids;  // currency -> fiat_id_t
+    std::vector<double> cross;
+} fiat_rates_t;
+
 /* Client for the daily fiat exchange rates at
  * https://www.ecb.europa.eu
  *
- * Every method can throw a response_error or a server_error.
+ * The rates are fetched once by the constructor and then refreshed by a
+ * background thread every working day after the ECB publication time
+ * (14:15 Frankfurt time, CET or CEST). Every refresh publishes a new immutable fiat_rates_t,
+ * thus rate() never parses or fetches anything and it can be called
+ * concurrently from any number of threads.
+ *
+ * The constructor can throw a response_error or a server_error.
  * A response_error is when the API handles the request but for some
  * reason an error occuurs.
  *
@@ -36,19 +66,73 @@ namespace at {
  * */
 class Fiat : private Thrower {
 private:
-    const std::string _host = "https://www.ecb.europa.eu/";
-    std::time_t _current_date = std::time(0);
-    std::map<std::string, double> _eur_to_currency_rate;
+    const std::string _host;
+
+    // Current snapshot. Always accessed with std::atomic_load/atomic_store
+    std::shared_ptr<const fiat_rates_t> _rates;
+
+    std::thread _refresher;
+    std::mutex _mux;
+    std::condition_variable _cv;
+    bool _stop = false;
+
+    // _fetch downloads and parses the daily XML
+    std::shared_ptr<const fiat_rates_t> _fetch() const;
+
+    // _refresh_loop is the body of _refresher: it sleeps until the next
+    // publication time and publishes the new rates
+    void _refresh_loop();
 
-    // _update fetch and updates the XML with the update time and the
-    // exhange rates
-    void _update();
+    // Returns the first ECB publication time after now
+    static std::time_t _next_publication(std::time_t now);
+
+    // The tests check the scheduling without waiting for it
+    friend class FiatTest;
 
 public:
-    Fiat() { _update(); }
-    ~Fiat() {}
+    /* host can replace the ECB website, e.g. with a local mock server */
+    explicit Fiat(std::string host = "https://www.ecb.europa.eu/");
+    ~Fiat();
+
+    /* Resolves, connects and completes the TLS handshake with the ECB
+     * website ahead of the next update() of the calling thread; the
+     * refresher reuses the resolved address and the TLS session */
+    void warmup();
+
+    /* Parses the content of eurofxref-daily.xml and builds the cross-rate
+     * matrix. If previous is not null, the currency ids of previous are
+     * kept. */
+    static fiat_rates_t parse(const std::string& xml,
+                              const fiat_rates_t* previous = nullptr);
+
+    /* Returns the current snapshot of the rates. The snapshot stays valid
+     * while the returned pointer is alive, even if a refresh happens. */
+    std::shared_ptr<const fiat_rates_t> snapshot() const;
+
+    /* Fetches the rates now and publishes them, without waiting for the
+     * next scheduled refresh. */
+    void update();
+
+    /* Returns the exchange rate of the fiat pair.
+     * Throws std::out_of_range if a currency is not in the snapshot. */
+    double rate(const currency_pair_t&) const;
+
+    /* Returns the id of the currency, stable across refreshes.
+     * Throws std::out_of_range if the currency is unknown. */
+    fiat_id_t id(std::string currency) const;
+
+    /* Same as rate(currency_pair_t(base, quote)), without any lookup.
+     * Throws std::out_of_range if an id is unknown. */
+    double rate(fiat_id_t base, fiat_id_t quote) const;
 
-    double rate(const currency_pair_t&);
+    /* Converts n amounts, where amounts[i] is in the currency from[i], in
+     * the currency to, writing the results in out.
+     * Every conversion of the batch uses the same snapshot. */
+    void convert(const double* amounts, const fiat_id_t* from, std::size_t n,
+                 fiat_id_t to, double* out) const;
+    std::vector<double> convert(const std::vector<double>& amounts,
+                                const std::vector<fiat_id_t>& from,
+                                fiat_id_t to) const;
 };
 
 }  // end namespace at
@@ -0,0 +1,94 @@
+/* Copyright 2017 Paolo Galeone <nessuno@nerdz.eu>. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.*/
+
+#ifndef AT_FIATHISTORY_H_
+#define AT_FIATHISTORY_H_
+
+#include <at/exceptions.hpp>
+#include <at/request.hpp>
+#include <at/types.hpp>
+#include <cstdint>
+#include <ctime>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace at {
+
+/* Historical fiat exchange rates published by the ECB
+ * (https://www.ecb.europa.eu/stats/eurofxref/eurofxref-hist.xml and
+ * eurofxref-hist-90d.xml).
+ *
+ * The XML is parsed once and stored in a columnar file, that's
+ * memory mapped by the constructor:
+ *
+ *  header     "ATFX", version, #currencies, #days          (uint32_t each)
+ *  currencies #currencies * char[4], padded to 8 bytes
+ *  dates      #days * int64_t, days at 00:00 UTC, ascending
+ *  rates      #currencies columns of #days double: EUR to currency rate,
+ *             NaN if the rate has not been published in that day
+ *
+ * download() and write() can throw a response_error or a server_error,
+ * like any other client. */
+class FiatHistory {
+private:
+    static constexpr uint32_t _version = 1;
+
+    int _fd = -1;
+    void* _data = nullptr;
+    std::size_t _size = 0;
+
+    uint32_t _days = 0;
+    const int64_t* _dates = nullptr;
+    const double* _rates = nullptr;
+    std::map<std::string, std::size_t> _currency_column;
+
+    // Returns the EUR to currency rate in the last day <= date
+    double _eur_to(const std::string& currency, std::time_t date) const;
+
+public:
+    /* Memory maps the history file at path, written by download() or
+     * write(). */
+    explicit FiatHistory(const std::string& path);
+    FiatHistory(const FiatHistory&) = delete;
+    FiatHistory& operator=(const FiatHistory&) = delete;
+    ~FiatHistory();
+
+    /* Downloads the history of the last 90 days, or the full history if
+     * full is true, and writes it in path.
+     * host can replace the ECB website, e.g. with a local mock server */
+    static void download(
+        const std::string& path, bool full = false,
+        const std::string& host = "https://www.ecb.europa.eu/");
+
+    /* Parses the content of an ECB history XML and writes it in path */
+    static void write(const std::string& path, const std::string& xml);
+
+    /* Returns the exchange rate of the fiat pair at the specified date.
+     * The ECB publishes the rates only in the working days, hence the rate
+     * is the one of the last day published before or at date.
+     * Throws std::out_of_range if there is no rate for the pair at date. */
+    double rate(const currency_pair_t&, std::time_t date) const;
+
+    // First and last day of the history
+    std::time_t begin() const;
+    std::time_t end() const;
+
+    // Currencies present in the history
+    std::vector<std::string> currencies() const;
+};
+
+}  // end namespace at
+
+#endif  // AT_FIATHISTORY_H_
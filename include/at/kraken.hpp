@@ -25,6 +25,7 @@
 #include <iomanip>
 #include <limits>
 #include <mutex>
+#include <set>
 #include <sstream>
 
 namespace at {
@@ -50,6 +51,8 @@ private:
     std::vector<std::string> _available_symbols;
     std::mutex _mux;
     unsigned long long int _request_counter = 0;
+    // body of the private requests, reused under _mux
+    FormBody _body;
 
     const std::map<std::string, double> _minimumLimits = {
         // https://support.kraken.com/hc/en-us/articles/205893708-What-is-the-minimum-order-size-
@@ -134,33 +137,18 @@ private:
     json _request(std::string method,
                   std::vector<std::pair<std::string, std::string>> params);
 
-    static void _throw_error_if_any(const json& res)
-    {
-        try {
-            Thrower::_throw_error_if_any(res);
-        }
-        catch (const response_error& e) {
-            // Kraken is shit and even when status code should be 500
-            // it might return a status code 200 with a json error
-            // If the error is present thrower::_throw_err_if_any
-            // will throw a response error, even if the request failed
-            // not because of the malformed url request but because the
-            // server is busy, or unavailable.
-            //
-            // In this case a server error must be thrown, not a response error
-            auto message = std::string(e.what());
-            auto found = message.find("EService:Unavailable");
-            if (found != std::string::npos) {
-                throw server_error(message);
-            }
-            found = message.find("Service:Busy");
-            if (found != std::string::npos) {
-                throw server_error(message);
-            }
-
-            throw e;
-        }
-    }
+    // Authenticated post request, with a JSON body (batch methods). It is
+    // never retried once sent
+    json _json_request(const std::string& method, json body);
+
+    // Sanitizes order.pair and returns the AddOrder parameters of order,
+    // pair first. Throws a std::runtime_error if order is invalid
+    std::vector<std::pair<std::string, std::string>> _order_params(
+        order_t& order);
+
+    // Like Thrower::_throw_error_if_any, but the errors of a busy or
+    // unavailable service are thrown as server_error
+    static void _throw_error_if_any(const json& res);
 
 public:
     Kraken() {}
@@ -168,8 +156,19 @@ public:
         : _api_key(api_key), _api_secret(api_secret)
     {
     }
+    // host replaces https://api.kraken.com/ (e.g. a local mock server)
+    Kraken(std::string api_key, std::string api_secret, std::string host)
+        : _host(host + _version + "/"),
+          _api_key(api_key),
+          _api_secret(api_secret)
+    {
+    }
     ~Kraken() {}
 
+    /* Resolves, connects and completes the TLS handshake with the API
+     * server ahead of the first call (see Market::warmup) */
+    void warmup() override;
+
     /* Get server time
      * URL: https://api.kraken.com/0/public/Time
      *
@@ -207,6 +206,11 @@ public:
     /* This get the order book for the specicified pair */
     std::vector<ticker_t> orderBook(currency_pair_t) override;
 
+    /* Builds the order book from the book of a pair in a Depth response
+     * ({"asks": [...], "bids": [...]}). Asks and bids are paired by
+     * level: the levels beyond the shorter side are dropped */
+    static std::vector<ticker_t> parseOrderBook(const json& book);
+
     /* This get the complete closed orders */
     std::vector<order_t> closedOrders() override;
 
@@ -219,6 +223,22 @@ public:
 
     /* This cancel the specified order idientified by order.txid */
     void cancel(order_t&) override;
+
+    /* Places the orders of the same pair together, up to 15 per request
+     * (AddOrderBatch). An order alone in its pair is placed with AddOrder.
+     * If a request fails, its error is the outcome of all its orders */
+    std::vector<std::exception_ptr> place(std::vector<order_t>&) override;
+
+    /* Cancels up to 50 orders per request (CancelOrderBatch). Kraken
+     * reports only the number of canceled orders: if some orders of a
+     * request are not canceled, the ones still open (OpenOrders) keep
+     * their txid and get a response_error, the others are reset. If
+     * OpenOrders fails, every order of the request keeps its txid and gets
+     * a "cancel outcome unknown" response_error */
+    std::vector<std::exception_ptr> cancel(std::vector<order_t>&) override;
+
+    /* Cancels every open order with a single request (CancelAll) */
+    void cancelAll() override;
 };  // namespace at
 
 }  // end namespace at
@@ -0,0 +1,160 @@
+/* Copyright 2017 Paolo Galeone <nessuno@nerdz.eu>. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.*/
+
+#ifndef AT_LATENCY_H_
+#define AT_LATENCY_H_
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace at {
+
+// Phases of an API call
+enum class latency_phase_t : uint8_t {
+    dns,         // name lookup
+    connect,     // TCP connect
+    tls,         // TLS handshake
+    first_byte,  // request sent, server processing, first byte received
+    transfer,    // rest of the response
+    parse,       // JSON parse of the response
+    convert,     // from the parsed response to the returned types
+    total,       // whole call
+};
+
+constexpr std::size_t latency_phases = 8;
+
+inline std::ostream& operator<<(std::ostream& o, const latency_phase_t& p)
+{
+    switch (p) {
+        case latency_phase_t::dns:
+            return o << "dns";
+        case latency_phase_t::connect:
+            return o << "connect";
+        case latency_phase_t::tls:
+            return o << "tls";
+        case latency_phase_t::first_byte:
+            return o << "first_byte";
+        case latency_phase_t::transfer:
+            return o << "transfer";
+        case latency_phase_t::parse:
+            return o << "parse";
+        case latency_phase_t::convert:
+            return o << "convert";
+        case latency_phase_t::total:
+            return o << "total";
+    }
+    return o;
+}
+
+typedef struct {
+    uint64_t count;
+    std::chrono::nanoseconds min, max, mean;
+    std::chrono::nanoseconds sum;  // exact, mean is truncated
+    std::chrono::nanoseconds p50, p90, p99, p999;
+} latency_summary_t;
+
+/* Histogram of durations with a relative error of at most 1/16: every
+ * power of two range of nanoseconds is split in 16 linear buckets, up to
+ * ~68 seconds (larger values are counted in the last bucket).
+ *
+ * record is lock-free: every thread updates one of few shards of
+ * relaxed atomic counters, merged by summary. */
+class LatencyHistogram {
+public:
+    static constexpr std::size_t sub_buckets = 16;
+    static constexpr std::size_t max_exponent = 36;
+    static constexpr std::size_t buckets =
+        sub_buckets * (max_exponent - 3);  // up to 2^36 ns
+
+private:
+    static constexpr std::size_t _shards = 4;
+
+    typedef struct {
+        std::array<std::atomic<uint64_t>, buckets> counts;
+        std::atomic<uint64_t> count, sum, min, max;
+    } shard_t;
+
+    std::unique_ptr<shard_t[]> _shard;
+
+    static std::size_t _bucket(uint64_t ns);
+    static uint64_t _lower(std::size_t bucket);
+
+public:
+    LatencyHistogram();
+
+    void record(std::chrono::nanoseconds duration);
+    latency_summary_t summary() const;
+
+    /* Value below which fraction of the durations are, 0 <= fraction <= 1 */
+    std::chrono::nanoseconds percentile(double fraction) const;
+
+    void reset();
+};
+
+/* Per-endpoint latency histograms of the API calls, filled by Request.
+ *
+ * An endpoint is the method, host and path of a request (the query string
+ * is dropped), e.g. "GET api.kraken.com/0/public/Ticker", or the one
+ * named by the client with Request::endpoint. The phases from
+ * dns to transfer come from the transfer timings of curl, parse is the
+ * JSON parse of the response and convert the time from the parse to the
+ * end of the Request, i.e. the conversion done by the client method.
+ *
+ * At most max_endpoints endpoints are tracked, the calls to the others
+ * are recorded under "other". Recording is lock-free once a thread has
+ * seen an endpoint. */
+class Latency {
+public:
+    static constexpr std::size_t max_endpoints = 256;
+
+    typedef struct {
+        std::array<LatencyHistogram, latency_phases> phases;
+    } endpoint_t;
+
+    /* Returns the histograms of endpoint, created if needed. The pointer
+     * stays valid for the lifetime of the process. */
+    static endpoint_t* endpoint(const std::string& name);
+
+    static void record(endpoint_t* endpoint, latency_phase_t phase,
+                       std::chrono::nanoseconds duration)
+    {
+        endpoint->phases[static_cast<std::size_t>(phase)].record(duration);
+    }
+
+    /* Endpoints called so far */
+    static std::vector<std::string> endpoints();
+
+    /* Summary of phase for endpoint. Throws std::out_of_range if the
+     * endpoint has never been called. */
+    static latency_summary_t summary(const std::string& endpoint,
+                                     latency_phase_t phase);
+
+    /* Clears every histogram */
+    static void reset();
+
+    /* Writes a table of the summaries of every endpoint and phase */
+    static void dump(std::ostream& out);
+};
+
+}  // end namespace at
+
+#endif  // AT_LATENCY_H_
@@ -17,6 +17,7 @@
 
 #include <at/request.hpp>
 #include <at/types.hpp>
+#include <exception>
 #include <map>
 #include <nlohmann/json.hpp>
 #include <string>
@@ -29,6 +30,12 @@ public:
     // Only common methods in markets
     virtual ~Market() {}
 
+    /* Resolves, connects and completes the TLS handshake with the servers
+     * of the market ahead of the first call. Call it from the thread that
+     * will use the market: the connections are kept by the thread that
+     * warmed them up. Does nothing by default */
+    virtual void warmup() {}
+
     // Pure virtual methods
     virtual deposit_info_t depositInfo(std::string currency) = 0;
     virtual std::vector<market_info_t> info() = 0;
@@ -42,6 +49,22 @@ public:
     virtual std::vector<order_t> closedOrders() = 0;
     virtual void place(order_t&) = 0;
     virtual void cancel(order_t&) = 0;
+
+    /* Places every order, as place(order_t&). Returns the outcome of every
+     * order, in the same order: nullptr if it has been placed, the
+     * exception thrown otherwise. By default the orders are placed one
+     * at a time */
+    virtual std::vector<std::exception_ptr> place(std::vector<order_t>&);
+
+    /* Cancels every order, as cancel(order_t&). Returns the outcome of
+     * every order, as place. By default the orders are canceled one at a
+     * time */
+    virtual std::vector<std::exception_ptr> cancel(std::vector<order_t>&);
+
+    /* Cancels every open order. By default cancels the openOrders one at
+     * a time and throws the first error, once every order has been
+     * tried */
+    virtual void cancelAll();
 };
 
 }  // end namespace at
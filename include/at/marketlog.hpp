@@ -0,0 +1,199 @@
+/* Copyright 2017 Paolo Galeone <nessuno@nerdz.eu>. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.*/
+
+#ifndef AT_MARKETLOG_H_
+#define AT_MARKETLOG_H_
+
+#include <at/types.hpp>
+#include <cstdint>
+#include <ctime>
+#include <fstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace at {
+
+enum class market_event_type_t : uint8_t {
+    bid = 2,   // ticker: best bid
+    ask,       // ticker: best ask
+    book,      // begin of an order book snapshot: amount = number of levels
+    book_bid,  // level of the last order book snapshot
+    book_ask,
+    buy,  // trade: the taker was the buyer
+    sell,
+};
+
+// Event read from a market log.
+// pair is the id of the pair in the log: MarketLog::pair(id) returns the
+// currency pair
+typedef struct {
+    market_event_type_t type;
+    uint16_t pair;
+    std::time_t time;
+    double price, amount;
+} market_event_t;
+
+/* Market data log.
+ *
+ * The log is a header followed by fixed size records of 24 bytes:
+ *
+ *  header  "ATML", version (uint32_t), tick (double), block (uint32_t)
+ *  record  type (uint8_t), pair id (uint16_t), time (uint32_t),
+ *          price (int64_t), amount (double)
+ *
+ * The records are grouped in blocks of block records. Every block starts
+ * with a sync record, containing the absolute time of the block, followed
+ * by the definitions (id -> name) of every pair known. In the other
+ * records the time is relative to the time of the block and the price
+ * is in ticks.
+ *
+ * The price is not delta encoded: the amount keeps the record at 24
+ * bytes anyway, so a narrower delta would only be padding. An absolute
+ * price makes every record decodable on its own.
+ *
+ * Since the blocks have the same size, the sync records are an index of
+ * the log: a seek by time is a binary search on them. */
+typedef struct {
+    char magic[4];
+    uint32_t version;
+    double tick;
+    uint32_t block;
+    uint32_t reserved;
+} market_log_header_t;
+
+typedef struct {
+    uint8_t type;
+    uint8_t reserved;
+    uint16_t pair;
+    uint32_t time;
+    int64_t price;
+    double amount;
+} market_log_record_t;
+
+/* Memory mapped reader of a log written by a MarketRecorder.
+ * The reader sees the records written (and flushed) before its
+ * construction. */
+class MarketLog {
+private:
+    friend class MarketRecorder;
+
+    int _fd = -1;
+    void* _data = nullptr;
+    std::size_t _size = 0;
+
+    const market_log_header_t* _header = nullptr;
+    const market_log_record_t* _records = nullptr;
+    std::size_t _count = 0;     // number of records
+    std::size_t _position = 0;  // next record to read
+
+    // decoding state
+    std::time_t _base = 0;
+    std::vector<currency_pair_t> _pairs;
+
+    // event read by seek and not returned yet
+    bool _peeked = false;
+    market_event_t _peek;
+
+    // Decodes the record at _position, returns true if it is an event
+    bool _decode(market_event_t& event);
+
+public:
+    explicit MarketLog(const std::string& path);
+    MarketLog(const MarketLog&) = delete;
+    MarketLog& operator=(const MarketLog&) = delete;
+    ~MarketLog();
+
+    /* Reads the next event. Returns false at the end of the log. */
+    bool next(market_event_t& event);
+
+    /* Moves the reader to the first event with time >= time */
+    void seek(std::time_t time);
+
+    /* Moves the reader to the beginning of the log */
+    void rewind();
+
+    /* Returns the pair with the specified id.
+     * Throws std::out_of_range if the pair has not been defined by the
+     * records read so far. */
+    const currency_pair_t& pair(uint16_t id) const;
+
+    /* Price resolution of the log */
+    double tick() const { return _header->tick; }
+
+    /* Number of records (events, sync and pair definitions) */
+    std::size_t size() const { return _count; }
+};
+
+/* Records tickers, order books and trades in an append-only market log
+ * (see MarketLog for the format).
+ *
+ * If the log exists, the new records are appended to it: the tick and
+ * the block size are the ones of the existing log.
+ *
+ * Records are buffered and written when the buffer is full, when flush()
+ * is called and by the destructor. Times must be non decreasing: an event
+ * older than the previous one is recorded with the time of the previous
+ * one.
+ *
+ * This class is not thread safe. */
+class MarketRecorder {
+private:
+    static const std::size_t _buffer_size = 1024;
+
+    std::ofstream _out;
+    double _tick;
+    uint32_t _block;
+    std::size_t _count = 0;  // records written, including the buffer
+    std::vector<market_log_record_t> _buffer;
+
+    std::time_t _base = 0, _time = 0;
+    std::vector<std::string> _pairs;
+    std::unordered_map<std::string, uint16_t> _ids;
+
+    uint16_t _pair(const currency_pair_t& pair);
+    void _append(const market_log_record_t& record);
+
+    // Appends an event record, starting a new block if needed
+    void _event(market_event_type_t type, uint16_t pair, std::time_t time,
+                double price, double amount);
+
+public:
+    /* Opens (or creates) the log at path. tick is the price resolution
+     * and block the number of records per block. */
+    explicit MarketRecorder(const std::string& path, double tick = 1e-8,
+                            uint32_t block = 4096);
+    MarketRecorder(const MarketRecorder&) = delete;
+    MarketRecorder& operator=(const MarketRecorder&) = delete;
+    ~MarketRecorder();
+
+    /* Records the best bid and ask, with the time of the quotations */
+    void ticker(const currency_pair_t& pair, const ticker_t& ticker);
+
+    /* Records a snapshot of the order book, as returned by
+     * Market::orderBook, taken at time */
+    void orderBook(const currency_pair_t& pair,
+                   const std::vector<ticker_t>& book, std::time_t time);
+
+    /* Records a trade of trade.amount at trade.price */
+    void trade(const currency_pair_t& pair, order_action_t taker,
+               const quotation_t& trade);
+
+    /* Writes the buffered records */
+    void flush();
+};
+
+}  // end namespace at
+
+#endif  // AT_MARKETLOG_H_
@@ -0,0 +1,132 @@
+/* Copyright 2017 Paolo Galeone <nessuno@nerdz.eu>. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.*/
+
+#ifndef AT_METRICS_H_
+#define AT_METRICS_H_
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace at {
+
+// Per-host counters of the API calls
+enum class metric_t : uint8_t {
+    requests,          // requests performed
+    server_errors,     // server_error thrown
+    response_errors,   // response_error thrown
+    retries,           // requests performed again after a failure
+    rate_limit_waits,  // waits imposed by a rate limit
+    bytes_in,          // bytes of the response bodies
+    bytes_out,         // bytes of the request bodies
+    in_flight,         // requests in progress (gauge)
+    deadlines,         // deadline_exceeded thrown
+};
+
+constexpr std::size_t metrics = 9;
+
+/* Registry of the per-host counters of the API calls.
+ *
+ * Request counts requests, bytes, in flight requests, server errors and
+ * exceeded deadlines of the host of every request; the clients and
+ * RetryPolicy count the response errors, retries and rate limit waits
+ * on the host of the last request of the thread (see current).
+ *
+ * At most max_hosts hosts are tracked, the others are counted under
+ * "other". Counting is lock-free once a thread has seen a host. */
+class Metrics {
+public:
+    static constexpr std::size_t max_hosts = 64;
+
+    typedef struct {
+        std::array<std::atomic<int64_t>, metrics> values;
+    } host_t;
+
+    /* Returns the counters of host, created if needed. The pointer stays
+     * valid for the lifetime of the process. */
+    static host_t* host(const std::string& name);
+
+    static void add(host_t* host, metric_t metric, int64_t value = 1)
+    {
+        host->values[static_cast<std::size_t>(metric)].fetch_add(
+            value, std::memory_order_relaxed);
+    }
+
+    /* Host of the last request performed by the calling thread, nullptr
+     * if the thread has not performed any */
+    static host_t* current();
+    static void current(host_t* host);
+
+    /* Adds value to metric of the current host, if any */
+    static void add(metric_t metric, int64_t value = 1)
+    {
+        if (auto host = current()) {
+            add(host, metric, value);
+        }
+    }
+
+    /* Hosts seen so far */
+    static std::vector<std::string> hosts();
+
+    /* Value of metric for host. Throws std::out_of_range if the host has
+     * never been seen. */
+    static int64_t value(const std::string& host, metric_t metric);
+
+    /* Zeroes every counter, but the in flight requests */
+    static void reset();
+
+    /* Writes the counters and the latency summaries of the total phase
+     * of every endpoint (see Latency) in the Prometheus text format */
+    static void exposition(std::ostream& out);
+
+    /* Writes the exposition to path, atomically: the file is written
+     * aside and renamed, thus it can be scraped at any time (e.g. by the
+     * node_exporter textfile collector) */
+    static void dump(const std::string& path);
+};
+
+/* Minimal HTTP server of the exposition: GET /metrics returns
+ * Metrics::exposition, any other request a 404.
+ *
+ * The requests are served one at a time by a background thread, started
+ * by the constructor and stopped by the destructor. The default port 0
+ * picks a free port. Throws a std::runtime_error if the server can't
+ * listen on address:port. */
+class MetricsServer {
+private:
+    int _fd = -1;
+    uint16_t _port = 0;
+    std::atomic<bool> _stop{false};
+    std::thread _thread;
+
+    void _serve();
+    void _handle(int client);
+
+public:
+    explicit MetricsServer(uint16_t port = 0,
+                           const std::string& address = "127.0.0.1");
+    MetricsServer(const MetricsServer&) = delete;
+    MetricsServer& operator=(const MetricsServer&) = delete;
+    ~MetricsServer();
+
+    uint16_t port() const { return _port; }
+};
+
+}  // end namespace at
+
+#endif  // AT_METRICS_H_
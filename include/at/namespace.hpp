@@ -15,26 +15,39 @@
 #ifndef AT_NAMESPACE_H_
 #define AT_NAMESPACE_H_
 
+#include <at/address.hpp>
 #include <at/request.hpp>
 
 namespace at {
 
-// check if the address is OK for the specificed currency
-inline bool isValidAddress(std::string symbol, hash_t address)
+// check if the address is OK for the specificed currency.
+// The addresses of the currencies supported by at::address are validated
+// offline, the other ones are validated by shapeshift.
+// host replaces https://shapeshift.io/ (e.g. a local mock server).
+// Throws a server_error if the remote validation can't be done.
+inline bool isValidAddress(std::string symbol, hash_t address,
+                           std::string host = "https://shapeshift.io/")
 {
+    if (address::isSupported(symbol)) {
+        return address::isValid(symbol, address);
+    }
+
     std::ostringstream stream;
-    stream << "https://shapeshift.io/validateAddress/" << address << "/"
-           << symbol;
+    stream << host << "validateAddress/" << address << "/" << symbol;
 
     Request req;
+    req.endpoint(host + "validateAddress/");
+    json result;
     try {
-        json result = req.get(stream.str());
-        return result["isvalid"];  // shapeshift API doc claim is "isValid", but
-                                   // is "isvalid"
+        result = req.get(stream.str());
     }
-    catch (std::runtime_error& e) {
-        return false;
+    catch (const json::parse_error& e) {
+        throw server_error(std::string("validateAddress: ") + e.what());
     }
+    const auto valid = result.find("isvalid");  // shapeshift API doc claim is
+                                                // "isValid", but is "isvalid"
+    return valid != result.end() && valid->is_boolean() &&
+           valid->get<bool>();
 }
 
 }  // end namespace at
@@ -0,0 +1,223 @@
+/* Copyright 2017 Paolo Galeone <nessuno@nerdz.eu>. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.*/
+
+#ifndef AT_PAPERMARKET_H_
+#define AT_PAPERMARKET_H_
+
+#include <at/exceptions.hpp>
+#include <at/market.hpp>
+#include <at/types.hpp>
+#include <cstdint>
+#include <ctime>
+#include <map>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace at {
+
+/* Simulated market, with an in-memory matching engine.
+ *
+ * The liquidity of every pair comes from order books fed with feed(), that
+ * can be recorded from a real market (e.g. the result of
+ * Kraken::orderBook) or synthetic. The orders placed on the PaperMarket
+ * are matched against the fed liquidity and against the other resting
+ * orders with price-time priority: the best price first, and at the same
+ * price the oldest order first. A trade happens at the price of the
+ * resting order.
+ *
+ * Prices are quoted in units of pair.second per unit of pair.first and
+ * order.volume is in pair.first, as in Kraken. Fees (market_info_t, in
+ * percent) are charged in pair.second: the taker fee to the incoming
+ * order and the maker fee to the resting one.
+ *
+ * The errors mimic the Kraken ones: an order that can't be placed throws
+ * a response_error ("EOrder:Insufficient funds", "EOrder:Invalid price",
+ * "EQuery:Unknown asset pair", ...).
+ *
+ * The clock of the market is virtual: the open/close time of the orders
+ * and the time of the quotations is the last value set with time().
+ *
+ * This class is not thread safe. */
+class PaperMarket : public Market {
+private:
+    struct level_t;
+
+    // Order in the book: either an order placed on the market (id > 0)
+    // or a quotation of the fed liquidity (id == 0)
+    typedef struct node_t {
+        node_t *prev, *next;  // intrusive list of the level
+        level_t* level;
+        uint64_t id;
+        int64_t price;     // ticks
+        double remaining;  // volume not executed yet
+        // order placed on the market only
+        double volume, cost, fee;
+        double reserved;  // balance locked by the order
+        double limit;     // order.price
+        std::time_t open;
+        uint32_t book;
+        order_action_t action;
+        order_type_t type;
+    } node_t;
+
+    // FIFO of the orders at the same price
+    typedef struct level_t {
+        node_t *head, *tail;
+    } level_t;
+
+    // Levels are sorted by key, the best first:
+    // asks are keyed by price, bids by -price
+    typedef std::map<int64_t, level_t> side_t;
+
+    typedef struct {
+        market_info_t info;
+        uint32_t base, quote;  // currency ids
+        side_t bids, asks;
+    } book_t;
+
+    // Fixed size allocator for the nodes: nodes are allocated in chunks
+    // and recycled through a free list, never returned to the system
+    class pool {
+    private:
+        std::vector<std::unique_ptr<node_t[]>> _chunks;
+        node_t* _free = nullptr;
+        std::size_t _used;  // nodes used of the last chunk
+
+    public:
+        static const std::size_t chunk_size = 4096;
+        pool() : _used(chunk_size) {}
+        node_t* get();
+        void put(node_t* node);
+    };
+
+    // Closed or canceled order, kept in the history
+    typedef struct {
+        uint64_t id;
+        uint32_t book;
+        tx_status_t status;
+        order_type_t type;
+        order_action_t action;
+        std::time_t open, close;
+        double volume, cost, fee, price;
+    } history_t;
+
+    const double _tick;
+    std::time_t _now;
+    uint64_t _next_id = 1;
+
+    std::vector<book_t> _books;
+    std::unordered_map<std::string, uint32_t> _book_ids;  // pair.str()
+
+    std::vector<std::string> _currencies;
+    std::unordered_map<std::string, uint32_t> _currency_ids;
+    std::vector<double> _total, _reserved;
+
+    pool _pool;
+    std::unordered_map<uint64_t, node_t*> _open;
+    std::vector<history_t> _closed;
+
+    uint32_t _currency(const std::string& symbol);
+    book_t& _book(const currency_pair_t& pair);
+    int64_t _ticks(double price) const;
+    double _price(int64_t ticks) const;
+
+    // Executes quantity of incoming against maker at maker's price,
+    // updating the balances of the orders placed on the market
+    void _trade(book_t& book, node_t* incoming, node_t* maker,
+                double quantity);
+
+    // Settles the execution of quantity at price for node (buy or sell)
+    // paying a fee of fee_percent
+    void _settle(book_t& book, node_t* node, double quantity, int64_t price,
+                 double fee_percent);
+
+    // Matches incoming against the opposite side of book, while the price
+    // crosses (limit orders) or until the book is empty (market orders)
+    void _match(book_t& book, node_t* incoming);
+
+    // Appends node to the tail of its price level
+    void _insert(book_t& book, node_t* node);
+
+    // Removes node from its level, deleting the level if empty
+    void _unlink(book_t& book, node_t* node);
+
+    // Moves a placed order in the history and releases the node
+    void _close(node_t* node, tx_status_t status);
+
+    order_t _order(const node_t* node) const;
+    order_t _order(const history_t& record) const;
+
+public:
+    /* Creates a market with the specified pairs (with their fees and
+     * limits) and initial balance.
+     * tick is the price resolution: prices are rounded to a multiple of
+     * tick. */
+    PaperMarket(const std::vector<market_info_t>& markets,
+                const std::map<std::string, double>& balance,
+                double tick = 1e-8);
+    ~PaperMarket() {}
+
+    /* Replaces the fed liquidity of pair with book, in the format returned
+     * by Market::orderBook. The new quotations are matched against the
+     * resting orders, thus the orders crossed by the new book are
+     * executed. */
+    void feed(currency_pair_t pair, const std::vector<ticker_t>& book);
+
+    /* Sets the current time of the market */
+    void time(std::time_t now) { _now = now; }
+    std::time_t time() const { return _now; }
+
+    /* Credits amount of currency to the balance */
+    void deposit(std::string currency, double amount);
+
+    deposit_info_t depositInfo(std::string currency) override;
+    std::vector<market_info_t> info() override;
+    market_info_t info(currency_pair_t) override;
+
+    /* Best bid and best ask of the pair, with the volume of the level */
+    ticker_t ticker(currency_pair_t) override;
+
+    /* Aggregated levels of the book, best first */
+    std::vector<ticker_t> orderBook(currency_pair_t) override;
+
+    std::map<std::string, coin_t> coins() override;
+
+    /* Total balance, including the amounts locked by the open orders */
+    std::map<std::string, double> balance() override;
+    double balance(std::string currency) override;
+
+    std::vector<order_t> openOrders() override;
+    std::vector<order_t> closedOrders() override;
+
+    using Market::cancel;
+    using Market::place;
+
+    /* Places the order and executes it against the book.
+     * A limit order not entirely executed is kept open; the remaining
+     * volume of a market order is canceled.
+     * The amount needed (volume*price plus the taker fee for a buy,
+     * volume for a sell) must be available, otherwise nothing is placed.
+     * Sets order.txid, order.status, order.open and the executed cost and
+     * fee. */
+    void place(order_t&) override;
+
+    /* Cancels the open order order.txid. As Kraken::cancel, resets order */
+    void cancel(order_t&) override;
+};
+
+}  // end namespace at
+
+#endif  // AT_PAPERMARKET_H_
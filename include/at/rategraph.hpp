@@ -0,0 +1,97 @@
+/* Copyright 2017 Paolo Galeone <nessuno@nerdz.eu>. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.*/
+
+#ifndef AT_RATEGRAPH_H_
+#define AT_RATEGRAPH_H_
+
+#include <at/types.hpp>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace at {
+
+// Result of a conversion over a RateGraph
+typedef struct {
+    std::vector<std::string> path;  // path[0] = from, path.back() = to
+    double input, output;
+} conversion_t;
+
+/* Conversion graph built from an Exchange::info() snapshot
+ * (e.g. Shapeshift marketinfo).
+ *
+ * The nodes are the currencies and every exchange_info_t is an edge
+ * base -> quote. Converting amount over an edge gives
+ * amount * rate - miner_fee, and the amount must be in the deposit limits
+ * of the edge.
+ *
+ * The graph is kept in memory, hence the best conversion between two
+ * currencies is computed without any request. */
+class RateGraph {
+private:
+    typedef struct {
+        uint32_t to;
+        double rate, miner_fee;
+        min_max_t limit;
+        uint32_t seen;  // epoch of the last update containing the edge
+    } edge_t;
+
+    std::vector<std::string> _currencies;
+    std::unordered_map<std::string, uint32_t> _ids;
+    // _edges[from] = edges leaving from
+    std::vector<std::vector<edge_t>> _edges;
+    // (from << 32 | to) -> position in _edges[from]
+    std::unordered_map<uint64_t, std::size_t> _edge_position;
+    uint32_t _epoch = 0;
+
+    uint32_t _id(const std::string& currency);
+
+public:
+    // Amounts kept for every currency at every hop by best
+    static constexpr std::size_t max_candidates = 4;
+
+    RateGraph() {}
+    explicit RateGraph(const std::vector<exchange_info_t>& markets)
+    {
+        update(markets);
+    }
+    ~RateGraph() {}
+
+    /* Updates the graph with a new snapshot of the markets.
+     * The edges already present are updated in place, the new ones are
+     * added and the ones not present in markets are disabled.
+     * Returns the number of edges changed. */
+    std::size_t update(const std::vector<exchange_info_t>& markets);
+
+    /* Returns the conversion of amount from -> to with the maximum output,
+     * using at most max_hops conversions and never visiting a currency
+     * twice.
+     * If there is no conversion that respects the limits, the returned
+     * path is empty and the output is 0.
+     * Every currency keeps, at every hop, the largest amount in the
+     * limits of each of its markets (up to max_candidates amounts), hence
+     * a smaller amount that's in the limits where a larger one is not is
+     * still converted. The cost grows linearly with max_hops: a hop
+     * converts at most max_candidates amounts over every market. */
+    conversion_t best(std::string from, std::string to, double amount,
+                      std::size_t max_hops = 3) const;
+
+    // Number of currencies in the graph
+    std::size_t size() const { return _currencies.size(); }
+};
+
+}  // end namespace at
+
+#endif  // AT_RATEGRAPH_H_
@@ -0,0 +1,103 @@
+/* Copyright 2017 Paolo Galeone <nessuno@nerdz.eu>. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.*/
+
+#ifndef AT_REPLAY_H_
+#define AT_REPLAY_H_
+
+#include <at/marketlog.hpp>
+#include <at/papermarket.hpp>
+#include <at/types.hpp>
+#include <cstdint>
+#include <ctime>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace at {
+
+/* Replays recorded market logs on a PaperMarket.
+ *
+ * The events of the logs are merged by time (k-way merge with a heap)
+ * and applied to the market, whose clock is moved to the time of every
+ * event:
+ *  - a ticker (bid and ask) becomes a book of one level;
+ *  - an order book snapshot, once all its levels are read, replaces the
+ *    book of the pair;
+ *  - trades don't change the market and are only notified.
+ * Events of pairs unknown to the market are skipped.
+ *
+ * After every change of the market the callback is called, with the
+ * event that completed the change: the strategy can use the market
+ * through the Market interface, as it would with a real one.
+ *
+ * The replay is deterministic: events with the same time are applied in
+ * the order of the logs passed to the constructor and, within a log, in
+ * the recording order. */
+class Replay {
+public:
+    typedef std::function<void(const market_event_t&, const currency_pair_t&)>
+        callback_t;
+
+private:
+    // state of a pair of a log
+    typedef struct {
+        // index of the pair in _books: -1 if unknown to the market,
+        // -2 if not resolved yet
+        int64_t book;
+        quotation_t bid;
+        std::vector<ticker_t> levels;  // snapshot being read
+        std::size_t expected;          // levels of the snapshot
+    } pair_state_t;
+
+    typedef struct {
+        std::unique_ptr<MarketLog> log;
+        market_event_t event;  // current event
+        std::vector<pair_state_t> pairs;
+    } source_t;
+
+    PaperMarket& _market;
+    std::vector<source_t> _sources;
+    std::vector<currency_pair_t> _books;  // pairs known by the market
+
+    // min heap of (time, source): sources with a current event
+    std::vector<std::pair<std::time_t, std::size_t>> _heap;
+
+    void _fill_heap();
+    pair_state_t& _pair(source_t& source, uint16_t id);
+
+    // Applies the event to the market. Returns the pair changed, or
+    // nullptr if the market didn't change
+    const currency_pair_t* _apply(source_t& source,
+                                  const market_event_t& event);
+
+public:
+    /* Replays the logs at paths on market */
+    Replay(PaperMarket& market, const std::vector<std::string>& paths);
+
+    /* Moves every log to the first event with time >= time */
+    void seek(std::time_t time);
+
+    /* Applies the events with time < until, calling callback on every
+     * change of the market. Returns the number of events read.
+     * The replay can be resumed calling run again. */
+    std::size_t run(
+        callback_t callback = nullptr,
+        std::time_t until = std::numeric_limits<std::time_t>::max());
+};
+
+}  // end namespace at
+
+#endif  // AT_REPLAY_H_
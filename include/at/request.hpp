@@ -17,13 +17,20 @@
 
 #include <curl/curl.h>
 
+#include <at/deadline.hpp>
+#include <at/latency.hpp>
+#include <at/metrics.hpp>
+#include <at/retry.hpp>
+#include <at/transport.hpp>
 #include <at/types.hpp>
 #include <cstring>
 #include <curlpp/Easy.hpp>
 #include <curlpp/Infos.hpp>
 #include <curlpp/Options.hpp>
 #include <curlpp/cURLpp.hpp>
+#include <functional>
 #include <iostream>
+#include <memory>
 #include <nlohmann/json.hpp>
 #include <sstream>
 #include <stdexcept>
@@ -32,12 +39,92 @@
 
 namespace at {
 
+/* Builder of an application/x-www-form-urlencoded body. Keys and values
+ * are percent-encoded as by curl_easy_escape: every byte but the
+ * unreserved ones (A-Z a-z 0-9 - . _ ~).
+ *
+ * The body is encoded once: the bytes signed by a client are the bytes
+ * sent. clear keeps the storage, thus a builder reused for every request
+ * does not reallocate. */
+class FormBody {
+private:
+    std::string _body;
+
+    // Appends data, percent-encoded
+    void _append(const std::string& data);
+
+public:
+    FormBody() {}
+    explicit FormBody(
+        const std::vector<std::pair<std::string, std::string>>& params);
+
+    /* Appends key=value, preceded by & if the body is not empty */
+    FormBody& add(const std::string& key, const std::string& value);
+
+    void clear() { _body.clear(); }
+    bool empty() const { return _body.empty(); }
+    const std::string& str() const { return _body; }
+};
+
+/* HTTP client of the API clients.
+ * The requests are performed by the process-wide transport: a
+ * CurlTransport by default, replaceable to record or replay them.
+ *
+ * Every request is counted in Metrics, on the host of the url, and its
+ * latency is recorded in Latency: a Request lives in the scope of a
+ * client method, thus the time from the parse of the response to the
+ * destruction of the Request is the conversion.
+ *
+ * The requests to a host go through its CircuitBreaker, and get and post
+ * are retried with the process-wide RetryPolicy: get is idempotent, post
+ * is not and it is retried only if the request has not been sent.
+ * Every request is bounded by the timeouts and by the Deadline of the
+ * calling thread, if any. */
 class Request {
 private:
     std::list<std::string> _headers;
     std::list<curlpp::OptionBase*> _options;
     std::string _get(std::string url);
 
+    // latency of the last request
+    Latency::endpoint_t* _endpoint = nullptr;
+    std::string _endpoint_url;
+    std::chrono::steady_clock::time_point _start, _parsed;
+    bool _is_parsed = false;
+
+    // Records the convert and total latency of the last request
+    void _finish();
+
+    // Parses body, recording its latency, and recycles its storage
+    json _parse(std::string&& body);
+
+    // breaker of the host of the last request, its outcome is reported
+    // once the response has been checked
+    CircuitBreaker* _breaker = nullptr;
+    std::function<void(const json&)> _check;
+
+    // Parses and checks body, reporting the outcome to the breaker: a
+    // body that's not JSON or a server_error thrown by the check are
+    // failures of the host
+    json _checked(std::string&& body);
+
+    static std::shared_ptr<const RetryPolicy>& _retry_policy();
+    static std::shared_ptr<const http_timeouts_t>& _timeouts();
+
+    // Timeouts of a request, bounded by the deadline of the thread.
+    // Throws a deadline_exceeded if it is over
+    static http_timeouts_t _bounded_timeouts(const std::string& what);
+
+    static std::shared_ptr<Transport>& _transport();
+
+    // Performs the request with the transport, throws a server_error
+    // if the status code is not 200, a circuit_open_error if the
+    // breaker of the host is open and a deadline_exceeded if the
+    // deadline of the thread is over
+    std::string _perform(const std::string& method, const std::string& url,
+                         std::list<std::string> headers, std::string body,
+                         const std::string& label);
+
 public:
     Request() {}
     Request(std::list<std::string> headers) : _headers(headers) {}
@@ -48,13 +135,55 @@ public:
     {
     }
 
+    /* Sets a check of every parsed response, e.g. a function throwing the
+     * errors returned with a 200 status code. A server_error thrown by
+     * the check is a failure for the breaker and it can be retried */
+    void check(std::function<void(const json&)> check)
+    {
+        _check = std::move(check);
+    }
+
+    /* Records the latency of the requests under the endpoint of url
+     * instead of their own, e.g. host + "txStat/" for the requests to
+     * host + "txStat/" + address: an address or a pair in the path would
+     * make every request a different endpoint */
+    void endpoint(std::string url) { _endpoint_url = std::move(url); }
+
     json get(std::string);
     std::string getHTML(std::string url);
     json post(std::string, json);
     json post(std::string, std::vector<std::pair<std::string, std::string>>);
+    json post(std::string url, const FormBody& body);
+
+    /* Returns the transport used by every Request */
+    static std::shared_ptr<Transport> transport();
+
+    /* Replaces the transport used by every Request. The requests in
+     * progress complete with the previous one. */
+    static void transport(std::shared_ptr<Transport> transport);
+
+    /* Returns the retry policy used by every Request */
+    static std::shared_ptr<const RetryPolicy> retry_policy();
+
+    /* Replaces the retry policy used by every Request */
+    static void retry_policy(RetryPolicy policy);
+
+    /* Returns the timeouts of every request: by default 10 s to connect,
+     * no total timeout and an abort if less than 1 byte per second is
+     * received for 30 s. The total timeout is further bounded by the
+     * Deadline of the calling thread */
+    static std::shared_ptr<const http_timeouts_t> timeouts();
+
+    /* Replaces the timeouts of every request */
+    static void timeouts(http_timeouts_t timeouts);
+
+    /* Warms up the transport for the host of url (see Transport::warmup),
+     * within the timeouts and the deadline of the requests */
+    static void warmup(const std::string& url);
 
     ~Request()
     {
+        _finish();
         for (auto ptr : _options) {
             delete ptr;
         }
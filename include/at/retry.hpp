@@ -0,0 +1,153 @@
+/* Copyright 2017 Paolo Galeone <nessuno@nerdz.eu>. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.*/
+
+#ifndef AT_RETRY_H_
+#define AT_RETRY_H_
+
+#include <at/deadline.hpp>
+#include <at/exceptions.hpp>
+#include <at/metrics.hpp>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace at {
+
+/* Retries the calls failed with a server_error, waiting a jittered
+ * exponential backoff between the attempts: the wait before the attempt
+ * n + 1 is uniform in [0, min(max, base * 2^(n - 1))], thus the clients
+ * hit by the same failure do not retry all together.
+ *
+ * An idempotent call is retried after any server_error, a call that is
+ * not (e.g. placing an order) only after a connection_error, when the
+ * request has not been sent. A circuit_open_error is never retried, and
+ * a deadline_exceeded is thrown instead of waiting past the Deadline of
+ * the calling thread.
+ *
+ * The retries, and among them the waits after a rate_limit_error, are
+ * counted in Metrics. A run nested in another run of the
+ * same thread performs a single attempt: only the outermost call is
+ * retried, the attempts never multiply. */
+class RetryPolicy {
+private:
+    unsigned _attempts;
+    std::chrono::milliseconds _base, _max;
+
+    // true while the calling thread is in a run
+    static bool& _running();
+
+public:
+    explicit RetryPolicy(
+        unsigned attempts = 3,
+        std::chrono::milliseconds base = std::chrono::milliseconds(100),
+        std::chrono::milliseconds max = std::chrono::milliseconds(2000));
+
+    /* Performs every call once */
+    static RetryPolicy none() { return RetryPolicy(1); }
+
+    unsigned attempts() const { return _attempts; }
+
+    /* Random wait after the failure of the attempt-th attempt */
+    std::chrono::milliseconds backoff(unsigned attempt) const;
+
+    /* Whether a call failed with error can be performed again */
+    static bool retryable(const server_error& error, bool idempotent);
+
+    /* Calls f and returns its result, calling it again on failure */
+    template <typename F>
+    auto run(bool idempotent, F&& f) const -> decltype(f())
+    {
+        using std::chrono::nanoseconds;
+        bool& running = _running();
+        if (running) {
+            return f();
+        }
+        running = true;
+        struct reset_t {
+            bool& running;
+            ~reset_t() { running = false; }
+        } reset{running};
+
+        for (unsigned attempt = 1;; ++attempt) {
+            std::chrono::milliseconds wait;
+            try {
+                return f();
+            }
+            catch (const server_error& e) {
+                if (attempt >= _attempts || !retryable(e, idempotent)) {
+                    throw;
+                }
+                wait = backoff(attempt);
+                if (nanoseconds(wait) >= Deadline::remaining()) {
+                    Metrics::add(metric_t::deadlines);
+                    throw deadline_exceeded(
+                        std::string("deadline exceeded retrying: ") +
+                        e.what());
+                }
+                if (dynamic_cast<const rate_limit_error*>(&e) != nullptr) {
+                    Metrics::add(metric_t::rate_limit_waits);
+                }
+            }
+            Metrics::add(metric_t::retries);
+            std::this_thread::sleep_for(wait);
+        }
+    }
+};
+
+/* Per-host circuit breaker of Request.
+ *
+ * After threshold consecutive failures (the server can't be reached,
+ * answers with a 5xx or 429 status, or reports to be overloaded) the
+ * circuit opens and the requests to the host fail immediately with a
+ * circuit_open_error, without adding load to a server that is already
+ * struggling. Once cooldown is elapsed a single request is let through:
+ * the circuit closes if it succeeds, opens again otherwise. */
+class CircuitBreaker {
+public:
+    enum class state_t : uint8_t { closed, open, half_open };
+
+private:
+    mutable std::mutex _mux;
+    state_t _state = state_t::closed;
+    unsigned _failures = 0;
+    unsigned _threshold;
+    std::chrono::milliseconds _cooldown;
+    std::chrono::steady_clock::time_point _opened;
+
+public:
+    explicit CircuitBreaker(
+        unsigned threshold = 5,
+        std::chrono::milliseconds cooldown = std::chrono::seconds(10));
+
+    /* Returns the breaker of host, created if needed with the default
+     * configuration. The pointer stays valid for the lifetime of the
+     * process. */
+    static CircuitBreaker* host(const std::string& name);
+
+    void configure(unsigned threshold, std::chrono::milliseconds cooldown);
+
+    /* Whether a request can be sent now */
+    bool allow();
+
+    void success();
+    void failure();
+
+    state_t state() const;
+};
+
+}  // end namespace at
+
+#endif  // AT_RETRY_H_
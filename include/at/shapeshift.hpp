@@ -44,8 +44,17 @@ public:
         : _affiliate_private_key(affiliate_private_key)
     {
     }
+    // host replaces https://shapeshift.io/ (e.g. a local mock server)
+    Shapeshift(std::string affiliate_private_key, std::string host)
+        : _host(host), _affiliate_private_key(affiliate_private_key)
+    {
+    }
     ~Shapeshift() {}
 
+    /* Resolves, connects and completes the TLS handshake with the API
+     * server ahead of the first call (see Exchange::warmup) */
+    void warmup() override;
+
     /* Gets the current rate offered by Shapeshift. This is an estimate because
      * the rate can occasionally change rapidly depending on the markets. The
      * rate is also a 'use-able' rate not a direct market rate. Meaning
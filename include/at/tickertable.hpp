@@ -0,0 +1,141 @@
+/* Copyright 2017 Paolo Galeone <nessuno@nerdz.eu>. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.*/
+
+#ifndef AT_TICKERTABLE_H_
+#define AT_TICKERTABLE_H_
+
+#include <at/types.hpp>
+#include <cstdint>
+#include <ctime>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace at {
+
+/* Resident table of cm_ticker_t rows, keyed by the CoinMarketCap id.
+ *
+ * The numeric fields are stored column by column: a row is an index
+ * shared by every column. The strings (id, name, symbol) are written
+ * only when a row is inserted.
+ *
+ * apply() merges a JSON ticker list into the table and touches only the
+ * rows whose last_updated field changed, hence refreshing the table
+ * does not reallocate the rows already present. */
+class TickerTable {
+private:
+    std::unordered_map<std::string, std::size_t> _row;
+
+    std::vector<std::string> _id, _name, _symbol;
+    std::vector<int> _rank;
+    std::vector<double> _price_usd, _price_btc;
+    std::vector<long long int> _day_volume_usd, _market_cap_usd,
+        _available_supply, _total_supply;
+    std::vector<float> _percent_change_1h, _percent_change_24h,
+        _percent_change_7d;
+    std::vector<std::time_t> _last_updated;
+
+    // _seen[row] == _epoch if the row was present in the last apply
+    std::vector<uint32_t> _seen;
+    uint32_t _epoch = 0;
+
+    // Numeric fields of a json row, parsed before touching the columns
+    typedef struct {
+        int rank;
+        double price_usd, price_btc;
+        long long int day_volume_usd, market_cap_usd, available_supply,
+            total_supply;
+        float percent_change_1h, percent_change_24h, percent_change_7d;
+    } values_t;
+
+    // Parses the numeric fields of the json row
+    static values_t _parse(const json& row);
+
+    // Appends an empty row for the specified id and returns its index
+    std::size_t _insert(const std::string& id, const json& row);
+
+    // Writes the numeric columns of the row idx
+    void _set(std::size_t idx, const values_t& values);
+
+    // Moves the last row in position idx and shrinks every column
+    void _erase(std::size_t idx);
+
+public:
+    static constexpr std::size_t npos = static_cast<std::size_t>(-1);
+
+    TickerTable() {}
+    ~TickerTable() {}
+
+    /* Merges the rows (a JSON array in the CoinMarketCap ticker format) in
+     * the table, filling changes with the rows added and updated.
+     * If prune is true, the rows not present in rows are removed. */
+    void apply(const json& rows, cm_ticker_changes_t& changes,
+               bool prune = false);
+    cm_ticker_changes_t apply(const json& rows, bool prune = false);
+
+    // Pre-allocates every column for n rows
+    void reserve(std::size_t n);
+
+    std::size_t size() const { return _id.size(); }
+
+    // Returns the row index of the id, or npos if not present
+    std::size_t find(const std::string& id) const;
+
+    // Materializes the row idx in a cm_ticker_t
+    cm_ticker_t at(std::size_t idx) const;
+
+    // Columns
+    const std::vector<std::string>& id() const { return _id; }
+    const std::vector<std::string>& name() const { return _name; }
+    const std::vector<std::string>& symbol() const { return _symbol; }
+    const std::vector<int>& rank() const { return _rank; }
+    const std::vector<double>& price_usd() const { return _price_usd; }
+    const std::vector<double>& price_btc() const { return _price_btc; }
+    const std::vector<long long int>& day_volume_usd() const
+    {
+        return _day_volume_usd;
+    }
+    const std::vector<long long int>& market_cap_usd() const
+    {
+        return _market_cap_usd;
+    }
+    const std::vector<long long int>& available_supply() const
+    {
+        return _available_supply;
+    }
+    const std::vector<long long int>& total_supply() const
+    {
+        return _total_supply;
+    }
+    const std::vector<float>& percent_change_1h() const
+    {
+        return _percent_change_1h;
+    }
+    const std::vector<float>& percent_change_24h() const
+    {
+        return _percent_change_24h;
+    }
+    const std::vector<float>& percent_change_7d() const
+    {
+        return _percent_change_7d;
+    }
+    const std::vector<std::time_t>& last_updated() const
+    {
+        return _last_updated;
+    }
+};
+
+}  // end namespace at
+
+#endif  // AT_TICKERTABLE_H_
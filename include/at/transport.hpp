@@ -0,0 +1,232 @@
+/* Copyright 2017 Paolo Galeone <nessuno@nerdz.eu>. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.*/
+
+#ifndef AT_TRANSPORT_H_
+#define AT_TRANSPORT_H_
+
+#include <curlpp/Options.hpp>
+
+#include <at/exceptions.hpp>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace at {
+
+// Timeouts of a request, 0 disables them. The transfer is aborted if it
+// is slower than low_speed_limit bytes per second for low_speed_time
+typedef struct {
+    std::chrono::milliseconds connect, total;
+    long low_speed_limit;
+    std::chrono::seconds low_speed_time;
+} http_timeouts_t;
+
+typedef struct {
+    std::string method;  // GET or POST
+    std::string url;
+    std::list<std::string> headers;
+    std::string body;
+    http_timeouts_t timeouts;
+    // additional curl options, not owned. Used only by CurlTransport
+    std::list<curlpp::OptionBase*> options;
+} http_request_t;
+
+// Durations of the phases of a transfer. total is 0 if the transport
+// does not measure them
+typedef struct {
+    std::chrono::nanoseconds dns, connect, tls, first_byte, transfer, total;
+} http_timing_t;
+
+typedef struct {
+    long status;
+    std::string body;
+    http_timing_t timing;
+} http_response_t;
+
+// HTTP version negotiated by CurlTransport
+enum class http_version_t : uint8_t {
+    http1_1,  // HTTP/1.1 only
+    http2,    // HTTP/2 over TLS, if the server supports it
+};
+
+// Per-host configuration of CurlTransport
+typedef struct {
+    bool compression;  // accept every encoding supported by curl
+    http_version_t version;
+} http_host_config_t;
+
+/* Performs the HTTP requests of Request.
+ * perform throws a server_error if the request can't be performed or
+ * times out, a connection_error if it has not been sent at all; a
+ * response with any status code is returned. */
+class Transport {
+public:
+    /* Largest storage kept by recycle */
+    static constexpr std::size_t max_recycled = 64 << 20;
+
+    virtual ~Transport() {}
+    virtual http_response_t perform(const http_request_t& request) = 0;
+
+    /* Prepares the transport to perform requests to the host of the url of
+     * request, e.g. resolving it and connecting to it. By default it does
+     * nothing */
+    virtual void warmup(const http_request_t&) {}
+
+    /* Returns an empty string for a response body, with the storage of
+     * the last body recycled by the calling thread: a thread performing
+     * requests in sequence reuses the same buffer, without reallocating
+     * it as the responses grow */
+    static std::string buffer();
+
+    /* Gives back the storage of a response body no longer used */
+    static void recycle(std::string&& body);
+};
+
+/* Network transport, using curl. The response body is written by curl
+ * directly into a recycled buffer (see Transport::buffer), reserved from
+ * the Content-Length of the response.
+ *
+ * Every thread performs its requests with its own curl handle, kept
+ * between the requests: the connections are reused (keep-alive, or a
+ * single HTTP/2 connection per host). The DNS cache, whose entries live
+ * for dns_ttl, and the TLS sessions are shared by every thread: a new
+ * connection does not resolve the host again and resumes the handshake.
+ *
+ * By default the responses are compressed (gzip, brotli, ... as built in
+ * curl) and HTTP/2 is negotiated, over TLS 1.2 or later; configure
+ * changes it for a host (host[:port], as in the url). */
+class CurlTransport : public Transport {
+private:
+    mutable std::mutex _mux;
+    http_host_config_t _default;
+    std::unordered_map<std::string, http_host_config_t> _hosts;
+    std::atomic<long> _dns_ttl{60};  // seconds
+
+public:
+    explicit CurlTransport(http_host_config_t config = {
+                               .compression = true,
+                               .version = http_version_t::http2,
+                           })
+        : _default(config)
+    {
+    }
+
+    void configure(const std::string& host, http_host_config_t config);
+
+    /* Configuration of host, the default one if not configured */
+    http_host_config_t config(const std::string& host) const;
+
+    /* Lifetime of the resolved addresses, 60 seconds by default */
+    void dns_ttl(std::chrono::seconds ttl) { _dns_ttl = ttl.count(); }
+
+    http_response_t perform(const http_request_t& request) override;
+
+    /* Resolves the host, connects and completes the TLS handshake with a
+     * HEAD request, whatever its status. The connection is kept by the
+     * calling thread, the resolved address and the TLS session by every
+     * thread. Throws a server_error if the host can't be reached. */
+    void warmup(const http_request_t& request) override;
+};
+
+/* Performs the requests with another transport and records every
+ * request/response pair in a file.
+ *
+ * The file is a header followed by the records, appended in order:
+ *
+ *  header  "ATHT", version (uint32_t)
+ *  record  method, url, body, response lengths (uint32_t),
+ *          status (int32_t), then the method, url, body and response
+ *
+ * Every record is flushed once written: the file can be replayed while
+ * it is still recorded. If the file exists, the records are appended. */
+class RecordingTransport : public Transport {
+private:
+    std::shared_ptr<Transport> _transport;
+    std::mutex _mux;
+    std::ofstream _out;
+
+public:
+    RecordingTransport(std::shared_ptr<Transport> transport,
+                       const std::string& path);
+    http_response_t perform(const http_request_t& request) override;
+
+    void warmup(const http_request_t& request) override
+    {
+        _transport->warmup(request);
+    }
+};
+
+/* Serves the responses of a file written by a RecordingTransport,
+ * without any network access. The file is memory mapped and indexed
+ * once by the constructor.
+ *
+ * A request is matched by method, url and body; the parameters in
+ * ignored (e.g. the Kraken nonce, different at every request) are
+ * removed from the query string and from the body before matching. A
+ * body that's a JSON object loses its top level keys in ignored.
+ * The responses recorded for the same request are served in order, the
+ * last one is repeated once they are over.
+ *
+ * perform throws a server_error if there are no responses for a
+ * request. */
+class ReplayTransport : public Transport {
+private:
+    typedef struct {
+        long status;
+        const char* body;
+        std::size_t size;
+    } recorded_t;
+
+    typedef struct {
+        std::vector<recorded_t> responses;
+        std::size_t next;
+    } entry_t;
+
+    int _fd = -1;
+    void* _data = nullptr;
+    std::size_t _size = 0;
+
+    const std::set<std::string> _ignored;
+    std::mutex _mux;
+    std::unordered_map<std::string, entry_t> _index;
+
+    // method, url and body without the ignored parameters (or keys, if
+    // the body is a JSON object)
+    std::string _key(const std::string& method, const std::string& url,
+                     const std::string& body) const;
+
+public:
+    explicit ReplayTransport(const std::string& path,
+                             std::set<std::string> ignored = {"nonce"});
+    ReplayTransport(const ReplayTransport&) = delete;
+    ReplayTransport& operator=(const ReplayTransport&) = delete;
+    ~ReplayTransport();
+
+    http_response_t perform(const http_request_t& request) override;
+
+    /* Number of distinct requests recorded */
+    std::size_t size() const { return _index.size(); }
+};
+
+}  // end namespace at
+
+#endif  // AT_TRANSPORT_H_
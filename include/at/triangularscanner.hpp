@@ -0,0 +1,106 @@
+/* Copyright 2017 Paolo Galeone <nessuno@nerdz.eu>. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.*/
+
+#ifndef AT_TRIANGULARSCANNER_H_
+#define AT_TRIANGULARSCANNER_H_
+
+#include <at/types.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace at {
+
+// Triangular cycle: path[0] -> path[1] -> path[2] -> path[0].
+// The i-th conversion is done with an order of type actions[i] on
+// pairs[i]. rate is the amount of path[0] obtained converting 1 path[0]
+// along the cycle, fees included
+typedef struct {
+    std::vector<std::string> path;
+    std::vector<currency_pair_t> pairs;
+    std::vector<order_action_t> actions;
+    double rate;
+} triangular_cycle_t;
+
+/* Scanner of the triangular arbitrages among a set of markets.
+ *
+ * The graph of the cycles is built once by the constructor. Every
+ * update of a ticker recomputes only the cycles that contain the pair.
+ *
+ * The data is stored as structure of arrays: the rate of every
+ * conversion (two per pair: sell at the bid, buy at the ask) and, for
+ * every pair, the contiguous arrays of the cycles containing it with the
+ * indices of their other two conversions. The recomputation is a
+ * branch-free loop of products into a dense array, vectorized by the
+ * compiler (the rates are gathered by index), followed by the scatter of
+ * the products to the rates of the cycles.
+ *
+ * The fee of every conversion is the taker fee of the market, or the
+ * maker fee if maker is true.
+ *
+ * This class is not thread safe. */
+class TriangularScanner {
+private:
+    typedef struct {
+        std::vector<uint32_t> cycle, own, first, second;
+    } touching_t;
+
+    std::vector<std::string> _currencies;
+    std::vector<currency_pair_t> _pairs;  // normalized
+    // pair.str() of the markets and of the normalized pairs
+    std::unordered_map<std::string, uint32_t> _pair_id;
+    std::vector<double> _fee;
+
+    // rate of conversion 2 * pair (sell) and 2 * pair + 1 (buy), 0 if the
+    // ticker of pair is unknown
+    std::vector<double> _rate;
+
+    // conversions and rate of every cycle
+    std::vector<uint32_t> _legs[3];
+    std::vector<double> _cycle_rate;
+
+    // cycles containing every pair
+    std::vector<touching_t> _touching;
+    // rates of the cycles recomputed by update, in the order of touching
+    std::vector<double> _product;
+
+public:
+    /* Builds the triangular cycles of markets */
+    explicit TriangularScanner(const std::vector<market_info_t>& markets,
+                               bool maker = false);
+
+    /* Updates the ticker of pair and recomputes the cycles containing it.
+     * Returns the indices of the recomputed cycles with a rate greater
+     * than threshold.
+     * Throws std::out_of_range if pair is unknown. */
+    std::vector<std::size_t> update(const currency_pair_t& pair,
+                                    const ticker_t& ticker,
+                                    double threshold = 1);
+
+    /* Returns the cycles with a rate greater than threshold, best first */
+    std::vector<triangular_cycle_t> opportunities(double threshold = 1) const;
+
+    /* Returns the cycle with index i */
+    triangular_cycle_t cycle(std::size_t i) const;
+
+    /* Number of cycles */
+    std::size_t size() const { return _cycle_rate.size(); }
+};
+
+}  // end namespace at
+
+#endif  // AT_TRIANGULARSCANNER_H_
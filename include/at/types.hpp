@@ -18,10 +18,12 @@
 #include <ctime>
 #include <exception>
 #include <nlohmann/json.hpp>
+#include <set>
 #include <sstream>
 #include <stdexcept>
 #include <string>
 #include <utility>
+#include <vector>
 
 namespace at {
 
@@ -96,6 +98,35 @@ inline std::ostream& operator<<(std::ostream& o, const currency_pair_t& pair)
     return o << pair.str();
 }
 
+// Returns the common symbol of a currency: the Kraken asset codes are
+// X/Z prefixed (XXBT, ZEUR) and some symbols differ (XBT, XDG).
+// Only the known Kraken asset codes lose the prefix, thus symbols like
+// XAUT or ZEUS are left untouched.
+inline std::string normalize_symbol(std::string symbol)
+{
+    static const std::set<std::string> kraken_assets = {
+        "XDAO", "XETC", "XETH", "XICN", "XLTC", "XMLN", "XNMC", "XREP",
+        "XXBT", "XXDG", "XXLM", "XXMR", "XXRP", "XXVN", "XZEC", "ZAUD",
+        "ZCAD", "ZEUR", "ZGBP", "ZJPY", "ZKRW", "ZUSD"};
+    toupper(symbol);
+    if (kraken_assets.count(symbol) != 0) {
+        symbol = symbol.substr(1);
+    }
+    if (symbol == "XBT") {
+        return "BTC";
+    }
+    if (symbol == "XDG") {
+        return "DOGE";
+    }
+    return symbol;
+}
+
+inline currency_pair_t normalize(const currency_pair_t& pair)
+{
+    return currency_pair_t(normalize_symbol(pair.first),
+                           normalize_symbol(pair.second));
+}
+
 inline void to_json(json& j, const currency_pair_t c)
 {
     j = json{c.first, c.second};
@@ -481,6 +512,14 @@ typedef struct {
     std::time_t last_updated;
 } cm_ticker_t;
 
+// Rows of a TickerTable touched by a refresh.
+// added and updated are row indices valid after the refresh,
+// removed contains the ids of the rows no more present
+typedef struct {
+    std::vector<std::size_t> added, updated;
+    std::vector<std::string> removed;
+} cm_ticker_changes_t;
+
 // Global markets data
 typedef struct {
     long long int total_market_cap_usd, total_24h_volume_usd;
@@ -0,0 +1,399 @@
+/* Copyright 2017 Paolo Galeone <nessuno@nerdz.eu>. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.*/
+
+#include <algorithm>
+#include <array>
+#include <at/address.hpp>
+#include <at/crypt/namespace.hpp>
+#include <functional>
+#include <map>
+
+namespace at::address {
+
+namespace {
+
+const char bitcoin_alphabet[] =
+    "123456789ABCDEFGHJKLMNPQRSTUVWXYZabcdefghijkmnopqrstuvwxyz";
+const char ripple_alphabet[] =
+    "rpshnaf39wBUDNEGHJKLM4PQRST7VWXYZ2bcdeCg65jkm8oFqi1tuvAxyz";
+const char bech32_charset[] = "qpzry9x8gf2tvdw0s3jn54khce6mua7l";
+
+typedef std::array<int8_t, 128> alphabet_map_t;
+
+alphabet_map_t reverse(const char* alphabet, std::size_t size)
+{
+    alphabet_map_t map;
+    map.fill(-1);
+    for (std::size_t i = 0; i < size; ++i) {
+        map[static_cast<unsigned char>(alphabet[i])] = static_cast<int8_t>(i);
+    }
+    return map;
+}
+
+const alphabet_map_t bitcoin_map = reverse(bitcoin_alphabet, 58);
+const alphabet_map_t ripple_map = reverse(ripple_alphabet, 58);
+const alphabet_map_t bech32_map = reverse(bech32_charset, 32);
+
+int8_t lookup(const alphabet_map_t& map, char c)
+{
+    auto u = static_cast<unsigned char>(c);
+    return u < map.size() ? map[u] : -1;
+}
+
+// Decodes the base58 string in bytes (big endian), keeping the leading
+// zeroes encoded as the first symbol of the alphabet
+bool base58_decode(const std::string& in, const alphabet_map_t& map,
+                   std::vector<unsigned char>& out)
+{
+    out.clear();
+    std::size_t zeroes = 0;
+    while (zeroes < in.size() && lookup(map, in[zeroes]) == 0) {
+        ++zeroes;
+    }
+
+    // little endian base 256 number
+    std::vector<unsigned char> number;
+    number.reserve(in.size());
+    for (std::size_t i = zeroes; i < in.size(); ++i) {
+        int digit = lookup(map, in[i]);
+        if (digit < 0) {
+            return false;
+        }
+        uint32_t carry = static_cast<uint32_t>(digit);
+        for (auto& byte : number) {
+            carry += static_cast<uint32_t>(byte) * 58;
+            byte = static_cast<unsigned char>(carry & 0xff);
+            carry >>= 8;
+        }
+        while (carry > 0) {
+            number.push_back(static_cast<unsigned char>(carry & 0xff));
+            carry >>= 8;
+        }
+    }
+    out.assign(zeroes, 0);
+    out.insert(out.end(), number.rbegin(), number.rend());
+    return true;
+}
+
+// Monero base58: blocks of 8 bytes encoded in 11 symbols, the last block
+// can be shorter
+bool monero_base58_decode(const std::string& in,
+                          std::vector<unsigned char>& out)
+{
+    // encoded block size -> decoded block size
+    const int decoded_size[12] = {0, -1, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8};
+    out.clear();
+    for (std::size_t begin = 0; begin < in.size(); begin += 11) {
+        std::size_t len = std::min<std::size_t>(11, in.size() - begin);
+        int size = decoded_size[len];
+        if (size < 0) {
+            return false;
+        }
+        unsigned __int128 number = 0;
+        for (std::size_t i = begin; i < begin + len; ++i) {
+            int digit = lookup(bitcoin_map, in[i]);
+            if (digit < 0) {
+                return false;
+            }
+            number = number * 58 + static_cast<unsigned>(digit);
+        }
+        if (size < 8 && (number >> (8 * size)) != 0) {
+            return false;
+        }
+        if (number >> 64 != 0) {
+            return false;
+        }
+        for (int i = size - 1; i >= 0; --i) {
+            out.push_back(static_cast<unsigned char>(number >> (8 * i)));
+        }
+    }
+    return true;
+}
+
+std::vector<unsigned char> sha256d(const unsigned char* data, std::size_t len)
+{
+    auto first = crypt::sha256(std::string(data, data + len));
+    return crypt::sha256(std::string(first.begin(), first.end()));
+}
+
+uint32_t bech32_polymod(const std::vector<uint8_t>& values)
+{
+    const uint32_t generator[5] = {0x3b6a57b2, 0x26508e6d, 0x1ea119fa,
+                                   0x3d4233dd, 0x2a1462b3};
+    uint32_t chk = 1;
+    for (auto value : values) {
+        uint32_t top = chk >> 25;
+        chk = (chk & 0x1ffffff) << 5 ^ value;
+        for (int i = 0; i < 5; ++i) {
+            if ((top >> i) & 1) {
+                chk ^= generator[i];
+            }
+        }
+    }
+    return chk;
+}
+
+const uint32_t bech32_constant = 1;
+const uint32_t bech32m_constant = 0x2bc830a3;
+
+typedef std::function<bool(const std::string&)> validator_t;
+
+const std::map<std::string, validator_t> validators = {
+    {"BTC",
+     [](const std::string& a) {
+         return isBase58Check(a, {{0x00, 1}, {0x05, 1}}) || isSegwit(a, "bc");
+     }},
+    {"BCH",
+     [](const std::string& a) {
+         return isBase58Check(a, {{0x00, 1}, {0x05, 1}});
+     }},
+    {"LTC",
+     [](const std::string& a) {
+         return isBase58Check(a, {{0x30, 1}, {0x32, 1}, {0x05, 1}}) ||
+                isSegwit(a, "ltc");
+     }},
+    {"DOGE",
+     [](const std::string& a) {
+         return isBase58Check(a, {{0x1e, 1}, {0x16, 1}});
+     }},
+    {"DASH",
+     [](const std::string& a) {
+         return isBase58Check(a, {{0x4c, 1}, {0x10, 1}});
+     }},
+    {"ZEC",
+     [](const std::string& a) {
+         return isBase58Check(a, {{0x1cb8, 2}, {0x1cbd, 2}});
+     }},
+    {"ETH", [](const std::string& a) { return isEIP55(a); }},
+    {"ETC", [](const std::string& a) { return isEIP55(a); }},
+    {"XRP",
+     [](const std::string& a) {
+         return isBase58Check(a, {{0x00, 1}}, true);
+     }},
+    {"XMR", [](const std::string& a) { return isMonero(a, {18, 19, 42}); }},
+};
+
+}  // end namespace
+
+bool isSupported(std::string symbol)
+{
+    toupper(symbol);
+    return validators.find(symbol) != validators.end();
+}
+
+bool isValid(std::string symbol, const hash_t& address)
+{
+    toupper(symbol);
+    auto validator = validators.find(symbol);
+    if (validator == validators.end()) {
+        throw std::invalid_argument("Offline validation of " + symbol +
+                                    " addresses is not supported");
+    }
+    return validator->second(address);
+}
+
+std::vector<bool> isValid(std::string symbol,
+                          const std::vector<hash_t>& addresses)
+{
+    toupper(symbol);
+    auto validator = validators.find(symbol);
+    if (validator == validators.end()) {
+        throw std::invalid_argument("Offline validation of " + symbol +
+                                    " addresses is not supported");
+    }
+    std::vector<bool> ret(addresses.size());
+    for (std::size_t i = 0; i < addresses.size(); ++i) {
+        ret[i] = validator->second(addresses[i]);
+    }
+    return ret;
+}
+
+bool isBase58Check(const std::string& address,
+                   const std::vector<base58_version_t>& versions, bool ripple)
+{
+    // 25 or 26 bytes are at most 36 symbols
+    if (address.size() < 25 || address.size() > 36) {
+        return false;
+    }
+    std::vector<unsigned char> data;
+    if (!base58_decode(address, ripple ? ripple_map : bitcoin_map, data)) {
+        return false;
+    }
+    // version || 20 bytes payload || 4 bytes checksum
+    if (data.size() != 25 && data.size() != 26) {
+        return false;
+    }
+    std::size_t version_size = data.size() - 24;
+    uint16_t version = version_size == 1
+                           ? data[0]
+                           : static_cast<uint16_t>(data[0] << 8 | data[1]);
+    if (std::none_of(versions.begin(), versions.end(),
+                     [version, version_size](const base58_version_t& v) {
+                         return v.value == version && v.size == version_size;
+                     })) {
+        return false;
+    }
+
+    auto checksum = sha256d(data.data(), data.size() - 4);
+    return std::equal(checksum.begin(), checksum.begin() + 4, data.end() - 4);
+}
+
+bool isSegwit(const std::string& address, const std::string& hrp)
+{
+    if (address.size() < 8 || address.size() > 90) {
+        return false;
+    }
+    bool lower = false, upper = false;
+    for (char c : address) {
+        if (c < 33 || c > 126) {
+            return false;
+        }
+        lower |= c >= 'a' && c <= 'z';
+        upper |= c >= 'A' && c <= 'Z';
+    }
+    if (lower && upper) {
+        return false;
+    }
+
+    std::string lowercase = address;
+    tolower(lowercase);
+    std::size_t separator = lowercase.rfind('1');
+    if (separator == std::string::npos || separator + 7 > lowercase.size() ||
+        lowercase.compare(0, separator, hrp) != 0 ||
+        separator != hrp.size()) {
+        return false;
+    }
+
+    // hrp expansion || data
+    std::vector<uint8_t> values;
+    values.reserve(hrp.size() * 2 + 1 + lowercase.size() - separator - 1);
+    for (char c : hrp) {
+        values.push_back(static_cast<uint8_t>(c) >> 5);
+    }
+    values.push_back(0);
+    for (char c : hrp) {
+        values.push_back(static_cast<uint8_t>(c) & 31);
+    }
+    std::size_t data_begin = values.size();
+    for (std::size_t i = separator + 1; i < lowercase.size(); ++i) {
+        int8_t value = lookup(bech32_map, lowercase[i]);
+        if (value < 0) {
+            return false;
+        }
+        values.push_back(static_cast<uint8_t>(value));
+    }
+
+    uint8_t witness_version = values[data_begin];
+    uint32_t constant = bech32_polymod(values);
+    if (witness_version > 16 ||
+        (witness_version == 0 && constant != bech32_constant) ||
+        (witness_version != 0 && constant != bech32m_constant)) {
+        return false;
+    }
+
+    // witness program: 5 bits groups -> bytes, without the checksum
+    std::size_t program_size = 0;
+    uint32_t accumulator = 0;
+    int bits = 0;
+    for (std::size_t i = data_begin + 1; i < values.size() - 6; ++i) {
+        accumulator = (accumulator << 5) | values[i];
+        bits += 5;
+        if (bits >= 8) {
+            bits -= 8;
+            ++program_size;
+        }
+    }
+    // padding must be shorter than 5 bits and zero
+    if (bits >= 5 || (accumulator & ((1u << bits) - 1)) != 0) {
+        return false;
+    }
+    if (program_size < 2 || program_size > 40) {
+        return false;
+    }
+    return witness_version != 0 || program_size == 20 || program_size == 32;
+}
+
+bool isEIP55(const std::string& address)
+{
+    if (address.size() != 42 || address[0] != '0' ||
+        (address[1] != 'x' && address[1] != 'X')) {
+        return false;
+    }
+    bool lower = false, upper = false;
+    for (std::size_t i = 2; i < address.size(); ++i) {
+        char c = address[i];
+        if (!std::isxdigit(static_cast<unsigned char>(c))) {
+            return false;
+        }
+        lower |= c >= 'a' && c <= 'f';
+        upper |= c >= 'A' && c <= 'F';
+    }
+    // all lowercase or all uppercase: no checksum
+    if (!lower || !upper) {
+        return true;
+    }
+
+    std::string hex = address.substr(2);
+    tolower(hex);
+    auto hash = crypt::keccak256(hex);
+    for (std::size_t i = 0; i < hex.size(); ++i) {
+        if (hex[i] < 'a') {  // digit
+            continue;
+        }
+        int nibble = i % 2 == 0 ? hash[i / 2] >> 4 : hash[i / 2] & 0x0f;
+        bool uppercase = address[i + 2] >= 'A' && address[i + 2] <= 'F';
+        if ((nibble >= 8) != uppercase) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool isMonero(const std::string& address,
+              const std::vector<uint64_t>& prefixes)
+{
+    // standard and subaddresses: 95 symbols, integrated: 106 symbols
+    if (address.size() != 95 && address.size() != 106) {
+        return false;
+    }
+    std::vector<unsigned char> data;
+    if (!monero_base58_decode(address, data) || data.size() < 4) {
+        return false;
+    }
+
+    // varint prefix
+    uint64_t prefix = 0;
+    std::size_t prefix_size = 0;
+    for (int shift = 0; prefix_size < data.size() && shift < 64; shift += 7) {
+        unsigned char byte = data[prefix_size++];
+        prefix |= static_cast<uint64_t>(byte & 0x7f) << shift;
+        if ((byte & 0x80) == 0) {
+            break;
+        }
+    }
+    if (std::find(prefixes.begin(), prefixes.end(), prefix) == prefixes.end()) {
+        return false;
+    }
+    // prefix || spend key || view key [|| payment id] || checksum
+    std::size_t keys_size = data.size() - prefix_size - 4;
+    if (keys_size != 64 && keys_size != 72) {
+        return false;
+    }
+
+    auto checksum = crypt::keccak256(
+        std::string(data.begin(), data.end() - 4));
+    return std::equal(checksum.begin(), checksum.begin() + 4, data.end() - 4);
+}
+
+}  // namespace at::address
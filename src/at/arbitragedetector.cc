@@ -0,0 +1,185 @@
+/* Copyright 2017 Paolo Galeone <nessuno@nerdz.eu>. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.*/
+
+#include <algorithm>
+#include <at/arbitragedetector.hpp>
+
+namespace at {
+
+// private methods
+
+std::size_t ArbitrageDetector::_id(const std::string& currency)
+{
+    auto it = _ids.find(currency);
+    if (it != _ids.end()) {
+        return it->second;
+    }
+    // grow the matrix when full, doubling the row size and moving the
+    // cells to it: k currencies cost O(k^2) moves overall
+    std::size_t n = _currencies.size();
+    if (n == _stride) {
+        std::size_t stride = std::max<std::size_t>(2 * _stride, 8);
+        std::vector<cell_t> cells(stride * stride, cell_t{});
+        for (std::size_t i = 0; i < n; ++i) {
+            std::move(_cells.begin() + i * _stride,
+                      _cells.begin() + i * _stride + n,
+                      cells.begin() + i * stride);
+        }
+        _cells.swap(cells);
+        _stride = stride;
+    }
+    _ids[currency] = n;
+    _currencies.push_back(currency);
+    return n;
+}
+
+ArbitrageDetector::cell_t& ArbitrageDetector::_cell(std::size_t from,
+                                                    std::size_t to)
+{
+    return _cells[from * _stride + to];
+}
+
+void ArbitrageDetector::_evaluate(std::size_t from, std::size_t to,
+                                  std::vector<arbitrage_t>& found)
+{
+    const cell_t& market = _cell(from, to);
+    const cell_t& exchange = _cell(to, from);
+    if (market.market_rate <= 0 || exchange.exchange_rate <= 0) {
+        return;
+    }
+
+    // the amount of to deposited on the exchange must be within its limits
+    double amount = market.market_amount;
+    if (exchange.limit.max > 0) {
+        amount = std::min(amount, exchange.limit.max / market.market_rate);
+    }
+    double deposit = amount * market.market_rate;
+    if (amount <= 0 || deposit < exchange.limit.min) {
+        return;
+    }
+    double output = deposit * exchange.exchange_rate - exchange.miner_fee;
+    double ratio = output / amount;
+    if (ratio <= 1 + _threshold) {
+        return;
+    }
+    found.push_back(arbitrage_t{
+        .from = _currencies[from],
+        .to = _currencies[to],
+        .market_pair = market.market_pair,
+        .action = market.action,
+        .exchange_pair = exchange.exchange_pair,
+        .amount = amount,
+        .output = output,
+        .ratio = ratio,
+        .latency = std::chrono::nanoseconds(0),
+    });
+}
+
+void ArbitrageDetector::_emit(std::vector<arbitrage_t>& found,
+                              std::chrono::steady_clock::time_point start)
+{
+    for (auto& arbitrage : found) {
+        arbitrage.latency = std::chrono::steady_clock::now() - start;
+        {
+            std::lock_guard<std::mutex> lock(_mux);
+            ++_latency.count;
+            _latency.min = std::min(_latency.min, arbitrage.latency);
+            _latency.max = std::max(_latency.max, arbitrage.latency);
+            _latency.total += arbitrage.latency;
+        }
+        _callback(arbitrage);
+    }
+}
+
+// end private methods
+
+ArbitrageDetector::ArbitrageDetector(Market& market, Exchange& exchange,
+                                     callback_t callback, double threshold)
+    : _market(market),
+      _exchange(exchange),
+      _callback(callback),
+      _threshold(threshold)
+{
+}
+
+void ArbitrageDetector::update(const market_info_t& info,
+                               const ticker_t& ticker)
+{
+    auto start = std::chrono::steady_clock::now();
+    auto pair = normalize(info.pair);
+    double keep = 1 - info.taker_fee / 100;
+    std::vector<arbitrage_t> found;
+    {
+        std::lock_guard<std::mutex> lock(_mux);
+        std::size_t base = _id(pair.first), quote = _id(pair.second);
+
+        // base -> quote: sell at the bid
+        cell_t& sell = _cell(base, quote);
+        sell.market_rate = ticker.bid.price * keep;
+        sell.market_amount = ticker.bid.amount;
+        sell.market_pair = info.pair;
+        sell.action = order_action_t::sell;
+
+        // quote -> base: buy at the ask
+        cell_t& buy = _cell(quote, base);
+        buy.market_rate = ticker.ask.price > 0 ? keep / ticker.ask.price : 0;
+        buy.market_amount = ticker.ask.amount * ticker.ask.price;
+        buy.market_pair = info.pair;
+        buy.action = order_action_t::buy;
+
+        _evaluate(base, quote, found);
+        _evaluate(quote, base, found);
+    }
+    _emit(found, start);
+}
+
+void ArbitrageDetector::update(const exchange_info_t& info)
+{
+    auto start = std::chrono::steady_clock::now();
+    auto pair = normalize(info.pair);
+    std::vector<arbitrage_t> found;
+    {
+        std::lock_guard<std::mutex> lock(_mux);
+        std::size_t from = _id(pair.first), to = _id(pair.second);
+        cell_t& cell = _cell(from, to);
+        cell.exchange_rate = info.rate;
+        cell.miner_fee = info.miner_fee;
+        cell.limit = info.limit;
+        cell.exchange_pair = info.pair;
+
+        // the cycle market (to -> from) + exchange (from -> to)
+        _evaluate(to, from, found);
+    }
+    _emit(found, start);
+}
+
+void ArbitrageDetector::refresh(const std::vector<currency_pair_t>& pairs)
+{
+    for (const auto& pair : pairs) {
+        auto info = _market.info(pair);
+        info.pair = pair;
+        update(info, _market.ticker(pair));
+    }
+    for (const auto& info : _exchange.info()) {
+        update(info);
+    }
+}
+
+arbitrage_latency_t ArbitrageDetector::latency()
+{
+    std::lock_guard<std::mutex> lock(_mux);
+    return _latency;
+}
+
+}  // namespace at
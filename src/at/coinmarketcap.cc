@@ -16,6 +16,12 @@
 
 namespace at {
 
+void CoinMarketCap::warmup()
+{
+    Request::warmup(_host);
+    Request::warmup(_reverse_host);
+}
+
 std::vector<cm_ticker_t> CoinMarketCap::ticker()
 {
     Request req;
@@ -40,11 +46,26 @@ cm_ticker_t CoinMarketCap::ticker(std::string currency_symbol)
     toupper(currency_symbol);
     auto id = _symbol_to_id.find(currency_symbol);
     currency_symbol = id != _symbol_to_id.end() ? id->second : currency_symbol;
+    req.endpoint(_host + "ticker/");
     json res = req.get(_host + "ticker/" + currency_symbol + "/")[0];
     _throw_error_if_any(res);
     return res;
 }
 
+cm_ticker_changes_t CoinMarketCap::refresh(TickerTable& table, uint32_t start,
+                                            uint32_t limit)
+{
+    Request req;
+    std::ostringstream stream;
+    stream << _host << "ticker/";
+    if (limit > 0) {
+        stream << "?start=" << start << "&limit=" << limit;
+    }
+    json res = req.get(stream.str());
+    _throw_error_if_any(res);
+    return table.apply(res, limit == 0);
+}
+
 gm_data_t CoinMarketCap::global()
 {
     Request req;
@@ -67,6 +88,7 @@ std::vector<cm_market_t> CoinMarketCap::markets(std::string currency_symbol)
         currency_symbol =
             id != _symbol_to_id.end() ? id->second : currency_symbol;
     }
+    req.endpoint(_reverse_host + "currencies/");
     std::string page = req.getHTML(_reverse_host + "currencies/" +
                                    currency_symbol + "/markets/");
 
@@ -0,0 +1,225 @@
+/* Copyright 2017 Paolo Galeone <nessuno@nerdz.eu>. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.*/
+
+#include <algorithm>
+#include <at/consolidatedbook.hpp>
+#include <stdexcept>
+
+namespace at {
+
+// private methods
+
+const ConsolidatedBook::book_t& ConsolidatedBook::_book(
+    const currency_pair_t& pair) const
+{
+    auto it = _books.find(normalize(pair));
+    if (it == _books.end()) {
+        throw std::out_of_range("ConsolidatedBook: no books for " +
+                                pair.str());
+    }
+    return it->second;
+}
+
+// end private methods
+
+ConsolidatedBook::ConsolidatedBook(std::vector<Market*> venues)
+    : _venues(venues)
+{
+}
+
+void ConsolidatedBook::update(std::size_t venue, const currency_pair_t& pair)
+{
+    auto info = _venues.at(venue)->info(pair);
+    // the pair used for the requests (and the orders) on the venue
+    info.pair = pair;
+    update(venue, info, _venues[venue]->orderBook(pair));
+}
+
+void ConsolidatedBook::update(std::size_t venue, const market_info_t& info,
+                              const std::vector<ticker_t>& book)
+{
+    if (venue >= _venues.size()) {
+        throw std::out_of_range("ConsolidatedBook: unknown venue");
+    }
+    remove(venue, info.pair);
+
+    auto& consolidated = _books[normalize(info.pair)];
+    consolidated.venues.resize(_venues.size());
+    auto& levels = consolidated.venues[venue];
+    levels.pair = info.pair;
+    levels.taker_fee = info.taker_fee;
+    levels.min_volume = info.limit.min;
+
+    double fee = info.taker_fee / 100;
+    for (const auto& ticker : book) {
+        if (ticker.bid.amount > 0) {
+            double effective = ticker.bid.price * (1 - fee);
+            levels.bids.push_back(consolidated.bids.emplace(
+                -effective, venue_quotation_t{.venue = venue,
+                                              .price = ticker.bid.price,
+                                              .effective = effective,
+                                              .amount = ticker.bid.amount}));
+        }
+        if (ticker.ask.amount > 0) {
+            double effective = ticker.ask.price * (1 + fee);
+            levels.asks.push_back(consolidated.asks.emplace(
+                effective, venue_quotation_t{.venue = venue,
+                                             .price = ticker.ask.price,
+                                             .effective = effective,
+                                             .amount = ticker.ask.amount}));
+        }
+    }
+}
+
+void ConsolidatedBook::remove(std::size_t venue, const currency_pair_t& pair)
+{
+    auto it = _books.find(normalize(pair));
+    if (it == _books.end() || venue >= it->second.venues.size()) {
+        return;
+    }
+    auto& consolidated = it->second;
+    auto& levels = consolidated.venues[venue];
+    for (auto level : levels.bids) {
+        consolidated.bids.erase(level);
+    }
+    for (auto level : levels.asks) {
+        consolidated.asks.erase(level);
+    }
+    levels.bids.clear();
+    levels.asks.clear();
+}
+
+std::vector<venue_quotation_t> ConsolidatedBook::bids(
+    const currency_pair_t& pair, std::size_t depth) const
+{
+    const auto& side = _book(pair).bids;
+    std::vector<venue_quotation_t> ret;
+    for (auto it = side.begin(); it != side.end() && ret.size() < depth;
+         ++it) {
+        ret.push_back(it->second);
+    }
+    return ret;
+}
+
+std::vector<venue_quotation_t> ConsolidatedBook::asks(
+    const currency_pair_t& pair, std::size_t depth) const
+{
+    const auto& side = _book(pair).asks;
+    std::vector<venue_quotation_t> ret;
+    for (auto it = side.begin(); it != side.end() && ret.size() < depth;
+         ++it) {
+        ret.push_back(it->second);
+    }
+    return ret;
+}
+
+std::vector<child_order_t> ConsolidatedBook::route(const order_t& parent) const
+{
+    const book_t& book = _book(parent.pair);
+    bool buy = parent.action == order_action_t::buy;
+    bool limit = parent.type == order_type_t::limit;
+    const side_t& side = buy ? book.asks : book.bids;
+
+    // volume and worst price per venue. A venue with a volume below its
+    // minimum is excluded and the levels are consumed again, moving its
+    // volume to the next best levels of the other venues: the volume of
+    // the other venues can only grow, hence at most a pass per venue.
+    const std::size_t venues = book.venues.size();
+    std::vector<bool> excluded(venues, false);
+    std::vector<double> volume(venues), price(venues);
+    for (bool rerouted = true; rerouted;) {
+        std::fill(volume.begin(), volume.end(), 0);
+        double remaining = parent.volume;
+        for (auto it = side.begin(); it != side.end() && remaining > 0;
+             ++it) {
+            const auto& level = it->second;
+            if (limit && (buy ? level.effective > parent.price
+                              : level.effective < parent.price)) {
+                break;
+            }
+            if (excluded[level.venue]) {
+                continue;
+            }
+            double quantity = std::min(remaining, level.amount);
+            volume[level.venue] += quantity;
+            price[level.venue] = level.price;
+            remaining -= quantity;
+        }
+
+        rerouted = false;
+        for (std::size_t venue = 0; venue < venues; ++venue) {
+            if (volume[venue] > 0 &&
+                volume[venue] < book.venues[venue].min_volume) {
+                excluded[venue] = true;
+                rerouted = true;
+            }
+        }
+    }
+
+    std::vector<child_order_t> children;
+    for (std::size_t venue = 0; venue < venues; ++venue) {
+        const auto& levels = book.venues[venue];
+        if (volume[venue] <= 0) {
+            continue;
+        }
+        order_t order = {};
+        order.status = tx_status_t::pending;
+        order.type = order_type_t::limit;
+        order.action = parent.action;
+        order.pair = levels.pair;
+        order.volume = volume[venue];
+        order.price = price[venue];
+        children.push_back(child_order_t{.venue = venue, .order = order});
+    }
+    return children;
+}
+
+std::vector<std::exception_ptr> ConsolidatedBook::place(
+    std::vector<child_order_t>& children)
+{
+    std::vector<std::exception_ptr> ret(children.size());
+    // indices of the children of every venue
+    std::map<std::size_t, std::vector<std::size_t>> venues;
+    for (std::size_t i = 0; i < children.size(); ++i) {
+        if (children[i].venue < _venues.size()) {
+            venues[children[i].venue].push_back(i);
+        }
+        else {
+            ret[i] = std::make_exception_ptr(std::out_of_range(
+                "Unknown venue " + std::to_string(children[i].venue)));
+        }
+    }
+
+    for (const auto& venue : venues) {
+        std::vector<order_t> orders;
+        orders.reserve(venue.second.size());
+        for (auto i : venue.second) {
+            orders.push_back(children[i].order);
+        }
+        std::vector<std::exception_ptr> placed;
+        try {
+            placed = _venues[venue.first]->place(orders);
+        }
+        catch (...) {
+            placed.assign(orders.size(), std::current_exception());
+        }
+        for (std::size_t j = 0; j < venue.second.size(); ++j) {
+            children[venue.second[j]].order = orders[j];
+            ret[venue.second[j]] = placed.at(j);
+        }
+    }
+    return ret;
+}
+
+}  // namespace at
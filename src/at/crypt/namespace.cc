@@ -4,20 +4,119 @@
 #include <openssl/hmac.h>
 #include <openssl/sha.h>
 
+#include <cstdint>
+#include <cstring>
+
 namespace at::crypt {
 
 std::vector<unsigned char> sha256(const std::string& data)
 {
     std::vector<unsigned char> digest(SHA256_DIGEST_LENGTH);
 
-    SHA256_CTX ctx;
-    SHA256_Init(&ctx);
-    SHA256_Update(&ctx, data.c_str(), data.length());
-    SHA256_Final(digest.data(), &ctx);
+    // the one-shot functions are not deprecated by OpenSSL 3.0
+    SHA256(reinterpret_cast<const unsigned char*>(data.data()),
+           data.length(), digest.data());
 
     return digest;
 }
 
+namespace {
+
+const uint64_t keccak_round_constants[24] = {
+    0x0000000000000001ULL, 0x0000000000008082ULL, 0x800000000000808aULL,
+    0x8000000080008000ULL, 0x000000000000808bULL, 0x0000000080000001ULL,
+    0x8000000080008081ULL, 0x8000000000008009ULL, 0x000000000000008aULL,
+    0x0000000000000088ULL, 0x0000000080008009ULL, 0x000000008000000aULL,
+    0x000000008000808bULL, 0x800000000000008bULL, 0x8000000000008089ULL,
+    0x8000000000008003ULL, 0x8000000000008002ULL, 0x8000000000000080ULL,
+    0x000000000000800aULL, 0x800000008000000aULL, 0x8000000080008081ULL,
+    0x8000000000008080ULL, 0x0000000080000001ULL, 0x8000000080008008ULL};
+
+const int keccak_rotations[24] = {1,  3,  6,  10, 15, 21, 28, 36,
+                                  45, 55, 2,  14, 27, 41, 56, 8,
+                                  25, 43, 62, 18, 39, 61, 20, 44};
+
+const int keccak_lanes[24] = {10, 7,  11, 17, 18, 3,  5,  16,
+                              8,  21, 24, 4,  15, 23, 19, 13,
+                              12, 2,  20, 14, 22, 9,  6,  1};
+
+inline uint64_t rotl64(uint64_t x, int n) { return (x << n) | (x >> (64 - n)); }
+
+void keccakf(uint64_t state[25])
+{
+    uint64_t bc[5];
+    for (int round = 0; round < 24; ++round) {
+        // theta
+        for (int i = 0; i < 5; ++i) {
+            bc[i] = state[i] ^ state[i + 5] ^ state[i + 10] ^ state[i + 15] ^
+                    state[i + 20];
+        }
+        for (int i = 0; i < 5; ++i) {
+            uint64_t t = bc[(i + 4) % 5] ^ rotl64(bc[(i + 1) % 5], 1);
+            for (int j = 0; j < 25; j += 5) {
+                state[j + i] ^= t;
+            }
+        }
+        // rho and pi
+        uint64_t t = state[1];
+        for (int i = 0; i < 24; ++i) {
+            int j = keccak_lanes[i];
+            uint64_t tmp = state[j];
+            state[j] = rotl64(t, keccak_rotations[i]);
+            t = tmp;
+        }
+        // chi
+        for (int j = 0; j < 25; j += 5) {
+            for (int i = 0; i < 5; ++i) {
+                bc[i] = state[j + i];
+            }
+            for (int i = 0; i < 5; ++i) {
+                state[j + i] ^= (~bc[(i + 1) % 5]) & bc[(i + 2) % 5];
+            }
+        }
+        // iota
+        state[0] ^= keccak_round_constants[round];
+    }
+}
+
+}  // end namespace
+
+std::vector<unsigned char> keccak256(const std::string& data)
+{
+    const std::size_t rate = 136;  // (1600 - 2 * 256) / 8
+    uint64_t state[25] = {};
+
+    auto absorb = [&state](const unsigned char* block) {
+        for (std::size_t i = 0; i < rate / 8; ++i) {
+            uint64_t lane = 0;
+            for (int b = 7; b >= 0; --b) {
+                lane = (lane << 8) | block[i * 8 + b];
+            }
+            state[i] ^= lane;
+        }
+        keccakf(state);
+    };
+
+    const auto* bytes = reinterpret_cast<const unsigned char*>(data.data());
+    std::size_t len = data.length();
+    for (; len >= rate; len -= rate, bytes += rate) {
+        absorb(bytes);
+    }
+
+    // Keccak padding (0x01), SHA3 uses 0x06 instead
+    unsigned char last[rate] = {};
+    std::memcpy(last, bytes, len);
+    last[len] ^= 0x01;
+    last[rate - 1] ^= 0x80;
+    absorb(last);
+
+    std::vector<unsigned char> digest(32);
+    for (std::size_t i = 0; i < digest.size(); ++i) {
+        digest[i] = static_cast<unsigned char>(state[i / 8] >> (8 * (i % 8)));
+    }
+    return digest;
+}
+
 std::vector<unsigned char> base64_decode(const std::string& data)
 {
     BIO* b64 = BIO_new(BIO_f_base64());
@@ -63,13 +162,8 @@ std::vector<unsigned char> hmac_sha512(const std::vector<unsigned char>& data,
     unsigned int len = EVP_MAX_MD_SIZE;
     std::vector<unsigned char> digest(len);
 
-    auto ctx = HMAC_CTX_new();
-
-    HMAC_Init_ex(ctx, key.data(), key.size(), EVP_sha512(), NULL);
-    HMAC_Update(ctx, data.data(), data.size());
-    HMAC_Final(ctx, digest.data(), &len);
-
-    HMAC_CTX_free(ctx);
+    HMAC(EVP_sha512(), key.data(), static_cast<int>(key.size()), data.data(),
+         data.size(), digest.data(), &len);
 
     return digest;
 }
@@ -0,0 +1,49 @@
+/* Copyright 2017 Paolo Galeone <nessuno@nerdz.eu>. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.*/
+
+#include <algorithm>
+#include <at/deadline.hpp>
+
+namespace at {
+
+namespace {
+
+// deadline of the calling thread, max() if none
+thread_local std::chrono::steady_clock::time_point current =
+    std::chrono::steady_clock::time_point::max();
+
+}  // namespace
+
+Deadline::Deadline(std::chrono::steady_clock::time_point at)
+    : _previous(current)
+{
+    current = std::min(current, at);
+}
+
+Deadline::~Deadline() { current = _previous; }
+
+bool Deadline::active()
+{
+    return current != std::chrono::steady_clock::time_point::max();
+}
+
+std::chrono::nanoseconds Deadline::remaining()
+{
+    if (!active()) {
+        return std::chrono::nanoseconds::max();
+    }
+    return current - std::chrono::steady_clock::now();
+}
+
+}  // namespace at
@@ -0,0 +1,263 @@
+/* Copyright 2017 Paolo Galeone <nessuno@nerdz.eu>. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.*/
+
+#include <algorithm>
+#include <at/depositwatcher.hpp>
+
+namespace at {
+
+namespace {
+
+const std::size_t wheel_slots = 256;
+
+bool is_final(deposit_status_t status)
+{
+    return status == deposit_status_t::complete ||
+           status == deposit_status_t::failed ||
+           status == deposit_status_t::expired;
+}
+
+}  // end namespace
+
+// private methods
+
+void DepositWatcher::_schedule(const hash_t& address, uint64_t generation,
+                               std::chrono::milliseconds delay)
+{
+    uint64_t ticks = static_cast<uint64_t>(
+        (delay.count() + _intervals.tick.count() - 1) /
+        _intervals.tick.count());
+    ticks = std::max<uint64_t>(ticks, 1);
+    _wheel[(_cursor + ticks) % wheel_slots].push_back(wheel_entry_t{
+        .address = address,
+        .rounds = (ticks - 1) / wheel_slots,
+        .generation = generation,
+    });
+}
+
+std::chrono::milliseconds DepositWatcher::_interval(
+    deposit_status_t status, uint32_t seconds_remaining) const
+{
+    switch (status) {
+        case deposit_status_t::no_deposists: {
+            if (seconds_remaining == 0) {
+                return _intervals.max;
+            }
+            // ~10 polls before the expiration: the closer the expiration,
+            // the shorter the interval
+            std::chrono::milliseconds interval(seconds_remaining * 100);
+            return std::clamp(interval, _intervals.min, _intervals.max);
+        }
+        case deposit_status_t::settled:
+            return _intervals.settled;
+        default:
+            return _intervals.min;
+    }
+}
+
+void DepositWatcher::_timer_loop()
+{
+    std::unique_lock<std::mutex> lock(_mux);
+    auto next = std::chrono::steady_clock::now() + _intervals.tick;
+    while (!_cv.wait_until(lock, next, [this] { return _stop; })) {
+        next += _intervals.tick;
+        _cursor = (_cursor + 1) % wheel_slots;
+
+        auto& slot = _wheel[_cursor];
+        std::size_t kept = 0;
+        bool ready = false;
+        for (auto& entry : slot) {
+            if (entry.rounds > 0) {
+                --entry.rounds;
+                slot[kept++] = std::move(entry);
+            }
+            else {
+                _ready.emplace_back(std::move(entry.address), entry.generation);
+                ready = true;
+            }
+        }
+        slot.resize(kept);
+        if (ready) {
+            _cv.notify_all();
+        }
+    }
+}
+
+void DepositWatcher::_worker_loop()
+{
+    std::unique_lock<std::mutex> lock(_mux);
+    while (true) {
+        _cv.wait(lock, [this] { return _stop || !_ready.empty(); });
+        if (_stop) {
+            return;
+        }
+        auto [address, generation] = std::move(_ready.front());
+        _ready.pop_front();
+        auto it = _watched.find(address);
+        if (it == _watched.end() || it->second.generation != generation ||
+            it->second.busy) {
+            continue;
+        }
+        it->second.busy = true;
+        lock.unlock();
+
+        bool ok = true;
+        deposit_status_t status = deposit_status_t::no_deposists;
+        uint32_t seconds_remaining = 0;
+        try {
+            status = _exchange.depositStatus(address);
+            if (status == deposit_status_t::no_deposists) {
+                auto remaining = _exchange.timeRemeaningForTransaction(address);
+                seconds_remaining = remaining.second;
+                if (remaining.first == deposit_status_t::expired) {
+                    status = deposit_status_t::expired;
+                }
+            }
+        }
+        catch (const std::exception&) {
+            ok = false;
+        }
+
+        lock.lock();
+        it = _watched.find(address);
+        if (it == _watched.end() || it->second.generation != generation) {
+            continue;
+        }
+        auto& watched = it->second;
+        if (!ok) {
+            // back off, up to the maximum interval or the interval of the
+            // status if longer: a failure never shortens the interval
+            const auto cap = std::max(
+                _intervals.max,
+                _interval(watched.status, watched.seconds_remaining));
+            watched.interval = std::max(
+                watched.interval, std::min(watched.interval * 2, cap));
+            watched.busy = false;
+            _schedule(address, generation, watched.interval);
+            continue;
+        }
+
+        deposit_event_t event{
+            .address = address,
+            .previous = watched.status,
+            .current = status,
+            .seconds_remaining = seconds_remaining,
+        };
+        watched.status = status;
+        watched.seconds_remaining = seconds_remaining;
+        watched.interval = _interval(status, seconds_remaining);
+        if (event.previous == event.current) {
+            watched.busy = false;
+            _schedule(address, generation, watched.interval);
+            continue;
+        }
+        const bool done = is_final(status);
+        if (done) {
+            _watched.erase(it);
+        }
+
+        // The next poll is scheduled once the callback returns, hence the
+        // events of an address are delivered in order and one at a time
+        lock.unlock();
+        try {
+            _callback(event);
+        }
+        catch (...) {
+            // an exception of the callback must not terminate the worker:
+            // the address is polled again as if the callback returned
+        }
+        lock.lock();
+        if (done) {
+            continue;
+        }
+        it = _watched.find(address);
+        if (it != _watched.end() && it->second.generation == generation) {
+            it->second.busy = false;
+            _schedule(address, generation, it->second.interval);
+        }
+    }
+}
+
+// end private methods
+
+DepositWatcher::DepositWatcher(
+    Exchange& exchange, std::function<void(const deposit_event_t&)> callback,
+    std::size_t workers, deposit_watcher_intervals_t intervals)
+    : _exchange(exchange),
+      _callback(callback),
+      _intervals(intervals),
+      _wheel(wheel_slots)
+{
+    if (_intervals.tick.count() <= 0) {
+        throw std::invalid_argument("DepositWatcher: tick must be positive");
+    }
+    _timer = std::thread(&DepositWatcher::_timer_loop, this);
+    for (std::size_t i = 0; i < std::max<std::size_t>(workers, 1); ++i) {
+        _workers.emplace_back(&DepositWatcher::_worker_loop, this);
+    }
+}
+
+DepositWatcher::~DepositWatcher()
+{
+    {
+        std::lock_guard<std::mutex> lock(_mux);
+        _stop = true;
+    }
+    _cv.notify_all();
+    _timer.join();
+    for (auto& worker : _workers) {
+        worker.join();
+    }
+}
+
+void DepositWatcher::watch(const hash_t& address)
+{
+    watch(std::vector<hash_t>{address});
+}
+
+void DepositWatcher::watch(const std::vector<hash_t>& addresses)
+{
+    {
+        std::lock_guard<std::mutex> lock(_mux);
+        for (const auto& address : addresses) {
+            if (_watched.find(address) != _watched.end()) {
+                continue;
+            }
+            uint64_t generation = ++_generation;
+            _watched[address] = watched_t{
+                .status = deposit_status_t::no_deposists,
+                .seconds_remaining = 0,
+                .interval = _intervals.min,
+                .generation = generation,
+                .busy = false,
+            };
+            _ready.emplace_back(address, generation);
+        }
+    }
+    _cv.notify_all();
+}
+
+void DepositWatcher::unwatch(const hash_t& address)
+{
+    std::lock_guard<std::mutex> lock(_mux);
+    _watched.erase(address);
+}
+
+std::size_t DepositWatcher::size()
+{
+    std::lock_guard<std::mutex> lock(_mux);
+    return _watched.size();
+}
+
+}  // namespace at
@@ -0,0 +1,29 @@
+/* Copyright 2017 Paolo Galeone <nessuno@nerdz.eu>. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.*/
+
+#include <at/exceptions.hpp>
+#include <at/metrics.hpp>
+
+namespace at {
+
+void Thrower::_throw_error_if_any(const json& res)
+{
+    auto message = _error_message(res);
+    if (!message.empty()) {
+        Metrics::add(metric_t::response_errors);
+        throw response_error(message);
+    }
+}
+
+}  // namespace at
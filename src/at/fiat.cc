@@ -13,90 +13,202 @@
  * limitations under the License.*/
 
 #include <at/fiat.hpp>
+#include <limits>
 
 namespace at {
 
-void Fiat::_update()
+namespace {
+
+// Whether Frankfurt is on summer time (CEST) at t: from 01:00 UTC of the
+// last sunday of march to 01:00 UTC of the last sunday of october
+bool summer_time(std::time_t t)
+{
+    std::tm tm;
+    gmtime_r(&t, &tm);
+    auto last_sunday = [&tm](int month) {
+        // march and october have 31 days
+        std::tm day{};
+        day.tm_year = tm.tm_year;
+        day.tm_mon = month;
+        day.tm_mday = 31;
+        day.tm_hour = 1;
+        std::time_t last = timegm(&day);
+        gmtime_r(&last, &day);
+        return last - day.tm_wday * 24 * 60 * 60;
+    };
+    return t >= last_sunday(2) && t < last_sunday(9);
+}
+
+}  // end namespace
+
+// private methods
+
+std::shared_ptr<const fiat_rates_t> Fiat::_fetch() const
+{
+    Request req;
+    std::string page =
+        req.getHTML(_host + "stats/eurofxref/eurofxref-daily.xml");
+    auto previous = std::atomic_load(&_rates);
+    return std::make_shared<const fiat_rates_t>(parse(page, previous.get()));
+}
+
+std::time_t Fiat::_next_publication(std::time_t now)
 {
-    // save the document & today date, at the 14:15 CET (12:15 GMT), ref:
+    // The reference rates are published every working day at 14:15
+    // Frankfurt time: 13:15 UTC (CET) or 12:15 UTC (CEST), ref:
     // https://www.ecb.europa.eu/stats/policy_and_exchange_rates/euro_reference_exchange_rates/html/index.en.html
-    const char *precise_format = "%Y-%m-%d %H:%M";
-    std::time_t now = std::time(0);
-    std::tm *now_tm = std::gmtime(&now);
-    std::ostringstream oss;
-    const char *day_format = "%Y-%m-%d";
-    oss << std::put_time(now_tm, day_format);
-    std::tm tm{};  // initialize value
-    std::stringstream ss;
-    ss << oss.str();
-    ss << " 12:15";
-    ss >> std::get_time(&tm, precise_format);
-    auto current_date = std::mktime(&tm);
-
-    if (labs(_current_date - current_date) < 24 * 60 * 60) {
-        Request req;
-        std::string page =
-            req.getHTML(_host + "stats/eurofxref/eurofxref-daily.xml");
-
-        rapidxml::xml_document<char> doc;
-        auto constant_page = page.c_str();
-        char *ptr_page = new char[page.length() + 1];
-        std::memcpy(ptr_page, constant_page, page.length() + 1);
-        doc.parse<0>(ptr_page);
-        auto cube = doc.first_node()->first_node("Cube");
-        if (!cube) {
-            throw std::runtime_error("Unable to find Cube element on " + _host +
-                                     "stats/eurofxref/eurofxref-daily.xml");
+    // gmtime_r: this runs on the refresh thread, gmtime is not reentrant
+    std::tm tm;
+    gmtime_r(&now, &tm);
+    tm.tm_hour = 13;
+    tm.tm_min = 15;
+    tm.tm_sec = 0;
+    for (std::time_t day = timegm(&tm);; day += 24 * 60 * 60) {
+        std::time_t next = summer_time(day) ? day - 60 * 60 : day;
+        gmtime_r(&next, &tm);
+        // skip saturday and sunday
+        if (next > now && tm.tm_wday != 6 && tm.tm_wday != 0) {
+            return next;
         }
+    }
+}
 
-        cube = cube->first_node("Cube");
-        if (!cube) {
-            throw std::runtime_error(
-                "Unable to find Cube element under Cube element on " + _host +
-                "stats/eurofxref/eurofxref-daily.xml");
+void Fiat::_refresh_loop()
+{
+    // If at the publication time the rates of the day are not there yet,
+    // retry every 15 minutes for at most an hour
+    const int max_retries = 4;
+    const std::time_t retry_delay = 15 * 60;
+
+    int retries = 0;
+    std::time_t wakeup = _next_publication(std::time(nullptr));
+    std::unique_lock<std::mutex> lock(_mux);
+    while (!_cv.wait_until(lock, std::chrono::system_clock::from_time_t(wakeup),
+                           [this] { return _stop; })) {
+        lock.unlock();
+        bool published = false;
+        try {
+            auto rates = _fetch();
+            published = rates->date >= wakeup - wakeup % (24 * 60 * 60);
+            std::atomic_store(&_rates, rates);
         }
-        oss.str("");
-        oss.clear();
-
-        ss.str("");
-        ss.clear();
-
-        tm = {};
-        ss << cube->first_attribute("time")->value();
-        ss << " 12:15";
-        ss >> std::get_time(&tm, precise_format);
-
-        // parse cubes
-        auto cubes = cube->first_node("Cube");
-        if (!cubes) {
-            throw std::runtime_error(
-                "Unable to find Cube element list under Cube->Cube tag on " +
-                _host + "stats/eurofxref/eurofxref-daily.xml");
+        catch (...) {
+            // keep serving the current snapshot
         }
+        lock.lock();
 
-        for (auto cube = cubes; cube; cube = cube->next_sibling()) {
-            auto currency =
-                std::string(cube->first_attribute("currency")->value());
-            toupper(currency);
-            auto rate = std::stod(cube->first_attribute("rate")->value());
-            _eur_to_currency_rate[currency] = rate;
+        if (!published && retries < max_retries) {
+            ++retries;
+            wakeup += retry_delay;
+        }
+        else {
+            retries = 0;
+            wakeup = _next_publication(std::time(nullptr));
         }
-        _eur_to_currency_rate["EUR"] = 1.;
-        _current_date = std::mktime(&tm);
     }
 }
 
-// rate returns the exchange rate of the fiat pair
-double Fiat::rate(const currency_pair_t &pair)
+// end private methods
+
+Fiat::Fiat(std::string host) : _host(host)
+{
+    _rates = _fetch();
+    _refresher = std::thread(&Fiat::_refresh_loop, this);
+}
+
+Fiat::~Fiat()
+{
+    {
+        std::lock_guard<std::mutex> lock(_mux);
+        _stop = true;
+    }
+    _cv.notify_all();
+    _refresher.join();
+}
+
+fiat_rates_t Fiat::parse(const std::string &xml, const fiat_rates_t *previous)
 {
-    try {
-        _update();
+    // rapidxml parses in place: it needs a mutable, null terminated copy
+    std::vector<char> buffer(xml.begin(), xml.end());
+    buffer.push_back('\0');
+
+    rapidxml::xml_document<char> doc;
+    doc.parse<0>(buffer.data());
+    auto root = doc.first_node();
+    auto cube = root ? root->first_node("Cube") : nullptr;
+    if (!cube) {
+        throw std::runtime_error(
+            "Unable to find Cube element in eurofxref-daily.xml");
+    }
+
+    cube = cube->first_node("Cube");
+    if (!cube) {
+        throw std::runtime_error(
+            "Unable to find Cube element under Cube element in "
+            "eurofxref-daily.xml");
+    }
+
+    fiat_rates_t rates;
+    std::tm tm{};  // initialize value
+    std::istringstream ss(cube->first_attribute("time")->value());
+    ss >> std::get_time(&tm, "%Y-%m-%d");
+    rates.date = timegm(&tm);
+
+    // parse cubes
+    auto cubes = cube->first_node("Cube");
+    if (!cubes) {
+        throw std::runtime_error(
+            "Unable to find Cube element list under Cube->Cube tag in "
+            "eurofxref-daily.xml");
+    }
+
+    for (auto cube = cubes; cube; cube = cube->next_sibling()) {
+        auto currency = std::string(cube->first_attribute("currency")->value());
+        toupper(currency);
+        rates.eur_to_currency[currency] =
+            std::stod(cube->first_attribute("rate")->value());
+    }
+    rates.eur_to_currency["EUR"] = 1.;
+
+    // cross-rate matrix: first the ids already assigned, then the new ones
+    if (previous) {
+        rates.currencies = previous->currencies;
+        rates.ids = previous->ids;
+    }
+    for (const auto &pair : rates.eur_to_currency) {
+        if (rates.ids.find(pair.first) == rates.ids.end()) {
+            rates.ids[pair.first] =
+                static_cast<fiat_id_t>(rates.currencies.size());
+            rates.currencies.push_back(pair.first);
+        }
+    }
+
+    const std::size_t n = rates.currencies.size();
+    std::vector<double> eur_to(n, std::numeric_limits<double>::quiet_NaN());
+    for (const auto &pair : rates.eur_to_currency) {
+        eur_to[rates.ids[pair.first]] = pair.second;
     }
-    catch (...) {
-        // if here  _eur_to_currency_rate was aready filled by
-        // the constructor, hence let's use the old values
+    rates.cross.resize(n * n);
+    for (std::size_t to = 0; to < n; ++to) {
+        for (std::size_t from = 0; from < n; ++from) {
+            rates.cross[to * n + from] = eur_to[to] / eur_to[from];
+        }
     }
+    return rates;
+}
+
+std::shared_ptr<const fiat_rates_t> Fiat::snapshot() const
+{
+    return std::atomic_load(&_rates);
+}
 
+void Fiat::warmup() { Request::warmup(_host); }
+
+void Fiat::update() { std::atomic_store(&_rates, _fetch()); }
+
+// rate returns the exchange rate of the fiat pair
+double Fiat::rate(const currency_pair_t &pair) const
+{
     std::string base, quote;
     base = pair.first;
     quote = pair.second;
@@ -104,15 +216,68 @@ double Fiat::rate(const currency_pair_t &pair)
     toupper(base);
     toupper(quote);
 
-    if (base == "EUR") {
-        return 1. / _eur_to_currency_rate[quote];
+    auto rates = std::atomic_load(&_rates);
+    return rates->eur_to_currency.at(base) / rates->eur_to_currency.at(quote);
+}
+
+fiat_id_t Fiat::id(std::string currency) const
+{
+    toupper(currency);
+    auto rates = std::atomic_load(&_rates);
+    return rates->ids.at(currency);
+}
+
+double Fiat::rate(fiat_id_t base, fiat_id_t quote) const
+{
+    // rate(base, quote) = eur_to[base] / eur_to[quote], that's the amount
+    // of base for 1 unit of quote
+    auto rates = std::atomic_load(&_rates);
+    const std::size_t size = rates->currencies.size();
+    if (base >= size) {
+        throw std::out_of_range("Fiat: unknown currency id " +
+                                std::to_string(base));
+    }
+    if (quote >= size) {
+        throw std::out_of_range("Fiat: unknown currency id " +
+                                std::to_string(quote));
+    }
+    return rates->cross[base * size + quote];
+}
+
+void Fiat::convert(const double *amounts, const fiat_id_t *from, std::size_t n,
+                   fiat_id_t to, double *out) const
+{
+    auto rates = std::atomic_load(&_rates);
+    const std::size_t size = rates->currencies.size();
+    if (to >= size) {
+        throw std::out_of_range("Fiat: unknown currency id " +
+                                std::to_string(to));
+    }
+    for (std::size_t i = 0; i < n; ++i) {
+        if (from[i] >= size) {
+            throw std::out_of_range("Fiat: unknown currency id " +
+                                    std::to_string(from[i]));
+        }
     }
 
-    if (quote == "EUR") {
-        return _eur_to_currency_rate[base];
+    // row `to` of the matrix contains the factors from every currency
+    const double *factor = rates->cross.data() + to * size;
+    for (std::size_t i = 0; i < n; ++i) {
+        out[i] = amounts[i] * factor[from[i]];
     }
+}
 
-    return _eur_to_currency_rate[base] / _eur_to_currency_rate[quote];
+std::vector<double> Fiat::convert(const std::vector<double> &amounts,
+                                  const std::vector<fiat_id_t> &from,
+                                  fiat_id_t to) const
+{
+    if (amounts.size() != from.size()) {
+        throw std::invalid_argument(
+            "Fiat: amounts and currencies must have the same size");
+    }
+    std::vector<double> out(amounts.size());
+    convert(amounts.data(), from.data(), amounts.size(), to, out.data());
+    return out;
 }
 
 }  // namespace at
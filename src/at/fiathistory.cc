@@ -0,0 +1,277 @@
+/* Copyright 2017 Paolo Galeone <nessuno@nerdz.eu>. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.*/
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <at/fiathistory.hpp>
+#include <cerrno>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <limits>
+#include <rapidxml.hpp>
+#include <set>
+
+namespace at {
+
+namespace {
+
+typedef struct {
+    char magic[4];
+    uint32_t version;
+    uint32_t currencies;
+    uint32_t days;
+} fiat_history_header_t;
+
+// Size of the currencies block, padded to keep the columns 8 bytes aligned
+std::size_t currencies_size(uint32_t currencies)
+{
+    std::size_t size = static_cast<std::size_t>(currencies) * 4;
+    return (size + 7) & ~static_cast<std::size_t>(7);
+}
+
+}  // end namespace
+
+// private methods
+
+double FiatHistory::_eur_to(const std::string& currency,
+                            std::time_t date) const
+{
+    if (currency == "EUR") {
+        return 1.;
+    }
+    auto column = _currency_column.find(currency);
+    if (column == _currency_column.end()) {
+        throw std::out_of_range("FiatHistory: unknown currency " + currency);
+    }
+
+    // last day <= date
+    auto day = std::upper_bound(_dates, _dates + _days, date);
+    if (day == _dates) {
+        throw std::out_of_range("FiatHistory: no rates before " +
+                                std::to_string(date));
+    }
+    std::size_t row = static_cast<std::size_t>(day - _dates) - 1;
+    double rate = _rates[column->second * _days + row];
+    if (std::isnan(rate)) {
+        throw std::out_of_range("FiatHistory: no rate for " + currency +
+                                " at " + std::to_string(date));
+    }
+    return rate;
+}
+
+// end private methods
+
+FiatHistory::FiatHistory(const std::string& path)
+{
+    _fd = open(path.c_str(), O_RDONLY);
+    if (_fd < 0) {
+        throw std::runtime_error("FiatHistory: unable to open " + path + ": " +
+                                 strerror(errno));
+    }
+    struct stat st;
+    if (fstat(_fd, &st) != 0 ||
+        static_cast<std::size_t>(st.st_size) < sizeof(fiat_history_header_t)) {
+        close(_fd);
+        throw std::runtime_error("FiatHistory: invalid file " + path);
+    }
+    _size = static_cast<std::size_t>(st.st_size);
+    _data = mmap(nullptr, _size, PROT_READ, MAP_SHARED, _fd, 0);
+    if (_data == MAP_FAILED) {
+        close(_fd);
+        throw std::runtime_error("FiatHistory: unable to mmap " + path + ": " +
+                                 strerror(errno));
+    }
+
+    const char* base = static_cast<const char*>(_data);
+    const auto* header = reinterpret_cast<const fiat_history_header_t*>(base);
+    // Every block is checked against the size of the file before adding
+    // the next one, thus a corrupted header can't overflow the offsets
+    const std::size_t days = header->days;
+    const std::size_t currencies = header->currencies;
+    std::size_t left = _size - sizeof(fiat_history_header_t);
+    bool valid = std::memcmp(header->magic, "ATFX", 4) == 0 &&
+                 header->version == _version &&
+                 currencies_size(header->currencies) <= left;
+    if (valid) {
+        left -= currencies_size(header->currencies);
+        valid = days <= left / sizeof(int64_t);
+    }
+    if (valid) {
+        left -= days * sizeof(int64_t);
+        valid = (days == 0 || currencies <= left / sizeof(double) / days) &&
+                days * currencies * sizeof(double) == left;
+    }
+    if (!valid) {
+        munmap(_data, _size);
+        close(_fd);
+        throw std::runtime_error("FiatHistory: invalid file " + path);
+    }
+
+    const char* codes = base + sizeof(fiat_history_header_t);
+    for (uint32_t i = 0; i < header->currencies; ++i) {
+        const char* code = codes + i * 4;
+        _currency_column[std::string(code, strnlen(code, 4))] = i;
+    }
+    _days = header->days;
+    _dates = reinterpret_cast<const int64_t*>(
+        codes + currencies_size(header->currencies));
+    _rates = reinterpret_cast<const double*>(_dates + _days);
+}
+
+FiatHistory::~FiatHistory()
+{
+    munmap(_data, _size);
+    close(_fd);
+}
+
+void FiatHistory::download(const std::string& path, bool full,
+                           const std::string& host)
+{
+    Request req;
+    write(path, req.getHTML(host + (full ? "stats/eurofxref/eurofxref-hist.xml"
+                                         : "stats/eurofxref/"
+                                           "eurofxref-hist-90d.xml")));
+}
+
+void FiatHistory::write(const std::string& path, const std::string& xml)
+{
+    // rapidxml parses in place: it needs a mutable, null terminated copy
+    std::vector<char> buffer(xml.begin(), xml.end());
+    buffer.push_back('\0');
+
+    rapidxml::xml_document<char> doc;
+    doc.parse<0>(buffer.data());
+    auto root = doc.first_node();
+    auto cube = root ? root->first_node("Cube") : nullptr;
+    if (!cube) {
+        throw std::runtime_error("Unable to find Cube element in ECB history");
+    }
+
+    // <Cube time="YYYY-MM-DD"><Cube currency="USD" rate="1.1"/>...</Cube>
+    std::map<std::time_t, std::map<std::string, double>> days;
+    std::set<std::string> currencies;
+    for (auto day = cube->first_node("Cube"); day;
+         day = day->next_sibling("Cube")) {
+        std::tm tm{};
+        std::istringstream ss(day->first_attribute("time")->value());
+        ss >> std::get_time(&tm, "%Y-%m-%d");
+        auto& rates = days[timegm(&tm)];
+        for (auto rate = day->first_node("Cube"); rate;
+             rate = rate->next_sibling("Cube")) {
+            auto currency =
+                std::string(rate->first_attribute("currency")->value());
+            toupper(currency);
+            rates[currency] = std::stod(rate->first_attribute("rate")->value());
+            currencies.insert(currency);
+        }
+    }
+
+    fiat_history_header_t header{};
+    std::memcpy(header.magic, "ATFX", 4);
+    header.version = _version;
+    header.currencies = static_cast<uint32_t>(currencies.size());
+    header.days = static_cast<uint32_t>(days.size());
+
+    std::vector<char> codes(currencies_size(header.currencies), '\0');
+    std::size_t i = 0;
+    for (const auto& currency : currencies) {
+        std::strncpy(codes.data() + i * 4, currency.c_str(), 4);
+        ++i;
+    }
+
+    std::vector<int64_t> dates;
+    dates.reserve(days.size());
+    for (const auto& day : days) {
+        dates.push_back(day.first);
+    }
+
+    std::vector<double> rates;
+    rates.reserve(currencies.size() * days.size());
+    for (const auto& currency : currencies) {
+        for (const auto& day : days) {
+            auto rate = day.second.find(currency);
+            rates.push_back(rate == day.second.end()
+                                ? std::numeric_limits<double>::quiet_NaN()
+                                : rate->second);
+        }
+    }
+
+    // write a temporary file and rename it, so readers never see a
+    // partial file
+    const std::string tmp = path + ".tmp";
+    {
+        std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        out.write(codes.data(), codes.size());
+        out.write(reinterpret_cast<const char*>(dates.data()),
+                  dates.size() * sizeof(int64_t));
+        out.write(reinterpret_cast<const char*>(rates.data()),
+                  rates.size() * sizeof(double));
+        // the last write may fail only when the buffer is flushed
+        out.close();
+        if (!out) {
+            throw std::runtime_error("FiatHistory: unable to write " + tmp);
+        }
+    }
+    if (std::rename(tmp.c_str(), path.c_str()) != 0) {
+        throw std::runtime_error("FiatHistory: unable to rename " + tmp +
+                                 ": " + strerror(errno));
+    }
+}
+
+double FiatHistory::rate(const currency_pair_t& pair, std::time_t date) const
+{
+    std::string base, quote;
+    base = pair.first;
+    quote = pair.second;
+
+    toupper(base);
+    toupper(quote);
+
+    // Same semantic of Fiat::rate
+    return _eur_to(base, date) / _eur_to(quote, date);
+}
+
+std::time_t FiatHistory::begin() const
+{
+    if (_days == 0) {
+        throw std::out_of_range("FiatHistory: empty history");
+    }
+    return _dates[0];
+}
+
+std::time_t FiatHistory::end() const
+{
+    if (_days == 0) {
+        throw std::out_of_range("FiatHistory: empty history");
+    }
+    return _dates[_days - 1];
+}
+
+std::vector<std::string> FiatHistory::currencies() const
+{
+    std::vector<std::string> ret;
+    for (const auto& pair : _currency_column) {
+        ret.push_back(pair.first);
+    }
+    return ret;
+}
+
+}  // namespace at
@@ -16,8 +16,51 @@
 
 namespace at {
 
+namespace {
+
+// largest batches accepted by AddOrderBatch and CancelOrderBatch
+constexpr std::size_t max_placed = 15;
+constexpr std::size_t max_canceled = 50;
+
+// Private methods that only read the account: retried also once sent
+bool is_read_only(const std::string& method)
+{
+    return method == "Balance" || method == "OpenOrders" ||
+           method == "ClosedOrders" || method == "DepositMethods";
+}
+
+}  // namespace
+
 // private methods
 
+void Kraken::_throw_error_if_any(const json& res)
+{
+    auto message = _error_message(res);
+    if (message.empty()) {
+        return;
+    }
+    // Kraken is shit and even when status code should be 500
+    // it might return a status code 200 with a json error
+    // If the error is present thrower::_throw_err_if_any
+    // would throw a response error, even if the request failed
+    // not because of the malformed url request but because the
+    // server is busy, or unavailable.
+    //
+    // In this case a server error must be thrown, not a response error
+    if (message.find("EService:Unavailable") != std::string::npos ||
+        message.find("Service:Busy") != std::string::npos) {
+        Metrics::add(metric_t::server_errors);
+        throw server_error(message);
+    }
+    // EAPI:Rate limit exceeded, EOrder:Rate limit exceeded, ...
+    if (message.find("Rate limit exceeded") != std::string::npos) {
+        Metrics::add(metric_t::server_errors);
+        throw rate_limit_error(message);
+    }
+    Metrics::add(metric_t::response_errors);
+    throw response_error(message);
+}
+
 std::string Kraken::_nonce()
 {
     std::ostringstream oss;
@@ -106,40 +149,115 @@ json Kraken::_request(std::string method,
         throw std::runtime_error("API KEY/SECRET required for private methods");
     }
 
-    // acquire lock for mutual exclusive access of _request_counter:
-    // Nonce counter should be incremented AFTER the server knows the current
-    // request. Hence the _request method that calls the _nonce methdo acquires
-    // the lock on the mutex and locks any other request until a response has
-    // not been received by the server
-    std::unique_lock<std::mutex> lock(_mux);
-    ++_request_counter;
-    auto private_method = "private/" + method;
-    auto path = "/" + _version + "/" + private_method;
-    auto nonce = _nonce();
-    params.push_back({"nonce", nonce});
-
-    std::list<std::string> headers;
-    headers.push_back("API-Key: " + _api_key);
-    headers.push_back("API-Sign: " + _sign(path, nonce, [&]() {
-                          std::string ret;
-                          for (const auto& key_value : params) {
-                              ret.append(key_value.first + "=" +
-                                         key_value.second + "&");
-                          }
-                          ret.pop_back();
-                          return ret;
-                      }()));
-    Request req(headers);
-    return req.post(_host + private_method, params);
+    // every attempt is signed with a new nonce. Only the read only methods
+    // are idempotent: any other method (placing or cancelling orders,
+    // CancelAll, ...) is never retried once sent
+    return Request::retry_policy()->run(is_read_only(method), [&]() {
+        // acquire lock for mutual exclusive access of _request_counter:
+        // Nonce counter should be incremented AFTER the server knows the
+        // current request. Hence the _request method that calls the _nonce
+        // methdo acquires the lock on the mutex and locks any other request
+        // until a response has not been received by the server
+        std::unique_lock<std::mutex> lock(_mux);
+        ++_request_counter;
+        auto private_method = "private/" + method;
+        auto path = "/" + _version + "/" + private_method;
+        auto nonce = _nonce();
+        _body.clear();
+        for (const auto& key_value : params) {
+            _body.add(key_value.first, key_value.second);
+        }
+        _body.add("nonce", nonce);
+
+        // the signature covers the bytes sent, as encoded
+        std::list<std::string> headers;
+        headers.push_back("API-Key: " + _api_key);
+        headers.push_back("API-Sign: " + _sign(path, nonce, _body.str()));
+        Request req(headers);
+        req.check(_throw_error_if_any);
+        return req.post(_host + private_method, _body);
+    });
+}
+
+json Kraken::_json_request(const std::string& method, json body)
+{
+    if (_api_key.empty() || _api_secret.empty()) {
+        throw std::runtime_error("API KEY/SECRET required for private methods");
+    }
+
+    return Request::retry_policy()->run(false, [&]() {
+        std::unique_lock<std::mutex> lock(_mux);
+        ++_request_counter;
+        auto private_method = "private/" + method;
+        auto path = "/" + _version + "/" + private_method;
+        auto nonce = _nonce();
+        body["nonce"] = nonce;
+
+        // Request::post serializes body as dump does
+        std::list<std::string> headers;
+        headers.push_back("API-Key: " + _api_key);
+        headers.push_back("API-Sign: " + _sign(path, nonce, body.dump()));
+        Request req(headers);
+        req.check(_throw_error_if_any);
+        return req.post(_host + private_method, body);
+    });
+}
+
+std::vector<std::pair<std::string, std::string>> Kraken::_order_params(
+    order_t& order)
+{
+    _sanitize_pair(order.pair);
+    std::vector<std::pair<std::string, std::string>> params;
+    params.push_back({"pair", order.pair.first + order.pair.second});
+    std::stringstream ss;
+    ss << order.action;
+    params.push_back({"type", ss.str()});
+    ss.str("");
+    ss.clear();
+    ss << order.type;
+    params.push_back({"ordertype", ss.str()});
+    params.push_back({"volume", std::to_string(order.volume)});
+
+    switch (order.type) {
+        case at::order_type_t::market: {
+            if (order.volume <= 0) {
+                throw std::runtime_error("order.volume can't be <= 0");
+            }
+            break;
+        }
+        case at::order_type_t::limit: {
+            if (order.volume * order.price <= 0) {
+                throw std::runtime_error(
+                    "order.volume * order.price can't be <= 0");
+            }
+            ss.str("");
+            ss.clear();
+            // hopefully a precision of 2 is not too much for the current
+            // pair. Kraken just give the precision for certain pairs
+            // but other pairs have no specification at all.
+            int precision = 2;
+            try {
+                precision = _maxPrecision.at(order.pair);
+            }
+            catch (const std::out_of_range&) {
+            }
+            ss << std::setprecision(precision) << order.price;
+            params.push_back({"price", ss.str()});
+            break;
+        }
+    }
+    return params;
 }
 
 // end private methods
 
+void Kraken::warmup() { Request::warmup(_host); }
+
 std::time_t Kraken::time() const
 {
     Request req;
+    req.check(_throw_error_if_any);
     json res = req.get(_host + "public/Time");
-    _throw_error_if_any(res);
     res = res["result"];
     std::time_t timestamp = res.at("unixtime").get<uint32_t>();
     return timestamp;
@@ -149,8 +267,8 @@ std::map<std::string, coin_t> Kraken::coins()
 {
     // "BCH":{"aclass":"currency","altname":"BCH","decimals":10,"display_decimals":5}
     Request req;
+    req.check(_throw_error_if_any);
     json res = req.get(_host + "public/Assets?aclass=currency");
-    _throw_error_if_any(res);
     res = res["result"];
     std::map<std::string, coin_t> ret;
     for (auto it = res.begin(); it != res.end(); ++it) {
@@ -166,8 +284,8 @@ std::map<std::string, coin_t> Kraken::coins()
 std::vector<market_info_t> Kraken::info()
 {
     Request req;
+    req.check(_throw_error_if_any);
     json res = req.get(_host + "public/AssetPairs");
-    _throw_error_if_any(res);
 
     res = res["result"];
     std::vector<market_info_t> markets;
@@ -193,6 +311,7 @@ market_info_t Kraken::info(currency_pair_t pair)
 {
     _sanitize_pair(pair);
     Request req;
+    req.check(_throw_error_if_any);
     std::ostringstream url;
     url << _host;
     url << "public/AssetPairs?pair=";
@@ -200,7 +319,6 @@ market_info_t Kraken::info(currency_pair_t pair)
     url << pair.first;
     url << pair.second;
     json res = req.get(url.str());
-    _throw_error_if_any(res);
     json market = res["result"].begin().value();
 
     return market_info_t{
@@ -215,7 +333,6 @@ deposit_info_t Kraken::depositInfo(std::string currency)
 {
     toupper(currency);
     json res = _request("DepositMethods", {{"asset", currency}});
-    _throw_error_if_any(res);
     res = res["result"][0];
     // [{"fee":"0.0000000000","gen-address":true,"limit":false,"method":"Zcash
     // (Transparent)"}]
@@ -237,7 +354,6 @@ deposit_info_t Kraken::depositInfo(std::string currency)
 std::map<std::string, double> Kraken::balance()
 {
     json res = _request("Balance", {});
-    _throw_error_if_any(res);
     res = res["result"];
     std::map<std::string, double> ret;
 
@@ -272,6 +388,7 @@ ticker_t Kraken::ticker(currency_pair_t pair)
     _sanitize_pair(pair);
 
     Request req;
+    req.check(_throw_error_if_any);
     std::ostringstream url;
     url << _host;
     url << "public/Ticker?pair=";
@@ -279,7 +396,6 @@ ticker_t Kraken::ticker(currency_pair_t pair)
     url << pair.first;
     url << pair.second;
     json res = req.get(url.str());
-    _throw_error_if_any(res);
     res = res["result"].begin().value();
     auto now =
         std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
@@ -304,6 +420,7 @@ std::vector<ticker_t> Kraken::orderBook(currency_pair_t pair)
 {
     _sanitize_pair(pair);
     Request req;
+    req.check(_throw_error_if_any);
     std::ostringstream url;
     url << _host;
     url << "public/Depth?pair=";
@@ -311,28 +428,28 @@ std::vector<ticker_t> Kraken::orderBook(currency_pair_t pair)
     url << pair.first;
     url << pair.second;
     json res = req.get(url.str());
-    _throw_error_if_any(res);
-    res = res["result"].begin().value();
+    return parseOrderBook(res["result"].begin().value());
+}
 
-    std::vector<ticker_t> ret;
-    size_t idx = 0;
-    for (auto it = res["asks"].begin(); it != res["asks"].end(); ++idx, ++it) {
-        auto ask = quotation_t{
-            .price = std::stod(res["asks"][idx][0].get<std::string>()),
-            .amount = std::stod(res["asks"][idx][1].get<std::string>()),
-            .time =
-                static_cast<std::time_t>(res["asks"][idx][2].get<uint32_t>()),
-        };
-        auto bid = quotation_t{
-            .price = std::stod(res["bids"][idx][0].get<std::string>()),
-            .amount = std::stod(res["bids"][idx][1].get<std::string>()),
-            .time =
-                static_cast<std::time_t>(res["bids"][idx][2].get<uint32_t>()),
+std::vector<ticker_t> Kraken::parseOrderBook(const json& book)
+{
+    const auto& asks = book.at("asks");
+    const auto& bids = book.at("bids");
+    auto quotation = [](const json& level) {
+        return quotation_t{
+            .price = std::stod(level.at(0).get<std::string>()),
+            .amount = std::stod(level.at(1).get<std::string>()),
+            .time = static_cast<std::time_t>(level.at(2).get<uint32_t>()),
         };
+    };
 
+    std::vector<ticker_t> ret;
+    const auto levels = std::min(asks.size(), bids.size());
+    ret.reserve(levels);
+    for (std::size_t idx = 0; idx < levels; ++idx) {
         ticker_t ticker;
-        ticker.ask = ask;
-        ticker.bid = bid;
+        ticker.ask = quotation(asks[idx]);
+        ticker.bid = quotation(bids[idx]);
         ret.push_back(ticker);
     }
     return ret;
@@ -341,7 +458,6 @@ std::vector<ticker_t> Kraken::orderBook(currency_pair_t pair)
 std::vector<order_t> Kraken::closedOrders()
 {
     json res = _request("ClosedOrders", {});
-    _throw_error_if_any(res);
     res = res["result"]["closed"];
     std::vector<order_t> ret;
 
@@ -367,7 +483,6 @@ std::vector<order_t> Kraken::closedOrders()
 std::vector<order_t> Kraken::openOrders()
 {
     json res = _request("OpenOrders", {});
-    _throw_error_if_any(res);
     res = res["result"]["open"];
     std::vector<order_t> ret;
 
@@ -392,58 +507,157 @@ std::vector<order_t> Kraken::openOrders()
 
 void Kraken::place(order_t& order)
 {
-    _sanitize_pair(order.pair);
-    std::vector<std::pair<std::string, std::string>> params;
-    params.push_back({"pair", order.pair.first + order.pair.second});
-    std::stringstream ss;
-    ss << order.action;
-    params.push_back({"type", ss.str()});
-    ss.str("");
-    ss.clear();
-    ss << order.type;
-    params.push_back({"ordertype", ss.str()});
-    params.push_back({"volume", std::to_string(order.volume)});
+    json res = _request("AddOrder", _order_params(order));
+    res = res["result"];
+    order.txid = res["txid"][0].get<std::string>();
+}
 
-    switch (order.type) {
-        case at::order_type_t::market: {
-            if (order.volume <= 0) {
-                throw std::runtime_error("order.volume can't be <= 0");
-            }
-            break;
+void Kraken::cancel(order_t& order)
+{
+    json res = _request("CancelOrder", {{"txid", order.txid}});
+    order = {};
+}
+
+std::vector<std::exception_ptr> Kraken::place(std::vector<order_t>& orders)
+{
+    std::vector<std::exception_ptr> ret(orders.size());
+    std::vector<std::vector<std::pair<std::string, std::string>>> params(
+        orders.size());
+    // indexes of the valid orders, by pair
+    std::map<std::string, std::vector<std::size_t>> pairs;
+    for (std::size_t i = 0; i < orders.size(); ++i) {
+        try {
+            params[i] = _order_params(orders[i]);
+            pairs[params[i].front().second].push_back(i);
         }
-        case at::order_type_t::limit: {
-            if (order.volume * order.price <= 0) {
-                throw std::runtime_error(
-                    "order.volume * order.price can't be <= 0");
+        catch (...) {
+            ret[i] = std::current_exception();
+        }
+    }
+
+    for (const auto& pair : pairs) {
+        const auto& indexes = pair.second;
+        for (std::size_t begin = 0; begin < indexes.size();
+             begin += max_placed) {
+            auto end = std::min(begin + max_placed, indexes.size());
+            if (end - begin == 1) {
+                auto i = indexes[begin];
+                try {
+                    json res = _request("AddOrder", params[i]);
+                    orders[i].txid =
+                        res["result"]["txid"][0].get<std::string>();
+                }
+                catch (...) {
+                    ret[i] = std::current_exception();
+                }
+                continue;
+            }
+
+            json body = {{"pair", pair.first}, {"orders", json::array()}};
+            for (auto k = begin; k < end; ++k) {
+                json order = json::object();
+                // the pair is common to the batch
+                for (auto it = params[indexes[k]].begin() + 1;
+                     it != params[indexes[k]].end(); ++it) {
+                    order[it->first] = it->second;
+                }
+                body["orders"].push_back(order);
             }
-            ss.str("");
-            ss.clear();
-            // hopefully a precision of 2 is not too much for the current
-            // pair. Kraken just give the precision for certain pairs
-            // but other pairs have no specification at all.
-            int precision = 2;
             try {
-                precision = _maxPrecision.at(order.pair);
+                json res = _json_request("AddOrderBatch", body);
+                const auto& placed = res["result"].at("orders");
+                // checked before assigning any txid: once an order got its
+                // txid it is live and can't be reported as failed
+                if (!placed.is_array() || placed.size() != end - begin) {
+                    throw response_error(
+                        "AddOrderBatch: unexpected orders in the response");
+                }
+                for (auto k = begin; k < end; ++k) {
+                    const auto& result = placed[k - begin];
+                    auto message = _error_message(result);
+                    const auto txid = result.find("txid");
+                    if (message.empty() && txid != result.end() &&
+                        txid->is_string()) {
+                        orders[indexes[k]].txid = txid->get<std::string>();
+                    }
+                    else {
+                        ret[indexes[k]] = std::make_exception_ptr(
+                            response_error(message.empty()
+                                               ? "AddOrderBatch: no txid"
+                                               : message));
+                    }
+                }
             }
-            catch (const std::out_of_range&) {
+            catch (...) {
+                for (auto k = begin; k < end; ++k) {
+                    ret[indexes[k]] = std::current_exception();
+                }
             }
-            ss << std::setprecision(precision) << order.price;
-            params.push_back({"price", ss.str()});
-            break;
         }
     }
-
-    json res = _request("AddOrder", params);
-    _throw_error_if_any(res);
-    res = res["result"];
-    order.txid = res["txid"][0].get<std::string>();
+    return ret;
 }
 
-void Kraken::cancel(order_t& order)
+std::vector<std::exception_ptr> Kraken::cancel(std::vector<order_t>& orders)
 {
-    json res = _request("CancelOrder", {{"txid", order.txid}});
-    _throw_error_if_any(res);
-    order = {};
+    std::vector<std::exception_ptr> ret(orders.size());
+    for (std::size_t begin = 0; begin < orders.size(); begin += max_canceled) {
+        auto end = std::min(begin + max_canceled, orders.size());
+        if (end - begin == 1) {
+            try {
+                cancel(orders[begin]);
+            }
+            catch (...) {
+                ret[begin] = std::current_exception();
+            }
+            continue;
+        }
+
+        json body = {{"orders", json::array()}};
+        for (auto i = begin; i < end; ++i) {
+            body["orders"].push_back(orders[i].txid);
+        }
+        try {
+            json res = _json_request("CancelOrderBatch", body);
+            // a partial cancel (e.g. orders already filled or unknown)
+            // does not tell which ones: the open orders are not canceled
+            std::set<std::string> open;
+            if (res["result"].at("count").get<std::size_t>() != end - begin) {
+                try {
+                    res = _request("OpenOrders", {});
+                    for (const auto& order : res["result"]["open"].items()) {
+                        open.insert(order.key());
+                    }
+                }
+                catch (...) {
+                    // the batch has been (partially) canceled: the error
+                    // of the lookup is not the outcome of any order
+                    for (auto i = begin; i < end; ++i) {
+                        ret[i] = std::make_exception_ptr(response_error(
+                            "cancel outcome unknown: " + orders[i].txid));
+                    }
+                    continue;
+                }
+            }
+            for (auto i = begin; i < end; ++i) {
+                if (open.find(orders[i].txid) != open.end()) {
+                    ret[i] = std::make_exception_ptr(response_error(
+                        "order not canceled: " + orders[i].txid));
+                }
+                else {
+                    orders[i] = {};
+                }
+            }
+        }
+        catch (...) {
+            for (auto i = begin; i < end; ++i) {
+                ret[i] = std::current_exception();
+            }
+        }
+    }
+    return ret;
 }
 
+void Kraken::cancelAll() { _request("CancelAll", {}); }
+
 }  // namespace at
@@ -0,0 +1,251 @@
+/* Copyright 2017 Paolo Galeone <nessuno@nerdz.eu>. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.*/
+
+#include <algorithm>
+#include <at/latency.hpp>
+#include <cmath>
+#include <functional>
+#include <iomanip>
+#include <limits>
+#include <stdexcept>
+#include <thread>
+#include <unordered_map>
+
+namespace at {
+
+namespace {
+
+// shard of the calling thread
+std::size_t shard_index(std::size_t shards)
+{
+    thread_local const std::size_t index =
+        std::hash<std::thread::id>()(std::this_thread::get_id());
+    return index % shards;
+}
+
+// registry of the endpoints: the histograms are never deallocated
+std::mutex registry_mux;
+std::map<std::string, std::unique_ptr<Latency::endpoint_t>>& registry()
+{
+    static std::map<std::string, std::unique_ptr<Latency::endpoint_t>> ret;
+    return ret;
+}
+
+}  // namespace
+
+// private methods
+
+std::size_t LatencyHistogram::_bucket(uint64_t ns)
+{
+    if (ns < sub_buckets) {
+        return static_cast<std::size_t>(ns);
+    }
+    std::size_t exponent = 63 - static_cast<std::size_t>(__builtin_clzll(ns));
+    if (exponent >= max_exponent) {
+        return buckets - 1;
+    }
+    std::size_t sub = (ns >> (exponent - 4)) & (sub_buckets - 1);
+    return (exponent - 3) * sub_buckets + sub;
+}
+
+uint64_t LatencyHistogram::_lower(std::size_t bucket)
+{
+    if (bucket < sub_buckets) {
+        return bucket;
+    }
+    std::size_t exponent = bucket / sub_buckets + 3;
+    uint64_t sub = bucket % sub_buckets;
+    return (sub_buckets + sub) << (exponent - 4);
+}
+
+// end private methods
+
+LatencyHistogram::LatencyHistogram() : _shard(new shard_t[_shards]) { reset(); }
+
+void LatencyHistogram::record(std::chrono::nanoseconds duration)
+{
+    uint64_t ns = static_cast<uint64_t>(std::max<int64_t>(0, duration.count()));
+    shard_t& shard = _shard[shard_index(_shards)];
+    shard.counts[_bucket(ns)].fetch_add(1, std::memory_order_relaxed);
+    shard.count.fetch_add(1, std::memory_order_relaxed);
+    shard.sum.fetch_add(ns, std::memory_order_relaxed);
+
+    uint64_t min = shard.min.load(std::memory_order_relaxed);
+    while (ns < min && !shard.min.compare_exchange_weak(
+                           min, ns, std::memory_order_relaxed)) {
+    }
+    uint64_t max = shard.max.load(std::memory_order_relaxed);
+    while (ns > max && !shard.max.compare_exchange_weak(
+                           max, ns, std::memory_order_relaxed)) {
+    }
+}
+
+std::chrono::nanoseconds LatencyHistogram::percentile(double fraction) const
+{
+    std::array<uint64_t, buckets> counts{};
+    uint64_t count = 0;
+    for (std::size_t s = 0; s < _shards; ++s) {
+        for (std::size_t i = 0; i < buckets; ++i) {
+            counts[i] += _shard[s].counts[i].load(std::memory_order_relaxed);
+        }
+    }
+    for (auto c : counts) {
+        count += c;
+    }
+    if (count == 0) {
+        return std::chrono::nanoseconds(0);
+    }
+    auto rank = static_cast<uint64_t>(std::max(
+        1.0, std::ceil(std::min(1.0, fraction) * static_cast<double>(count))));
+    uint64_t seen = 0;
+    for (std::size_t i = 0; i < buckets; ++i) {
+        seen += counts[i];
+        if (seen >= rank) {
+            // upper bound of the bucket
+            auto upper = i + 1 < buckets ? _lower(i + 1) - 1 : _lower(i);
+            return std::chrono::nanoseconds(std::max(upper, _lower(i)));
+        }
+    }
+    return std::chrono::nanoseconds(_lower(buckets - 1));
+}
+
+latency_summary_t LatencyHistogram::summary() const
+{
+    uint64_t count = 0, sum = 0, max = 0;
+    uint64_t min = std::numeric_limits<uint64_t>::max();
+    for (std::size_t s = 0; s < _shards; ++s) {
+        count += _shard[s].count.load(std::memory_order_relaxed);
+        sum += _shard[s].sum.load(std::memory_order_relaxed);
+        min = std::min(min, _shard[s].min.load(std::memory_order_relaxed));
+        max = std::max(max, _shard[s].max.load(std::memory_order_relaxed));
+    }
+    if (count == 0) {
+        return latency_summary_t{};
+    }
+    // the percentiles never exceed the exact maximum
+    auto clamp = [max](std::chrono::nanoseconds value) {
+        return std::min(value, std::chrono::nanoseconds(max));
+    };
+    return latency_summary_t{
+        .count = count,
+        .min = std::chrono::nanoseconds(min),
+        .max = std::chrono::nanoseconds(max),
+        .mean = std::chrono::nanoseconds(sum / count),
+        .sum = std::chrono::nanoseconds(sum),
+        .p50 = clamp(percentile(0.5)),
+        .p90 = clamp(percentile(0.9)),
+        .p99 = clamp(percentile(0.99)),
+        .p999 = clamp(percentile(0.999)),
+    };
+}
+
+void LatencyHistogram::reset()
+{
+    for (std::size_t s = 0; s < _shards; ++s) {
+        for (auto& count : _shard[s].counts) {
+            count.store(0, std::memory_order_relaxed);
+        }
+        _shard[s].count.store(0, std::memory_order_relaxed);
+        _shard[s].sum.store(0, std::memory_order_relaxed);
+        _shard[s].min.store(std::numeric_limits<uint64_t>::max(),
+                            std::memory_order_relaxed);
+        _shard[s].max.store(0, std::memory_order_relaxed);
+    }
+}
+
+Latency::endpoint_t* Latency::endpoint(const std::string& name)
+{
+    // only the endpoints with their own histograms: the names recorded
+    // under "other" are unbounded
+    thread_local std::unordered_map<std::string, endpoint_t*> cache;
+    auto it = cache.find(name);
+    if (it != cache.end()) {
+        return it->second;
+    }
+
+    std::lock_guard<std::mutex> lock(registry_mux);
+    auto& endpoints = registry();
+    auto found = endpoints.find(name);
+    if (found == endpoints.end()) {
+        if (endpoints.size() >= max_endpoints) {
+            found = endpoints.find("other");
+            if (found == endpoints.end()) {
+                found = endpoints.emplace("other", new endpoint_t).first;
+            }
+        }
+        else {
+            found = endpoints.emplace(name, new endpoint_t).first;
+        }
+    }
+    if (found->first != name) {
+        return found->second.get();
+    }
+    return cache[name] = found->second.get();
+}
+
+std::vector<std::string> Latency::endpoints()
+{
+    std::lock_guard<std::mutex> lock(registry_mux);
+    std::vector<std::string> ret;
+    for (const auto& endpoint : registry()) {
+        ret.push_back(endpoint.first);
+    }
+    return ret;
+}
+
+latency_summary_t Latency::summary(const std::string& endpoint,
+                                   latency_phase_t phase)
+{
+    std::lock_guard<std::mutex> lock(registry_mux);
+    return registry()
+        .at(endpoint)
+        ->phases[static_cast<std::size_t>(phase)]
+        .summary();
+}
+
+void Latency::reset()
+{
+    std::lock_guard<std::mutex> lock(registry_mux);
+    for (auto& endpoint : registry()) {
+        for (auto& phase : endpoint.second->phases) {
+            phase.reset();
+        }
+    }
+}
+
+void Latency::dump(std::ostream& out)
+{
+    std::lock_guard<std::mutex> lock(registry_mux);
+    auto us = [](std::chrono::nanoseconds ns) {
+        return static_cast<double>(ns.count()) / 1000;
+    };
+    out << std::fixed << std::setprecision(1);
+    for (const auto& endpoint : registry()) {
+        out << endpoint.first << "\n";
+        for (std::size_t p = 0; p < latency_phases; ++p) {
+            auto summary = endpoint.second->phases[p].summary();
+            if (summary.count == 0) {
+                continue;
+            }
+            out << "  " << std::left << std::setw(11)
+                << static_cast<latency_phase_t>(p) << std::right
+                << " count " << summary.count << " mean " << us(summary.mean)
+                << "us p50 " << us(summary.p50) << "us p99 "
+                << us(summary.p99) << "us max " << us(summary.max)
+                << "us\n";
+        }
+    }
+}
+
+}  // namespace at
@@ -0,0 +1,57 @@
+/* Copyright 2017 Paolo Galeone <nessuno@nerdz.eu>. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.*/
+
+#include <at/market.hpp>
+
+namespace at {
+
+std::vector<std::exception_ptr> Market::place(std::vector<order_t>& orders)
+{
+    std::vector<std::exception_ptr> ret(orders.size());
+    for (std::size_t i = 0; i < orders.size(); ++i) {
+        try {
+            place(orders[i]);
+        }
+        catch (...) {
+            ret[i] = std::current_exception();
+        }
+    }
+    return ret;
+}
+
+std::vector<std::exception_ptr> Market::cancel(std::vector<order_t>& orders)
+{
+    std::vector<std::exception_ptr> ret(orders.size());
+    for (std::size_t i = 0; i < orders.size(); ++i) {
+        try {
+            cancel(orders[i]);
+        }
+        catch (...) {
+            ret[i] = std::current_exception();
+        }
+    }
+    return ret;
+}
+
+void Market::cancelAll()
+{
+    auto orders = openOrders();
+    for (const auto& error : cancel(orders)) {
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+}
+
+}  // namespace at
@@ -0,0 +1,365 @@
+/* Copyright 2017 Paolo Galeone <nessuno@nerdz.eu>. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.*/
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <at/marketlog.hpp>
+#include <cerrno>
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+#include <stdexcept>
+
+namespace at {
+
+namespace {
+
+const uint32_t version = 2;
+
+// types of the records that are not events
+const uint8_t sync_record = 0;
+const uint8_t pair_record = 1;
+
+// the name of the pair is stored in the price and amount fields: the
+// bytes of the record from name_offset to its end
+const std::size_t max_pair_name = 16;
+const std::size_t name_offset = offsetof(market_log_record_t, price);
+
+static_assert(sizeof(market_log_header_t) == 24, "invalid header size");
+static_assert(sizeof(market_log_record_t) == 24, "invalid record size");
+static_assert(name_offset + max_pair_name == sizeof(market_log_record_t),
+              "invalid pair name size");
+
+market_log_record_t pair_definition(uint16_t id, const std::string& name)
+{
+    market_log_record_t record = {};
+    record.type = pair_record;
+    record.pair = id;
+    std::memcpy(reinterpret_cast<char*>(&record) + name_offset, name.data(),
+                name.size());
+    return record;
+}
+
+}  // end namespace
+
+// private methods
+
+bool MarketLog::_decode(market_event_t& event)
+{
+    const market_log_record_t& record = _records[_position++];
+    switch (record.type) {
+        case sync_record: {
+            _base = static_cast<std::time_t>(record.price);
+            return false;
+        }
+        case pair_record: {
+            const char* name =
+                reinterpret_cast<const char*>(&record) + name_offset;
+            std::string pair(name, strnlen(name, max_pair_name));
+            std::size_t delimiter = pair.find_last_of('_');
+            if (record.pair >= _pairs.size()) {
+                _pairs.resize(record.pair + 1);
+            }
+            _pairs[record.pair] = currency_pair_t(
+                pair.substr(0, delimiter), pair.substr(delimiter + 1));
+            return false;
+        }
+        default: {
+            event.type = static_cast<market_event_type_t>(record.type);
+            event.pair = record.pair;
+            event.time = _base + record.time;
+            event.amount = record.amount;
+            event.price = record.price * _header->tick;
+            return true;
+        }
+    }
+}
+
+// end private methods
+
+MarketLog::MarketLog(const std::string& path)
+{
+    _fd = open(path.c_str(), O_RDONLY);
+    if (_fd < 0) {
+        throw std::runtime_error("MarketLog: unable to open " + path + ": " +
+                                 strerror(errno));
+    }
+    struct stat st;
+    if (fstat(_fd, &st) != 0 ||
+        static_cast<std::size_t>(st.st_size) < sizeof(market_log_header_t)) {
+        close(_fd);
+        throw std::runtime_error("MarketLog: invalid file " + path);
+    }
+    _size = static_cast<std::size_t>(st.st_size);
+    _data = mmap(nullptr, _size, PROT_READ, MAP_SHARED, _fd, 0);
+    if (_data == MAP_FAILED) {
+        close(_fd);
+        throw std::runtime_error("MarketLog: unable to mmap " + path + ": " +
+                                 strerror(errno));
+    }
+    // the log is read sequentially
+    madvise(_data, _size, MADV_SEQUENTIAL);
+
+    _header = static_cast<const market_log_header_t*>(_data);
+    if (std::memcmp(_header->magic, "ATML", 4) != 0 ||
+        _header->version != version || _header->block < 2 ||
+        !(_header->tick > 0)) {
+        munmap(_data, _size);
+        close(_fd);
+        throw std::runtime_error("MarketLog: invalid file " + path);
+    }
+    _records = reinterpret_cast<const market_log_record_t*>(_header + 1);
+    // a partially written record is ignored
+    _count = (_size - sizeof(market_log_header_t)) /
+             sizeof(market_log_record_t);
+}
+
+MarketLog::~MarketLog()
+{
+    munmap(_data, _size);
+    close(_fd);
+}
+
+bool MarketLog::next(market_event_t& event)
+{
+    if (_peeked) {
+        _peeked = false;
+        event = _peek;
+        return true;
+    }
+    while (_position < _count) {
+        if (_decode(event)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void MarketLog::seek(std::time_t time)
+{
+    // last block starting at or before time
+    const std::size_t block = _header->block;
+    std::size_t blocks = (_count + block - 1) / block;
+    std::size_t low = 0, high = blocks;
+    while (high - low > 1) {
+        std::size_t middle = low + (high - low) / 2;
+        if (_records[middle * block].price <= time) {
+            low = middle;
+        }
+        else {
+            high = middle;
+        }
+    }
+
+    _position = low * block;
+    _peeked = false;
+    while (next(_peek)) {
+        if (_peek.time >= time) {
+            _peeked = true;
+            return;
+        }
+    }
+}
+
+void MarketLog::rewind()
+{
+    _position = 0;
+    _peeked = false;
+}
+
+const currency_pair_t& MarketLog::pair(uint16_t id) const
+{
+    return _pairs.at(id);
+}
+
+// MarketRecorder
+
+// private methods
+
+uint16_t MarketRecorder::_pair(const currency_pair_t& pair)
+{
+    std::string name = pair.str();
+    auto it = _ids.find(name);
+    if (it != _ids.end()) {
+        return it->second;
+    }
+    if (name.size() > max_pair_name) {
+        throw std::invalid_argument("MarketRecorder: pair name too long " +
+                                    name);
+    }
+    // the definitions of the pairs must fit in a block
+    if (_pairs.size() + 2 >= _block) {
+        throw std::length_error("MarketRecorder: too many pairs");
+    }
+    uint16_t id = static_cast<uint16_t>(_pairs.size());
+    _ids[name] = id;
+    _pairs.push_back(name);
+    if (_count % _block != 0) {
+        _append(pair_definition(id, name));
+    }
+    // else: the definition is written by the next sync
+    return id;
+}
+
+void MarketRecorder::_append(const market_log_record_t& record)
+{
+    _buffer.push_back(record);
+    ++_count;
+    if (_buffer.size() >= _buffer_size) {
+        flush();
+    }
+}
+
+void MarketRecorder::_event(market_event_type_t type, uint16_t pair,
+                            std::time_t time, double price, double amount)
+{
+    _time = std::max(_time, time);
+    if (_count % _block == 0) {
+        _base = _time;
+        market_log_record_t sync = {};
+        sync.type = sync_record;
+        sync.price = static_cast<int64_t>(_base);
+        _append(sync);
+        for (std::size_t id = 0; id < _pairs.size(); ++id) {
+            _append(pair_definition(static_cast<uint16_t>(id), _pairs[id]));
+        }
+    }
+
+    market_log_record_t record = {};
+    record.type = static_cast<uint8_t>(type);
+    record.pair = pair;
+    record.time = static_cast<uint32_t>(_time - _base);
+    record.amount = amount;
+    record.price = std::llround(price / _tick);
+    _append(record);
+}
+
+// end private methods
+
+MarketRecorder::MarketRecorder(const std::string& path, double tick,
+                               uint32_t block)
+    : _tick(tick), _block(block)
+{
+    struct stat st;
+    bool exists = stat(path.c_str(), &st) == 0 && st.st_size > 0;
+    if (exists) {
+        // restore the state from the last block of the log
+        MarketLog log(path);
+        _tick = log.tick();
+        _block = log._header->block;
+        _count = log.size();
+        std::size_t valid = sizeof(market_log_header_t) +
+                            _count * sizeof(market_log_record_t);
+        if (static_cast<std::size_t>(st.st_size) != valid &&
+            truncate(path.c_str(), static_cast<off_t>(valid)) != 0) {
+            throw std::runtime_error("MarketRecorder: unable to truncate " +
+                                     path + ": " + strerror(errno));
+        }
+
+        if (_count > 0) {
+            log._position = (_count - 1) / _block * _block;
+            market_event_t event;
+            while (log.next(event)) {
+                _time = event.time;
+            }
+            _base = log._base;
+            _time = std::max(_time, _base);
+            for (const auto& pair : log._pairs) {
+                _ids[pair.str()] = static_cast<uint16_t>(_pairs.size());
+                _pairs.push_back(pair.str());
+            }
+        }
+    }
+    else if (!(tick > 0) || block < 2) {
+        throw std::invalid_argument(
+            "MarketRecorder: tick must be positive and block >= 2");
+    }
+
+    _out.open(path, std::ios::binary | std::ios::app);
+    if (!_out) {
+        throw std::runtime_error("MarketRecorder: unable to open " + path);
+    }
+    if (!exists) {
+        market_log_header_t header = {};
+        std::memcpy(header.magic, "ATML", 4);
+        header.version = version;
+        header.tick = _tick;
+        header.block = _block;
+        _out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        _out.flush();
+    }
+    _buffer.reserve(_buffer_size);
+}
+
+MarketRecorder::~MarketRecorder()
+{
+    try {
+        flush();
+    }
+    catch (const std::exception&) {
+    }
+}
+
+void MarketRecorder::ticker(const currency_pair_t& pair, const ticker_t& ticker)
+{
+    uint16_t id = _pair(pair);
+    _event(market_event_type_t::bid, id, ticker.bid.time, ticker.bid.price,
+           ticker.bid.amount);
+    _event(market_event_type_t::ask, id, ticker.ask.time, ticker.ask.price,
+           ticker.ask.amount);
+}
+
+void MarketRecorder::orderBook(const currency_pair_t& pair,
+                               const std::vector<ticker_t>& book,
+                               std::time_t time)
+{
+    uint16_t id = _pair(pair);
+    _event(market_event_type_t::book, id, time, 0,
+           static_cast<double>(book.size()));
+    for (const auto& level : book) {
+        _event(market_event_type_t::book_bid, id, time, level.bid.price,
+               level.bid.amount);
+        _event(market_event_type_t::book_ask, id, time, level.ask.price,
+               level.ask.amount);
+    }
+}
+
+void MarketRecorder::trade(const currency_pair_t& pair, order_action_t taker,
+                           const quotation_t& trade)
+{
+    _event(taker == order_action_t::buy ? market_event_type_t::buy
+                                        : market_event_type_t::sell,
+           _pair(pair), trade.time, trade.price, trade.amount);
+}
+
+void MarketRecorder::flush()
+{
+    if (_buffer.empty()) {
+        return;
+    }
+    _out.write(reinterpret_cast<const char*>(_buffer.data()),
+               static_cast<std::streamsize>(_buffer.size() *
+                                            sizeof(market_log_record_t)));
+    _out.flush();
+    _buffer.clear();
+    if (!_out) {
+        throw std::runtime_error("MarketRecorder: write failed");
+    }
+}
+
+}  // namespace at
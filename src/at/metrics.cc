@@ -0,0 +1,336 @@
+/* Copyright 2017 Paolo Galeone <nessuno@nerdz.eu>. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.*/
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <at/latency.hpp>
+#include <at/metrics.hpp>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <unordered_map>
+#include <utility>
+
+namespace at {
+
+namespace {
+
+// registry of the hosts: the counters are never deallocated
+std::mutex registry_mux;
+std::map<std::string, std::unique_ptr<Metrics::host_t>>& registry()
+{
+    static std::map<std::string, std::unique_ptr<Metrics::host_t>> ret;
+    return ret;
+}
+
+thread_local Metrics::host_t* current_host = nullptr;
+
+// Escapes a label value: backslash, double quote and line feed
+std::string escape(const std::string& value)
+{
+    std::string ret;
+    for (char c : value) {
+        if (c == '\\' || c == '"') {
+            ret += '\\';
+            ret += c;
+        }
+        else if (c == '\n') {
+            ret += "\\n";
+        }
+        else {
+            ret += c;
+        }
+    }
+    return ret;
+}
+
+typedef struct {
+    metric_t metric;
+    const char* name;
+    const char* type;
+    const char* help;
+} family_t;
+
+const family_t families[] = {
+    {metric_t::requests, "openat_requests_total", "counter",
+     "Requests performed."},
+    {metric_t::retries, "openat_retries_total", "counter",
+     "Requests performed again after a failure."},
+    {metric_t::rate_limit_waits, "openat_rate_limit_waits_total", "counter",
+     "Waits imposed by a rate limit."},
+    {metric_t::bytes_in, "openat_received_bytes_total", "counter",
+     "Bytes of the response bodies."},
+    {metric_t::bytes_out, "openat_sent_bytes_total", "counter",
+     "Bytes of the request bodies."},
+    {metric_t::in_flight, "openat_requests_in_flight", "gauge",
+     "Requests in progress."},
+    {metric_t::deadlines, "openat_deadlines_exceeded_total", "counter",
+     "Requests aborted by the deadline of the caller."},
+};
+
+}  // namespace
+
+Metrics::host_t* Metrics::host(const std::string& name)
+{
+    // only the hosts with their own counters: the names counted under
+    // "other" are unbounded
+    thread_local std::unordered_map<std::string, host_t*> cache;
+    auto it = cache.find(name);
+    if (it != cache.end()) {
+        return it->second;
+    }
+
+    std::lock_guard<std::mutex> lock(registry_mux);
+    auto& hosts = registry();
+    auto found = hosts.find(name);
+    if (found == hosts.end()) {
+        auto key = hosts.size() >= max_hosts ? "other" : name;
+        found = hosts.find(key);
+        if (found == hosts.end()) {
+            found = hosts.emplace(key, new host_t()).first;
+        }
+    }
+    if (found->first != name) {
+        return found->second.get();
+    }
+    return cache[name] = found->second.get();
+}
+
+Metrics::host_t* Metrics::current() { return current_host; }
+
+void Metrics::current(host_t* host) { current_host = host; }
+
+std::vector<std::string> Metrics::hosts()
+{
+    std::lock_guard<std::mutex> lock(registry_mux);
+    std::vector<std::string> ret;
+    for (const auto& host : registry()) {
+        ret.push_back(host.first);
+    }
+    return ret;
+}
+
+int64_t Metrics::value(const std::string& host, metric_t metric)
+{
+    std::lock_guard<std::mutex> lock(registry_mux);
+    return registry()
+        .at(host)
+        ->values[static_cast<std::size_t>(metric)]
+        .load(std::memory_order_relaxed);
+}
+
+void Metrics::reset()
+{
+    std::lock_guard<std::mutex> lock(registry_mux);
+    for (auto& host : registry()) {
+        for (std::size_t m = 0; m < metrics; ++m) {
+            if (static_cast<metric_t>(m) != metric_t::in_flight) {
+                host.second->values[m].store(0, std::memory_order_relaxed);
+            }
+        }
+    }
+}
+
+void Metrics::exposition(std::ostream& out)
+{
+    {
+        std::lock_guard<std::mutex> lock(registry_mux);
+        auto value = [](const host_t* host, metric_t metric) {
+            return host->values[static_cast<std::size_t>(metric)].load(
+                std::memory_order_relaxed);
+        };
+        for (const auto& family : families) {
+            out << "# HELP " << family.name << " " << family.help << "\n";
+            out << "# TYPE " << family.name << " " << family.type << "\n";
+            for (const auto& host : registry()) {
+                out << family.name << "{host=\"" << escape(host.first)
+                    << "\"} " << value(host.second.get(), family.metric)
+                    << "\n";
+            }
+        }
+
+        out << "# HELP openat_errors_total Errors thrown, by type.\n";
+        out << "# TYPE openat_errors_total counter\n";
+        for (const auto& host : registry()) {
+            auto label = "openat_errors_total{host=\"" + escape(host.first);
+            out << label << "\",type=\"server_error\"} "
+                << value(host.second.get(), metric_t::server_errors) << "\n";
+            out << label << "\",type=\"response_error\"} "
+                << value(host.second.get(), metric_t::response_errors)
+                << "\n";
+        }
+    }
+
+    const std::string name = "openat_request_duration_seconds";
+    out << "# HELP " << name << " Duration of the API calls.\n";
+    out << "# TYPE " << name << " summary\n";
+    auto seconds = [](std::chrono::nanoseconds ns) {
+        return static_cast<double>(ns.count()) / 1e9;
+    };
+    const auto precision = out.precision();
+    out << std::setprecision(9);
+    for (const auto& endpoint : Latency::endpoints()) {
+        auto summary = Latency::summary(endpoint, latency_phase_t::total);
+        auto label = "{endpoint=\"" + escape(endpoint) + "\"";
+        const std::pair<const char*, std::chrono::nanoseconds> quantiles[] = {
+            {"0.5", summary.p50},
+            {"0.9", summary.p90},
+            {"0.99", summary.p99},
+            {"0.999", summary.p999},
+        };
+        for (const auto& quantile : quantiles) {
+            out << name << label << ",quantile=\"" << quantile.first
+                << "\"} " << seconds(quantile.second) << "\n";
+        }
+        out << name << "_sum" << label << "} " << seconds(summary.sum)
+            << "\n";
+        out << name << "_count" << label << "} " << summary.count << "\n";
+    }
+    out.precision(precision);
+}
+
+void Metrics::dump(const std::string& path)
+{
+    auto temporary = path + ".tmp";
+    {
+        std::ofstream out(temporary);
+        exposition(out);
+        // the last write may fail only when the buffer is flushed
+        out.close();
+        if (!out) {
+            throw std::runtime_error("Metrics: unable to write " + temporary);
+        }
+    }
+    if (std::rename(temporary.c_str(), path.c_str()) != 0) {
+        throw std::runtime_error("Metrics: unable to rename " + temporary +
+                                 ": " + strerror(errno));
+    }
+}
+
+// private methods
+
+void MetricsServer::_serve()
+{
+    while (!_stop) {
+        int client = ::accept(_fd, nullptr, nullptr);
+        if (client < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) {
+                continue;
+            }
+            break;
+        }
+        _handle(client);
+        ::close(client);
+    }
+}
+
+void MetricsServer::_handle(int client)
+{
+    // a client can't stall the server for more than a second
+    timeval timeout = {1, 0};
+    setsockopt(client, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    setsockopt(client, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+
+    std::string request;
+    char chunk[4096];
+    while (request.find("\r\n\r\n") == std::string::npos &&
+           request.size() < 65536) {
+        ssize_t n = ::recv(client, chunk, sizeof(chunk), 0);
+        if (n <= 0) {
+            return;
+        }
+        request.append(chunk, static_cast<std::size_t>(n));
+    }
+
+    std::istringstream line(request.substr(0, request.find("\r\n")));
+    std::string method, target;
+    line >> method >> target;
+    target = target.substr(0, target.find('?'));
+
+    std::string status = "200 OK", body;
+    if (method == "GET" && target == "/metrics") {
+        std::ostringstream stream;
+        Metrics::exposition(stream);
+        body = stream.str();
+    }
+    else {
+        status = "404 Not Found";
+        body = "Not Found\n";
+    }
+
+    std::string response = "HTTP/1.1 " + status +
+                           "\r\nContent-Type: text/plain; version=0.0.4\r\n"
+                           "Content-Length: " +
+                           std::to_string(body.size()) +
+                           "\r\nConnection: close\r\n\r\n" + body;
+    std::size_t sent = 0;
+    while (sent < response.size()) {
+        ssize_t n = ::send(client, response.data() + sent,
+                           response.size() - sent, MSG_NOSIGNAL);
+        if (n <= 0) {
+            return;
+        }
+        sent += static_cast<std::size_t>(n);
+    }
+}
+
+// end private methods
+
+MetricsServer::MetricsServer(uint16_t port, const std::string& address)
+{
+    sockaddr_in sock{};
+    sock.sin_family = AF_INET;
+    sock.sin_port = htons(port);
+    if (inet_pton(AF_INET, address.c_str(), &sock.sin_addr) != 1) {
+        throw std::runtime_error("MetricsServer: invalid address " + address);
+    }
+
+    _fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    if (_fd < 0) {
+        throw std::runtime_error(std::string("MetricsServer: ") +
+                                 strerror(errno));
+    }
+    int one = 1;
+    setsockopt(_fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    socklen_t size = sizeof(sock);
+    if (::bind(_fd, reinterpret_cast<sockaddr*>(&sock), size) != 0 ||
+        ::listen(_fd, 16) != 0 ||
+        ::getsockname(_fd, reinterpret_cast<sockaddr*>(&sock), &size) != 0) {
+        std::string message = strerror(errno);
+        ::close(_fd);
+        throw std::runtime_error("MetricsServer: " + message);
+    }
+    _port = ntohs(sock.sin_port);
+    _thread = std::thread(&MetricsServer::_serve, this);
+}
+
+MetricsServer::~MetricsServer()
+{
+    _stop = true;
+    ::shutdown(_fd, SHUT_RDWR);
+    _thread.join();
+    ::close(_fd);
+}
+
+}  // namespace at
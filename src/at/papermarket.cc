@@ -0,0 +1,612 @@
+/* Copyright 2017 Paolo Galeone <nessuno@nerdz.eu>. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.*/
+
+#include <algorithm>
+#include <at/papermarket.hpp>
+#include <cmath>
+#include <cstdlib>
+#include <limits>
+
+namespace at {
+
+// private methods
+
+PaperMarket::node_t* PaperMarket::pool::get()
+{
+    if (_free != nullptr) {
+        node_t* node = _free;
+        _free = node->next;
+        return node;
+    }
+    if (_used == chunk_size) {
+        _chunks.emplace_back(new node_t[chunk_size]);
+        _used = 0;
+    }
+    return &_chunks.back()[_used++];
+}
+
+void PaperMarket::pool::put(node_t* node)
+{
+    node->next = _free;
+    _free = node;
+}
+
+uint32_t PaperMarket::_currency(const std::string& symbol)
+{
+    auto it = _currency_ids.find(symbol);
+    if (it != _currency_ids.end()) {
+        return it->second;
+    }
+    uint32_t id = static_cast<uint32_t>(_currencies.size());
+    _currency_ids[symbol] = id;
+    _currencies.push_back(symbol);
+    _total.push_back(0);
+    _reserved.push_back(0);
+    return id;
+}
+
+PaperMarket::book_t& PaperMarket::_book(const currency_pair_t& pair)
+{
+    auto it = _book_ids.find(pair.str());
+    if (it == _book_ids.end()) {
+        throw response_error("EQuery:Unknown asset pair");
+    }
+    return _books[it->second];
+}
+
+int64_t PaperMarket::_ticks(double price) const
+{
+    return std::llround(price / _tick);
+}
+
+double PaperMarket::_price(int64_t ticks) const { return ticks * _tick; }
+
+void PaperMarket::_settle(book_t& book, node_t* node, double quantity,
+                          int64_t price, double fee_percent)
+{
+    double value = quantity * _price(price);
+    double fee = value * fee_percent / 100;
+    node->cost += value;
+    node->fee += fee;
+
+    if (node->action == order_action_t::buy) {
+        _total[book.quote] -= value + fee;
+        _total[book.base] += quantity;
+        if (node->type == order_type_t::limit) {
+            double released = std::min(
+                node->reserved,
+                quantity * node->limit * (1 + book.info.taker_fee / 100));
+            node->reserved -= released;
+            _reserved[book.quote] -= released;
+        }
+    }
+    else {
+        _total[book.base] -= quantity;
+        _total[book.quote] += value - fee;
+        if (node->type == order_type_t::limit) {
+            double released = std::min(node->reserved, quantity);
+            node->reserved -= released;
+            _reserved[book.base] -= released;
+        }
+    }
+}
+
+void PaperMarket::_trade(book_t& book, node_t* incoming, node_t* maker,
+                         double quantity)
+{
+    incoming->remaining -= quantity;
+    maker->remaining -= quantity;
+    if (incoming->id != 0) {
+        _settle(book, incoming, quantity, maker->price, book.info.taker_fee);
+    }
+    if (maker->id != 0) {
+        _settle(book, maker, quantity, maker->price, book.info.maker_fee);
+    }
+}
+
+void PaperMarket::_match(book_t& book, node_t* incoming)
+{
+    bool buy = incoming->action == order_action_t::buy;
+    bool limit = incoming->type == order_type_t::limit;
+    side_t& opposite = buy ? book.asks : book.bids;
+
+    while (incoming->remaining > 0 && !opposite.empty()) {
+        auto best = opposite.begin();
+        int64_t price = buy ? best->first : -best->first;
+        bool crosses =
+            buy ? price <= incoming->price : price >= incoming->price;
+        if (limit && !crosses) {
+            break;
+        }
+        level_t& level = best->second;
+        while (incoming->remaining > 0 && level.head != nullptr) {
+            node_t* maker = level.head;
+            _trade(book, incoming, maker,
+                   std::min(incoming->remaining, maker->remaining));
+            if (maker->remaining > 0) {
+                break;
+            }
+            level.head = maker->next;
+            if (maker->id != 0) {
+                _close(maker, tx_status_t::closed);
+            }
+            else {
+                _pool.put(maker);
+            }
+        }
+        if (level.head == nullptr) {
+            opposite.erase(best);
+        }
+        else {
+            level.head->prev = nullptr;
+        }
+    }
+}
+
+void PaperMarket::_insert(book_t& book, node_t* node)
+{
+    bool buy = node->action == order_action_t::buy;
+    side_t& side = buy ? book.bids : book.asks;
+    int64_t key = buy ? -node->price : node->price;
+    // try_emplace doesn't allocate a map node if the level exists
+    level_t& level =
+        side.try_emplace(key, level_t{nullptr, nullptr}).first->second;
+    node->level = &level;
+    node->next = nullptr;
+    node->prev = level.tail;
+    if (level.tail != nullptr) {
+        level.tail->next = node;
+    }
+    else {
+        level.head = node;
+    }
+    level.tail = node;
+}
+
+void PaperMarket::_unlink(book_t& book, node_t* node)
+{
+    level_t* level = node->level;
+    if (node->prev != nullptr) {
+        node->prev->next = node->next;
+    }
+    else {
+        level->head = node->next;
+    }
+    if (node->next != nullptr) {
+        node->next->prev = node->prev;
+    }
+    else {
+        level->tail = node->prev;
+    }
+    if (level->head == nullptr) {
+        bool buy = node->action == order_action_t::buy;
+        if (buy) {
+            book.bids.erase(-node->price);
+        }
+        else {
+            book.asks.erase(node->price);
+        }
+    }
+}
+
+void PaperMarket::_close(node_t* node, tx_status_t status)
+{
+    const book_t& book = _books[node->book];
+    if (node->reserved > 0) {
+        uint32_t currency =
+            node->action == order_action_t::buy ? book.quote : book.base;
+        _reserved[currency] -= node->reserved;
+        node->reserved = 0;
+    }
+    _closed.push_back(history_t{
+        .id = node->id,
+        .book = node->book,
+        .status = status,
+        .type = node->type,
+        .action = node->action,
+        .open = node->open,
+        .close = _now,
+        .volume = node->volume,
+        .cost = node->cost,
+        .fee = node->fee,
+        .price = node->limit,
+    });
+    _open.erase(node->id);
+    _pool.put(node);
+}
+
+order_t PaperMarket::_order(const node_t* node) const
+{
+    return order_t{
+        .txid = "O" + std::to_string(node->id),
+        .status = tx_status_t::open,
+        .type = node->type,
+        .action = node->action,
+        .pair = _books[node->book].info.pair,
+        .open = node->open,
+        .close = 0,
+        .volume = node->volume,
+        .cost = node->cost,
+        .fee = node->fee,
+        .price = node->limit,
+    };
+}
+
+order_t PaperMarket::_order(const history_t& record) const
+{
+    return order_t{
+        .txid = "O" + std::to_string(record.id),
+        .status = record.status,
+        .type = record.type,
+        .action = record.action,
+        .pair = _books[record.book].info.pair,
+        .open = record.open,
+        .close = record.close,
+        .volume = record.volume,
+        .cost = record.cost,
+        .fee = record.fee,
+        .price = record.price,
+    };
+}
+
+// end private methods
+
+PaperMarket::PaperMarket(const std::vector<market_info_t>& markets,
+                         const std::map<std::string, double>& balance,
+                         double tick)
+    : _tick(tick), _now(std::time(nullptr))
+{
+    if (tick <= 0) {
+        throw std::invalid_argument("PaperMarket: tick must be positive");
+    }
+    _books.reserve(markets.size());
+    for (const auto& market : markets) {
+        if (_book_ids.find(market.pair.str()) != _book_ids.end()) {
+            continue;
+        }
+        _book_ids[market.pair.str()] = static_cast<uint32_t>(_books.size());
+        _books.push_back(book_t{
+            .info = market,
+            .base = _currency(market.pair.first),
+            .quote = _currency(market.pair.second),
+            .bids = {},
+            .asks = {},
+        });
+    }
+    for (const auto& [currency, amount] : balance) {
+        deposit(currency, amount);
+    }
+}
+
+void PaperMarket::feed(currency_pair_t pair, const std::vector<ticker_t>& book)
+{
+    book_t& target = _book(pair);
+    uint32_t book_id = _book_ids[pair.str()];
+
+    // remove the previous liquidity
+    for (side_t* side : {&target.bids, &target.asks}) {
+        for (auto level = side->begin(); level != side->end();) {
+            int64_t key = level->first;
+            node_t* node = level->second.head;
+            while (node != nullptr) {
+                node_t* next = node->next;
+                if (node->id == 0) {
+                    _unlink(target, node);
+                    _pool.put(node);
+                }
+                node = next;
+            }
+            // _unlink erases the empty levels: continue from the first
+            // level not visited
+            level = side->upper_bound(key);
+        }
+    }
+
+    auto add = [&](const quotation_t& quotation, order_action_t action) {
+        if (quotation.amount <= 0 || quotation.price <= 0) {
+            return;
+        }
+        node_t* node = _pool.get();
+        *node = node_t{
+            .prev = nullptr,
+            .next = nullptr,
+            .level = nullptr,
+            .id = 0,
+            .price = _ticks(quotation.price),
+            .remaining = quotation.amount,
+            .volume = quotation.amount,
+            .cost = 0,
+            .fee = 0,
+            .reserved = 0,
+            .limit = quotation.price,
+            .open = _now,
+            .book = book_id,
+            .action = action,
+            .type = order_type_t::limit,
+        };
+        _match(target, node);
+        if (node->remaining > 0) {
+            _insert(target, node);
+        }
+        else {
+            _pool.put(node);
+        }
+    };
+
+    for (const auto& ticker : book) {
+        add(ticker.ask, order_action_t::sell);
+        add(ticker.bid, order_action_t::buy);
+    }
+}
+
+void PaperMarket::deposit(std::string currency, double amount)
+{
+    toupper(currency);
+    _total[_currency(currency)] += amount;
+}
+
+deposit_info_t PaperMarket::depositInfo(std::string currency)
+{
+    toupper(currency);
+    return deposit_info_t{
+        .limit = min_max_t{.min = 0,
+                           .max = std::numeric_limits<double>::infinity()},
+        .fee = 0,
+        .currency = currency,
+        .method = "paper",
+    };
+}
+
+std::vector<market_info_t> PaperMarket::info()
+{
+    std::vector<market_info_t> ret;
+    ret.reserve(_books.size());
+    for (const auto& book : _books) {
+        ret.push_back(book.info);
+    }
+    return ret;
+}
+
+market_info_t PaperMarket::info(currency_pair_t pair)
+{
+    return _book(pair).info;
+}
+
+ticker_t PaperMarket::ticker(currency_pair_t pair)
+{
+    const book_t& book = _book(pair);
+    auto best = [this](const side_t& side, bool bid) {
+        quotation_t ret{.price = 0, .amount = 0, .time = _now};
+        if (side.empty()) {
+            return ret;
+        }
+        auto level = side.begin();
+        ret.price = _price(bid ? -level->first : level->first);
+        for (node_t* node = level->second.head; node != nullptr;
+             node = node->next) {
+            ret.amount += node->remaining;
+        }
+        return ret;
+    };
+    return ticker_t{
+        .bid = best(book.bids, true),
+        .ask = best(book.asks, false),
+    };
+}
+
+std::vector<ticker_t> PaperMarket::orderBook(currency_pair_t pair)
+{
+    const book_t& book = _book(pair);
+    auto quotation = [this](const side_t::value_type& level, bool bid) {
+        quotation_t ret{
+            .price = _price(bid ? -level.first : level.first),
+            .amount = 0,
+            .time = _now,
+        };
+        for (node_t* node = level.second.head; node != nullptr;
+             node = node->next) {
+            ret.amount += node->remaining;
+        }
+        return ret;
+    };
+
+    // As Kraken::orderBook, every ticker contains the i-th bid and ask
+    std::vector<ticker_t> ret;
+    ret.reserve(std::min(book.bids.size(), book.asks.size()));
+    for (auto bid = book.bids.begin(), ask = book.asks.begin();
+         bid != book.bids.end() && ask != book.asks.end(); ++bid, ++ask) {
+        ret.push_back(ticker_t{
+            .bid = quotation(*bid, true),
+            .ask = quotation(*ask, false),
+        });
+    }
+    return ret;
+}
+
+std::map<std::string, coin_t> PaperMarket::coins()
+{
+    std::map<std::string, coin_t> ret;
+    for (const auto& currency : _currencies) {
+        ret[currency] = coin_t{
+            .name = currency,
+            .symbol = currency,
+            .status = "enabled",
+        };
+    }
+    return ret;
+}
+
+std::map<std::string, double> PaperMarket::balance()
+{
+    std::map<std::string, double> ret;
+    for (std::size_t i = 0; i < _currencies.size(); ++i) {
+        ret[_currencies[i]] = _total[i];
+    }
+    return ret;
+}
+
+double PaperMarket::balance(std::string currency)
+{
+    toupper(currency);
+    auto it = _currency_ids.find(currency);
+    if (it == _currency_ids.end()) {
+        return 0;
+    }
+    return _total[it->second];
+}
+
+std::vector<order_t> PaperMarket::openOrders()
+{
+    std::vector<node_t*> nodes;
+    nodes.reserve(_open.size());
+    for (const auto& [id, node] : _open) {
+        nodes.push_back(node);
+    }
+    std::sort(nodes.begin(), nodes.end(),
+              [](const node_t* a, const node_t* b) { return a->id < b->id; });
+
+    std::vector<order_t> ret;
+    ret.reserve(nodes.size());
+    for (const node_t* node : nodes) {
+        ret.push_back(_order(node));
+    }
+    return ret;
+}
+
+std::vector<order_t> PaperMarket::closedOrders()
+{
+    std::vector<order_t> ret;
+    ret.reserve(_closed.size());
+    for (const auto& record : _closed) {
+        ret.push_back(_order(record));
+    }
+    return ret;
+}
+
+void PaperMarket::place(order_t& order)
+{
+    book_t& book = _book(order.pair);
+    bool buy = order.action == order_action_t::buy;
+    bool limit = order.type == order_type_t::limit;
+
+    if (limit) {
+        if (order.volume * order.price <= 0) {
+            throw std::runtime_error(
+                "order.volume * order.price can't be <= 0");
+        }
+    }
+    else if (order.volume <= 0) {
+        throw std::runtime_error("order.volume can't be <= 0");
+    }
+    if (order.volume < book.info.limit.min ||
+        (book.info.limit.max > 0 && order.volume > book.info.limit.max)) {
+        throw response_error("EOrder:Order minimum not met");
+    }
+    int64_t price = limit ? _ticks(order.price) : 0;
+    if (limit && price <= 0) {
+        throw response_error("EOrder:Invalid price");
+    }
+
+    // funds needed by the order
+    double needed = order.volume;
+    uint32_t currency = book.base;
+    if (buy) {
+        currency = book.quote;
+        if (limit) {
+            needed = order.volume * order.price *
+                     (1 + book.info.taker_fee / 100);
+        }
+        else {
+            // cost of the execution against the current book
+            needed = 0;
+            double volume = order.volume;
+            for (auto level = book.asks.begin();
+                 level != book.asks.end() && volume > 0; ++level) {
+                for (node_t* node = level->second.head;
+                     node != nullptr && volume > 0; node = node->next) {
+                    double quantity = std::min(volume, node->remaining);
+                    needed += quantity * _price(level->first);
+                    volume -= quantity;
+                }
+            }
+            needed *= 1 + book.info.taker_fee / 100;
+        }
+    }
+    if (_total[currency] - _reserved[currency] < needed) {
+        throw response_error("EOrder:Insufficient funds");
+    }
+
+    node_t* node = _pool.get();
+    *node = node_t{
+        .prev = nullptr,
+        .next = nullptr,
+        .level = nullptr,
+        .id = _next_id++,
+        .price = price,
+        .remaining = order.volume,
+        .volume = order.volume,
+        .cost = 0,
+        .fee = 0,
+        .reserved = limit ? needed : 0,
+        .limit = limit ? order.price : 0,
+        .open = _now,
+        .book = static_cast<uint32_t>(&book - _books.data()),
+        .action = order.action,
+        .type = order.type,
+    };
+    _reserved[currency] += node->reserved;
+
+    uint64_t id = node->id;
+    _open[id] = node;
+    _match(book, node);
+
+    order.txid = "O" + std::to_string(id);
+    order.open = _now;
+    order.cost = node->cost;
+    order.fee = node->fee;
+    if (node->remaining <= 0) {
+        order.status = tx_status_t::closed;
+        order.close = _now;
+        _close(node, tx_status_t::closed);
+    }
+    else if (!limit) {
+        // the book has been exhausted
+        order.status =
+            node->cost > 0 ? tx_status_t::closed : tx_status_t::canceled;
+        order.close = _now;
+        _close(node, order.status);
+    }
+    else {
+        order.status = tx_status_t::open;
+        order.close = 0;
+        _insert(book, node);
+    }
+}
+
+void PaperMarket::cancel(order_t& order)
+{
+    auto it = order.txid.size() > 1 && order.txid[0] == 'O'
+                  ? _open.find(std::strtoull(order.txid.c_str() + 1, nullptr,
+                                             10))
+                  : _open.end();
+    if (it == _open.end()) {
+        throw response_error("EOrder:Unknown order");
+    }
+    node_t* node = it->second;
+    _unlink(_books[node->book], node);
+    _close(node, tx_status_t::canceled);
+    order = {};
+}
+
+}  // namespace at
@@ -0,0 +1,219 @@
+/* Copyright 2017 Paolo Galeone <nessuno@nerdz.eu>. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.*/
+
+#include <algorithm>
+#include <at/rategraph.hpp>
+
+namespace at {
+
+// private methods
+
+uint32_t RateGraph::_id(const std::string& currency)
+{
+    auto it = _ids.find(currency);
+    if (it != _ids.end()) {
+        return it->second;
+    }
+    uint32_t id = static_cast<uint32_t>(_currencies.size());
+    _ids[currency] = id;
+    _currencies.push_back(currency);
+    _edges.emplace_back();
+    return id;
+}
+
+// end private methods
+
+std::size_t RateGraph::update(const std::vector<exchange_info_t>& markets)
+{
+    ++_epoch;
+    std::size_t changed = 0;
+    for (const auto& market : markets) {
+        uint32_t from = _id(market.pair.first);
+        uint32_t to = _id(market.pair.second);
+        uint64_t key = static_cast<uint64_t>(from) << 32 | to;
+
+        auto position = _edge_position.find(key);
+        if (position == _edge_position.end()) {
+            _edge_position[key] = _edges[from].size();
+            _edges[from].push_back(edge_t{
+                .to = to,
+                .rate = market.rate,
+                .miner_fee = market.miner_fee,
+                .limit = market.limit,
+                .seen = _epoch,
+            });
+            ++changed;
+            continue;
+        }
+
+        auto& edge = _edges[from][position->second];
+        if (edge.rate != market.rate || edge.miner_fee != market.miner_fee ||
+            edge.limit.min != market.limit.min ||
+            edge.limit.max != market.limit.max || edge.rate <= 0) {
+            edge.rate = market.rate;
+            edge.miner_fee = market.miner_fee;
+            edge.limit = market.limit;
+            ++changed;
+        }
+        edge.seen = _epoch;
+    }
+
+    // disable the edges no more present
+    for (auto& edges : _edges) {
+        for (auto& edge : edges) {
+            if (edge.seen != _epoch && edge.rate > 0) {
+                edge.rate = 0;
+                ++changed;
+            }
+        }
+    }
+    return changed;
+}
+
+conversion_t RateGraph::best(std::string from, std::string to, double amount,
+                             std::size_t max_hops) const
+{
+    toupper(from);
+    toupper(to);
+    conversion_t ret{.path = {}, .input = amount, .output = 0};
+
+    auto source = _ids.find(from);
+    auto target = _ids.find(to);
+    if (source == _ids.end() || target == _ids.end() || max_hops == 0 ||
+        amount <= 0) {
+        return ret;
+    }
+
+    // layers[h] = candidates reached with h conversions, grouped by node.
+    // Keeping only the largest amount of a node is wrong: a smaller one
+    // can be in the limits of an edge where the largest is above
+    // limit.max. Hence a node keeps, for every edge leaving it, the
+    // largest amount in the limits of the edge (at most max_candidates).
+    typedef struct {
+        double amount;
+        uint32_t node;
+        uint32_t parent;  // index in the previous layer
+    } candidate_t;
+    const uint32_t none = static_cast<uint32_t>(-1);
+    std::vector<std::vector<candidate_t>> layers(1);
+    layers[0].push_back(candidate_t{amount, source->second, none});
+
+    // Whether node is on the path of candidate c of layer hop
+    auto visited = [&layers](std::size_t hop, uint32_t c, uint32_t node) {
+        for (; c != none; c = layers[hop--][c].parent) {
+            if (layers[hop][c].node == node) {
+                return true;
+            }
+        }
+        return false;
+    };
+
+    std::vector<std::vector<candidate_t>> reached(_currencies.size());
+    std::vector<uint32_t> touched;
+    std::vector<bool> keep;
+    std::size_t best_hop = 0;
+    uint32_t best_candidate = none;
+    for (std::size_t hop = 1; hop <= max_hops && !layers.back().empty();
+         ++hop) {
+        const auto& previous = layers[hop - 1];
+        for (uint32_t c = 0; c < previous.size(); ++c) {
+            const auto& candidate = previous[c];
+            // paths through the target are never better
+            if (candidate.node == target->second) {
+                continue;
+            }
+            for (const auto& edge : _edges[candidate.node]) {
+                // the last conversion can only reach the target
+                if ((hop == max_hops && edge.to != target->second) ||
+                    edge.rate <= 0 || candidate.amount < edge.limit.min ||
+                    candidate.amount > edge.limit.max ||
+                    visited(hop - 1, c, edge.to)) {
+                    continue;
+                }
+                double output = candidate.amount * edge.rate - edge.miner_fee;
+                if (output <= 0) {
+                    continue;
+                }
+                if (reached[edge.to].empty()) {
+                    touched.push_back(edge.to);
+                }
+                reached[edge.to].push_back(candidate_t{output, edge.to, c});
+            }
+        }
+
+        layers.emplace_back();
+        auto& current = layers.back();
+        for (auto node : touched) {
+            auto& candidates = reached[node];
+            // largest amount first, on equal amounts the first reached
+            std::sort(candidates.begin(), candidates.end(),
+                      [](const candidate_t& a, const candidate_t& b) {
+                          return a.amount > b.amount ||
+                                 (a.amount == b.amount && a.parent < b.parent);
+                      });
+            if (node == target->second) {
+                if (candidates[0].amount > ret.output) {
+                    ret.output = candidates[0].amount;
+                    best_hop = hop;
+                    best_candidate = static_cast<uint32_t>(current.size());
+                }
+                current.push_back(candidates[0]);
+                candidates.clear();
+                continue;
+            }
+
+            keep.assign(candidates.size(), false);
+            keep[0] = true;
+            for (const auto& edge : _edges[node]) {
+                if (edge.rate <= 0) {
+                    continue;
+                }
+                // the first amount not above limit.max is the largest one
+                // in the limits, if it is not below limit.min
+                auto in_limits = std::partition_point(
+                    candidates.begin(), candidates.end(),
+                    [&edge](const candidate_t& candidate) {
+                        return candidate.amount > edge.limit.max;
+                    });
+                if (in_limits != candidates.end() &&
+                    in_limits->amount >= edge.limit.min) {
+                    keep[in_limits - candidates.begin()] = true;
+                }
+            }
+            std::size_t kept = 0;
+            for (std::size_t i = 0;
+                 i < candidates.size() && kept < max_candidates; ++i) {
+                if (keep[i]) {
+                    current.push_back(candidates[i]);
+                    ++kept;
+                }
+            }
+            candidates.clear();
+        }
+        touched.clear();
+    }
+
+    if (best_hop == 0) {
+        return ret;
+    }
+
+    ret.path.resize(best_hop + 1);
+    for (std::size_t hop = best_hop + 1, c = best_candidate; hop-- > 0;) {
+        ret.path[hop] = _currencies[layers[hop][c].node];
+        c = layers[hop][c].parent;
+    }
+    return ret;
+}
+
+}  // namespace at
@@ -0,0 +1,177 @@
+/* Copyright 2017 Paolo Galeone <nessuno@nerdz.eu>. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.*/
+
+#include <algorithm>
+#include <at/replay.hpp>
+
+namespace at {
+
+namespace {
+
+// std::push_heap/pop_heap build a max heap: greater makes it a min heap
+// ordered by time and then by source index
+const std::greater<std::pair<std::time_t, std::size_t>> later;
+
+}  // end namespace
+
+// private methods
+
+void Replay::_fill_heap()
+{
+    _heap.clear();
+    for (std::size_t i = 0; i < _sources.size(); ++i) {
+        auto& source = _sources[i];
+        for (auto& pair : source.pairs) {
+            pair.levels.clear();
+            pair.expected = 0;
+        }
+        if (source.log->next(source.event)) {
+            _heap.emplace_back(source.event.time, i);
+        }
+    }
+    std::make_heap(_heap.begin(), _heap.end(), later);
+}
+
+Replay::pair_state_t& Replay::_pair(source_t& source, uint16_t id)
+{
+    if (id < source.pairs.size() && source.pairs[id].book != -2) {
+        return source.pairs[id];
+    }
+    if (id >= source.pairs.size()) {
+        source.pairs.resize(id + 1, pair_state_t{.book = -2,
+                                                 .bid = {},
+                                                 .levels = {},
+                                                 .expected = 0});
+    }
+
+    // first event of the pair: find its book in the market
+    auto& state = source.pairs[id];
+    const currency_pair_t& pair = source.log->pair(id);
+    auto known = std::find(_books.begin(), _books.end(), pair);
+    if (known != _books.end()) {
+        state.book = known - _books.begin();
+        return state;
+    }
+    try {
+        _market.info(pair);
+        state.book = static_cast<int64_t>(_books.size());
+        _books.push_back(pair);
+    }
+    catch (const response_error&) {
+        state.book = -1;
+    }
+    return state;
+}
+
+const currency_pair_t* Replay::_apply(source_t& source,
+                                      const market_event_t& event)
+{
+    auto& state = _pair(source, event.pair);
+    if (state.book < 0) {
+        return nullptr;
+    }
+    const currency_pair_t& pair = _books[state.book];
+    quotation_t quotation{
+        .price = event.price,
+        .amount = event.amount,
+        .time = event.time,
+    };
+
+    switch (event.type) {
+        case market_event_type_t::bid:
+            state.bid = quotation;
+            return nullptr;
+        case market_event_type_t::ask:
+            _market.feed(pair, {ticker_t{.bid = state.bid, .ask = quotation}});
+            return &pair;
+        case market_event_type_t::book:
+            state.levels.clear();
+            state.expected = static_cast<std::size_t>(event.amount);
+            if (state.expected == 0) {
+                _market.feed(pair, state.levels);
+                return &pair;
+            }
+            return nullptr;
+        case market_event_type_t::book_bid:
+            // levels of a snapshot started before a seek are skipped
+            if (state.levels.size() < state.expected) {
+                state.levels.push_back(ticker_t{.bid = quotation, .ask = {}});
+            }
+            return nullptr;
+        case market_event_type_t::book_ask:
+            if (state.expected == 0 || state.levels.empty()) {
+                return nullptr;
+            }
+            state.levels.back().ask = quotation;
+            if (state.levels.size() == state.expected) {
+                _market.feed(pair, state.levels);
+                state.expected = 0;
+                return &pair;
+            }
+            return nullptr;
+        default:
+            // trades
+            return &pair;
+    }
+}
+
+// end private methods
+
+Replay::Replay(PaperMarket& market, const std::vector<std::string>& paths)
+    : _market(market)
+{
+    _sources.reserve(paths.size());
+    for (const auto& path : paths) {
+        _sources.push_back(source_t{
+            .log = std::make_unique<MarketLog>(path),
+            .event = {},
+            .pairs = {},
+        });
+    }
+    _fill_heap();
+}
+
+void Replay::seek(std::time_t time)
+{
+    for (auto& source : _sources) {
+        source.log->seek(time);
+    }
+    _fill_heap();
+}
+
+std::size_t Replay::run(callback_t callback, std::time_t until)
+{
+    std::size_t count = 0;
+    while (!_heap.empty() && _heap.front().first < until) {
+        std::pop_heap(_heap.begin(), _heap.end(), later);
+        std::size_t index = _heap.back().second;
+        _heap.pop_back();
+
+        auto& source = _sources[index];
+        ++count;
+        _market.time(source.event.time);
+        const currency_pair_t* changed = _apply(source, source.event);
+        if (changed != nullptr && callback) {
+            callback(source.event, *changed);
+        }
+
+        if (source.log->next(source.event)) {
+            _heap.emplace_back(source.event.time, index);
+            std::push_heap(_heap.begin(), _heap.end(), later);
+        }
+    }
+    return count;
+}
+
+}  // namespace at
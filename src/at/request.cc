@@ -12,146 +12,353 @@
  * See the License for the specific language governing permissions and
  * limitations under the License.*/
 
+#include <algorithm>
 #include <at/exceptions.hpp>
 #include <at/request.hpp>
 #include <at/types.hpp>
 
 namespace at {
 
-using namespace curlpp::options;
+// private methods
 
-std::string Request::getHTML(std::string url) { return _get(url); }
+void FormBody::_append(const std::string& data)
+{
+    static const char hex[] = "0123456789ABCDEF";
+    for (unsigned char c : data) {
+        if ((c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z') ||
+            (c >= '0' && c <= '9') || c == '-' || c == '.' || c == '_' ||
+            c == '~') {
+            _body += static_cast<char>(c);
+        }
+        else {
+            _body += '%';
+            _body += hex[c >> 4];
+            _body += hex[c & 0x0f];
+        }
+    }
+}
 
-json Request::get(std::string url) { return json::parse(_get(url)); }
+std::shared_ptr<Transport>& Request::_transport()
+{
+    static std::shared_ptr<Transport> transport =
+        std::make_shared<CurlTransport>();
+    return transport;
+}
 
-std::string Request::_get(std::string url)
+std::shared_ptr<const http_timeouts_t>& Request::_timeouts()
 {
-    curlpp::Easy req;
-    std::ostringstream stream;
-    try {
-        req.setOpt(Url(url));
-        req.setOpt(FollowLocation(true));
-        req.setOpt(SslVersion(CURL_SSLVERSION_TLSv1_2));
-        for (auto opt : _options) {
-            req.setOpt(*opt);
-        }
+    static std::shared_ptr<const http_timeouts_t> timeouts =
+        std::make_shared<http_timeouts_t>(http_timeouts_t{
+            .connect = std::chrono::seconds(10),
+            .total = std::chrono::milliseconds(0),
+            .low_speed_limit = 1,
+            .low_speed_time = std::chrono::seconds(30),
+        });
+    return timeouts;
+}
 
-        if (!_headers.empty()) {
-            req.setOpt(HttpHeader(_headers));
-        }
+std::shared_ptr<const RetryPolicy>& Request::_retry_policy()
+{
+    static std::shared_ptr<const RetryPolicy> policy =
+        std::make_shared<RetryPolicy>();
+    return policy;
+}
 
-        req.setOpt(WriteStream(&stream));
-        req.perform();
+void Request::_finish()
+{
+    if (_endpoint == nullptr) {
+        return;
     }
-    catch (const curlpp::LibcurlRuntimeError& e) {
-        throw server_error(e.what());
+    auto now = std::chrono::steady_clock::now();
+    if (_is_parsed) {
+        Latency::record(_endpoint, latency_phase_t::convert, now - _parsed);
     }
+    Latency::record(_endpoint, latency_phase_t::total, now - _start);
+    _endpoint = nullptr;
+    _is_parsed = false;
+}
 
-    long code = curlpp::infos::ResponseCode::get(req);
-    if (code == 200L) {
-        return stream.str();
+json Request::_parse(std::string&& body)
+{
+    auto start = std::chrono::steady_clock::now();
+    json ret = json::parse(body);
+    Transport::recycle(std::move(body));
+    _parsed = std::chrono::steady_clock::now();
+    _is_parsed = true;
+    if (_endpoint != nullptr) {
+        Latency::record(_endpoint, latency_phase_t::parse, _parsed - start);
     }
-
-    stream.str("");
-    stream.clear();
-    stream << "GET " << url << "; status = " << code;
-    throw server_error(stream.str());
+    return ret;
 }
 
-json Request::post(std::string url, json params)
+http_timeouts_t Request::_bounded_timeouts(const std::string& what)
 {
-    curlpp::Easy req;
-    std::ostringstream stream;
-    try {
-        req.setOpt(Url(url));
-        req.setOpt(FollowLocation(true));
-        req.setOpt(SslVersion(CURL_SSLVERSION_TLSv1_2));
-        for (auto opt : _options) {
-            req.setOpt(*opt);
+    auto timeouts = *Request::timeouts();
+    if (Deadline::active()) {
+        auto remaining = Deadline::remaining();
+        if (remaining.count() <= 0) {
+            throw deadline_exceeded("deadline exceeded before " + what);
         }
+        // at least 1 ms: a timeout of 0 disables it
+        auto left = std::max(
+            std::chrono::duration_cast<std::chrono::milliseconds>(remaining),
+            std::chrono::milliseconds(1));
+        if (timeouts.total.count() == 0 || timeouts.total > left) {
+            timeouts.total = left;
+        }
+    }
+    return timeouts;
+}
 
-        std::list<std::string> headers({"Content-Type: application/json"});
-        if (!_headers.empty()) {
-            headers.insert(headers.end(), _headers.begin(), _headers.end());
+json Request::_checked(std::string&& body)
+{
+    auto breaker = _breaker;
+    try {
+        json ret = _parse(std::move(body));
+        if (_check) {
+            _check(ret);
         }
-        req.setOpt(HttpHeader(headers));
+        breaker->success();
+        return ret;
+    }
+    catch (const server_error&) {
+        breaker->failure();
+        throw;
+    }
+    catch (const json::parse_error&) {
+        // a 200 that's not JSON is a maintenance or a proxy error page:
+        // the host is not healthy
+        breaker->failure();
+        throw;
+    }
+    catch (...) {
+        // the server answered: not a failure of the host
+        breaker->success();
+        throw;
+    }
+}
 
-        // Write params to a stream and use the stream to
-        // convert to string
-        stream << params;
-        std::string data = stream.str();
-        req.setOpt(PostFields(data));
-        req.setOpt(PostFieldSize(data.length()));
+std::string Request::_perform(const std::string& method,
+                              const std::string& url,
+                              std::list<std::string> headers,
+                              std::string body, const std::string& label)
+{
+    _finish();
+    _start = std::chrono::steady_clock::now();
+    // endpoint: method, host and path
+    const auto& named = _endpoint_url.empty() ? url : _endpoint_url;
+    auto scheme = named.find("://");
+    auto start = scheme == std::string::npos ? 0 : scheme + 3;
+    _endpoint = Latency::endpoint(
+        method + " " + named.substr(start, named.find('?', start) - start));
+    scheme = url.find("://");
+    auto host = scheme == std::string::npos ? 0 : scheme + 3;
+    auto hostname = url.substr(host, url.find_first_of("/?", host) - host);
+    auto metrics = Metrics::host(hostname);
+    Metrics::current(metrics);
+    _breaker = CircuitBreaker::host(hostname);
 
-        stream.str("");
-        stream.clear();
-        req.setOpt(WriteStream(&stream));
-        req.perform();
+    const bool deadline = Deadline::active();
+    http_timeouts_t timeouts;
+    try {
+        timeouts = _bounded_timeouts(label + url);
+    }
+    catch (const deadline_exceeded&) {
+        Metrics::add(metrics, metric_t::deadlines);
+        throw;
     }
-    catch (const curlpp::LibcurlRuntimeError& e) {
-        throw server_error(e.what());
+    if (!_breaker->allow()) {
+        Metrics::add(metrics, metric_t::server_errors);
+        throw circuit_open_error("circuit open for " + hostname + ": " +
+                                 label + url);
     }
+    Metrics::add(metrics, metric_t::requests);
+    Metrics::add(metrics, metric_t::bytes_out,
+                 static_cast<int64_t>(body.size()));
 
-    long code = curlpp::infos::ResponseCode::get(req);
-    if (code == 200L) {
-        return json::parse(stream.str());
+    http_request_t request = {
+        .method = method,
+        .url = url,
+        .headers = std::move(headers),
+        .body = std::move(body),
+        .timeouts = timeouts,
+        .options = _options,
+    };
+    Metrics::add(metrics, metric_t::in_flight);
+    http_response_t response;
+    try {
+        response = transport()->perform(request);
+    }
+    catch (const server_error& e) {
+        Metrics::add(metrics, metric_t::in_flight, -1);
+        if (deadline && Deadline::remaining().count() <= 0) {
+            // aborted by the deadline: not a failure of the host
+            Metrics::add(metrics, metric_t::deadlines);
+            throw deadline_exceeded(std::string("deadline exceeded: ") +
+                                    e.what());
+        }
+        Metrics::add(metrics, metric_t::server_errors);
+        _breaker->failure();
+        throw;
+    }
+    Metrics::add(metrics, metric_t::in_flight, -1);
+    Metrics::add(metrics, metric_t::bytes_in,
+                 static_cast<int64_t>(response.body.size()));
+    const auto& timing = response.timing;
+    if (timing.total.count() > 0) {
+        Latency::record(_endpoint, latency_phase_t::dns, timing.dns);
+        Latency::record(_endpoint, latency_phase_t::connect, timing.connect);
+        if (timing.tls.count() > 0) {
+            Latency::record(_endpoint, latency_phase_t::tls, timing.tls);
+        }
+        Latency::record(_endpoint, latency_phase_t::first_byte,
+                        timing.first_byte);
+        Latency::record(_endpoint, latency_phase_t::transfer,
+                        timing.transfer);
+    }
+    if (response.status == 200L) {
+        return std::move(response.body);
     }
 
-    stream.str("");
-    stream.clear();
-    stream << "POST JSON" << url << "; status = " << code;
+    // an overloaded or failing server, any other status is an answer
+    if (response.status >= 500L || response.status == 429L) {
+        _breaker->failure();
+    }
+    else {
+        _breaker->success();
+    }
+    Metrics::add(metrics, metric_t::server_errors);
+    std::ostringstream stream;
+    stream << label << url << "; status = " << response.status;
+    if (response.status == 429L) {
+        throw rate_limit_error(stream.str());
+    }
     throw server_error(stream.str());
 }
 
-json Request::post(std::string url,
-                   std::vector<std::pair<std::string, std::string>> params)
+std::string Request::_get(std::string url)
 {
-    curlpp::Easy req;
-    std::ostringstream stream;
-    try {
-        req.setOpt(Url(url));
-        req.setOpt(FollowLocation(true));
-        req.setOpt(SslVersion(CURL_SSLVERSION_TLSv1_2));
-        for (auto opt : _options) {
-            req.setOpt(*opt);
-        }
+    return _perform("GET", url, _headers, "", "GET ");
+}
 
-        std::list<std::string> headers(
-            {"Content-Type: application/x-www-form-urlencoded"});
-        if (!_headers.empty()) {
-            headers.insert(headers.end(), _headers.begin(), _headers.end());
-        }
-        req.setOpt(HttpHeader(headers));
+// end private methods
 
-        for (auto& pair : params) {
-            std::string key(pair.first);
-            std::string value(pair.second);
-            stream << key << "=" << curlpp::escape(value) << "&";
-        }
+std::shared_ptr<Transport> Request::transport()
+{
+    return std::atomic_load(&_transport());
+}
 
-        auto postFields = stream.str();
-        postFields.pop_back();  // remove last &
-        req.setOpt(PostFields(postFields));
-        req.setOpt(PostFieldSize(postFields.length()));
+void Request::transport(std::shared_ptr<Transport> transport)
+{
+    std::atomic_store(&_transport(), transport);
+}
+
+std::shared_ptr<const RetryPolicy> Request::retry_policy()
+{
+    return std::atomic_load(&_retry_policy());
+}
 
-        stream.str("");
-        stream.clear();
-        req.setOpt(WriteStream(&stream));
-        req.perform();
+void Request::retry_policy(RetryPolicy policy)
+{
+    std::shared_ptr<const RetryPolicy> ptr =
+        std::make_shared<RetryPolicy>(std::move(policy));
+    std::atomic_store(&_retry_policy(), ptr);
+}
+
+std::shared_ptr<const http_timeouts_t> Request::timeouts()
+{
+    return std::atomic_load(&_timeouts());
+}
+
+void Request::timeouts(http_timeouts_t timeouts)
+{
+    std::shared_ptr<const http_timeouts_t> ptr =
+        std::make_shared<http_timeouts_t>(timeouts);
+    std::atomic_store(&_timeouts(), ptr);
+}
+
+void Request::warmup(const std::string& url)
+{
+    http_request_t request = {};
+    request.method = "HEAD";
+    request.url = url;
+    request.timeouts = _bounded_timeouts("warmup of " + url);
+    try {
+        transport()->warmup(request);
     }
-    catch (const curlpp::LibcurlRuntimeError& e) {
-        throw server_error(e.what());
+    catch (const server_error& e) {
+        if (Deadline::active() && Deadline::remaining().count() <= 0) {
+            throw deadline_exceeded(std::string("deadline exceeded: ") +
+                                    e.what());
+        }
+        throw;
+    }
+}
+
+std::string Request::getHTML(std::string url)
+{
+    auto ret = retry_policy()->run(true, [&]() { return _get(url); });
+    _breaker->success();
+    // the HTML is parsed by the caller
+    _parsed = std::chrono::steady_clock::now();
+    _is_parsed = true;
+    return ret;
+}
+
+FormBody::FormBody(
+    const std::vector<std::pair<std::string, std::string>>& params)
+{
+    for (const auto& pair : params) {
+        add(pair.first, pair.second);
     }
+}
 
-    long code = curlpp::infos::ResponseCode::get(req);
-    if (code == 200L) {
-        return json::parse(stream.str());
+FormBody& FormBody::add(const std::string& key, const std::string& value)
+{
+    if (!_body.empty()) {
+        _body += '&';
     }
+    _append(key);
+    _body += '=';
+    _append(value);
+    return *this;
+}
 
-    stream.str("");
-    stream.clear();
-    stream << "POST " << url << "; status = " << code;
-    throw server_error(stream.str());
+json Request::get(std::string url)
+{
+    return retry_policy()->run(true, [&]() { return _checked(_get(url)); });
+}
+
+json Request::post(std::string url, json params)
+{
+    std::list<std::string> headers({"Content-Type: application/json"});
+    headers.insert(headers.end(), _headers.begin(), _headers.end());
+
+    // Write params to a stream and use the stream to
+    // convert to string
+    std::ostringstream stream;
+    stream << params;
+    auto body = stream.str();
+    return retry_policy()->run(false, [&]() {
+        return _checked(_perform("POST", url, headers, body, "POST JSON"));
+    });
+}
+
+json Request::post(std::string url,
+                   std::vector<std::pair<std::string, std::string>> params)
+{
+    return post(url, FormBody(params));
+}
+
+json Request::post(std::string url, const FormBody& body)
+{
+    std::list<std::string> headers(
+        {"Content-Type: application/x-www-form-urlencoded"});
+    headers.insert(headers.end(), _headers.begin(), _headers.end());
+
+    return retry_policy()->run(false, [&]() {
+        return _checked(_perform("POST", url, headers, body.str(), "POST "));
+    });
 }
 
 }  // end namespace at
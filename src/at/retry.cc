@@ -0,0 +1,145 @@
+/* Copyright 2017 Paolo Galeone <nessuno@nerdz.eu>. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.*/
+
+#include <algorithm>
+#include <at/retry.hpp>
+#include <map>
+#include <memory>
+#include <random>
+
+namespace at {
+
+namespace {
+
+// registry of the breakers: they are never deallocated
+std::mutex registry_mux;
+std::map<std::string, std::unique_ptr<CircuitBreaker>>& registry()
+{
+    static std::map<std::string, std::unique_ptr<CircuitBreaker>> ret;
+    return ret;
+}
+
+}  // namespace
+
+// private methods
+
+bool& RetryPolicy::_running()
+{
+    thread_local bool running = false;
+    return running;
+}
+
+// end private methods
+
+RetryPolicy::RetryPolicy(unsigned attempts, std::chrono::milliseconds base,
+                         std::chrono::milliseconds max)
+    : _attempts(std::max(attempts, 1u)), _base(base), _max(max)
+{
+}
+
+std::chrono::milliseconds RetryPolicy::backoff(unsigned attempt) const
+{
+    thread_local std::mt19937_64 generator(std::random_device{}());
+    auto ceiling = _base;
+    for (unsigned i = 1; i < attempt && ceiling < _max; ++i) {
+        ceiling *= 2;
+    }
+    ceiling = std::min(ceiling, _max);
+    std::uniform_int_distribution<int64_t> wait(0, ceiling.count());
+    return std::chrono::milliseconds(wait(generator));
+}
+
+bool RetryPolicy::retryable(const server_error& error, bool idempotent)
+{
+    if (dynamic_cast<const circuit_open_error*>(&error) != nullptr) {
+        return false;
+    }
+    return idempotent ||
+           dynamic_cast<const connection_error*>(&error) != nullptr;
+}
+
+CircuitBreaker::CircuitBreaker(unsigned threshold,
+                               std::chrono::milliseconds cooldown)
+    : _threshold(std::max(threshold, 1u)), _cooldown(cooldown)
+{
+}
+
+CircuitBreaker* CircuitBreaker::host(const std::string& name)
+{
+    std::lock_guard<std::mutex> lock(registry_mux);
+    auto& breakers = registry();
+    auto found = breakers.find(name);
+    if (found == breakers.end()) {
+        found = breakers.emplace(name, new CircuitBreaker).first;
+    }
+    return found->second.get();
+}
+
+void CircuitBreaker::configure(unsigned threshold,
+                               std::chrono::milliseconds cooldown)
+{
+    std::lock_guard<std::mutex> lock(_mux);
+    _threshold = std::max(threshold, 1u);
+    _cooldown = cooldown;
+}
+
+bool CircuitBreaker::allow()
+{
+    std::lock_guard<std::mutex> lock(_mux);
+    switch (_state) {
+        case state_t::closed:
+            return true;
+        case state_t::open:
+            if (std::chrono::steady_clock::now() - _opened >= _cooldown) {
+                _state = state_t::half_open;
+                _opened = std::chrono::steady_clock::now();
+                return true;
+            }
+            return false;
+        case state_t::half_open:
+            // a trial request is in progress: another one is let through
+            // only if its outcome is not known after a cooldown
+            if (std::chrono::steady_clock::now() - _opened >= _cooldown) {
+                _opened = std::chrono::steady_clock::now();
+                return true;
+            }
+            return false;
+    }
+    return false;
+}
+
+void CircuitBreaker::success()
+{
+    std::lock_guard<std::mutex> lock(_mux);
+    _state = state_t::closed;
+    _failures = 0;
+}
+
+void CircuitBreaker::failure()
+{
+    std::lock_guard<std::mutex> lock(_mux);
+    ++_failures;
+    if (_state == state_t::half_open || _failures >= _threshold) {
+        _state = state_t::open;
+        _opened = std::chrono::steady_clock::now();
+    }
+}
+
+CircuitBreaker::state_t CircuitBreaker::state() const
+{
+    std::lock_guard<std::mutex> lock(_mux);
+    return _state;
+}
+
+}  // namespace at
@@ -16,12 +16,15 @@
 
 namespace at {
 
+void Shapeshift::warmup() { Request::warmup(_host); }
+
 double Shapeshift::rate(currency_pair_t pair)
 {
     Request req;
     std::ostringstream url;
     url << _host;
     url << "rate/";
+    req.endpoint(url.str());
     url << pair;
     json res = req.get(url.str());
     _throw_error_if_any(res);
@@ -34,6 +37,7 @@ min_max_t Shapeshift::depositLimit(currency_pair_t pair)
     std::ostringstream url;
     url << _host;
     url << "limit/";
+    req.endpoint(url.str());
     url << pair;
     json res = req.get(url.str());
     _throw_error_if_any(res);
@@ -75,6 +79,7 @@ exchange_info_t Shapeshift::info(currency_pair_t pair)
     std::ostringstream url;
     url << _host;
     url << "marketinfo/";
+    req.endpoint(url.str());
     url << pair;
     json market = req.get(url.str());
     _throw_error_if_any(market);
@@ -95,6 +100,7 @@ json Shapeshift::recentTransaction(uint32_t max)
     Request req;
     std::ostringstream stream;
     stream << max;
+    req.endpoint(_host + "recenttx/");
     json res = req.get(_host + "recenttx/" + stream.str());
     _throw_error_if_any(res);
     return res;
@@ -103,6 +109,7 @@ json Shapeshift::recentTransaction(uint32_t max)
 deposit_status_t Shapeshift::depositStatus(hash_t address)
 {
     Request req;
+    req.endpoint(_host + "txStat/");
     json res = req.get(_host + "txStat/" + address);
     _throw_error_if_any(res);
     return res.at("status").get<deposit_status_t>();
@@ -111,6 +118,7 @@ std::pair<deposit_status_t, uint32_t> Shapeshift::timeRemeaningForTransaction(
     hash_t address)
 {
     Request req;
+    req.endpoint(_host + "timeremaining/");
     json res = req.get(_host + "timeremaining/" + address);
     _throw_error_if_any(res);
     return std::pair(res["status"].get<deposit_status_t>(),
@@ -132,6 +140,7 @@ std::vector<shapeshift_tx_t> Shapeshift::transactionsList()
             "transactionsList require an affiliate private key");
     }
     Request req;
+    req.endpoint(_host + "txbyapikey/");
     json res = req.get(_host + "txbyapikey/" + _affiliate_private_key);
     _throw_error_if_any(res);
     return res;
@@ -144,6 +153,7 @@ std::vector<shapeshift_tx_t> Shapeshift::transactionsList(hash_t address)
             "transactionList require an affiliate private key");
     }
     Request req;
+    req.endpoint(_host + "txbyaddress/");
     json res = req.get(_host + "txbyaddress/" + address + "/" +
                        _affiliate_private_key);
     _throw_error_if_any(res);
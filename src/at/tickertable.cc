@@ -0,0 +1,259 @@
+/* Copyright 2017 Paolo Galeone <nessuno@nerdz.eu>. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.*/
+
+#include <at/tickertable.hpp>
+#include <numeric>
+
+namespace at {
+
+// private methods
+
+TickerTable::values_t TickerTable::_parse(const json& row)
+{
+    // Same conversions of from_json(const json&, cm_ticker_t&)
+    values_t values;
+    values.rank = std::stoi(row.at("rank").get<std::string>());
+    values.price_usd = std::stod(numeric_string(row.at("price_usd")));
+    values.price_btc = std::stod(numeric_string(row.at("price_btc")));
+    values.day_volume_usd =
+        std::stoull(numeric_string(row.at("24h_volume_usd")));
+    values.market_cap_usd =
+        std::stoull(numeric_string(row.at("market_cap_usd")));
+    values.available_supply =
+        std::stoull(numeric_string(row.at("available_supply")));
+    values.total_supply = std::stoull(numeric_string(row.at("total_supply")));
+    values.percent_change_1h =
+        std::stof(numeric_string(row.at("percent_change_1h")));
+    values.percent_change_24h =
+        std::stof(numeric_string(row.at("percent_change_24h")));
+    values.percent_change_7d =
+        std::stof(numeric_string(row.at("percent_change_7d")));
+    return values;
+}
+
+std::size_t TickerTable::_insert(const std::string& id, const json& row)
+{
+    auto name = row.at("name").get<std::string>();
+    auto symbol = row.at("symbol").get<std::string>();
+    std::size_t idx = _id.size();
+    _row[id] = idx;
+    _id.push_back(id);
+    _name.push_back(std::move(name));
+    _symbol.push_back(std::move(symbol));
+    _rank.push_back(0);
+    _price_usd.push_back(0);
+    _price_btc.push_back(0);
+    _day_volume_usd.push_back(0);
+    _market_cap_usd.push_back(0);
+    _available_supply.push_back(0);
+    _total_supply.push_back(0);
+    _percent_change_1h.push_back(0);
+    _percent_change_24h.push_back(0);
+    _percent_change_7d.push_back(0);
+    _last_updated.push_back(0);
+    _seen.push_back(_epoch);
+    return idx;
+}
+
+void TickerTable::_set(std::size_t idx, const values_t& values)
+{
+    _rank[idx] = values.rank;
+    _price_usd[idx] = values.price_usd;
+    _price_btc[idx] = values.price_btc;
+    _day_volume_usd[idx] = values.day_volume_usd;
+    _market_cap_usd[idx] = values.market_cap_usd;
+    _available_supply[idx] = values.available_supply;
+    _total_supply[idx] = values.total_supply;
+    _percent_change_1h[idx] = values.percent_change_1h;
+    _percent_change_24h[idx] = values.percent_change_24h;
+    _percent_change_7d[idx] = values.percent_change_7d;
+}
+
+void TickerTable::_erase(std::size_t idx)
+{
+    std::size_t last = _id.size() - 1;
+    _row.erase(_id[idx]);
+    if (idx != last) {
+        _row[_id[last]] = idx;
+        _id[idx] = std::move(_id[last]);
+        _name[idx] = std::move(_name[last]);
+        _symbol[idx] = std::move(_symbol[last]);
+        _rank[idx] = _rank[last];
+        _price_usd[idx] = _price_usd[last];
+        _price_btc[idx] = _price_btc[last];
+        _day_volume_usd[idx] = _day_volume_usd[last];
+        _market_cap_usd[idx] = _market_cap_usd[last];
+        _available_supply[idx] = _available_supply[last];
+        _total_supply[idx] = _total_supply[last];
+        _percent_change_1h[idx] = _percent_change_1h[last];
+        _percent_change_24h[idx] = _percent_change_24h[last];
+        _percent_change_7d[idx] = _percent_change_7d[last];
+        _last_updated[idx] = _last_updated[last];
+        _seen[idx] = _seen[last];
+    }
+    _id.pop_back();
+    _name.pop_back();
+    _symbol.pop_back();
+    _rank.pop_back();
+    _price_usd.pop_back();
+    _price_btc.pop_back();
+    _day_volume_usd.pop_back();
+    _market_cap_usd.pop_back();
+    _available_supply.pop_back();
+    _total_supply.pop_back();
+    _percent_change_1h.pop_back();
+    _percent_change_24h.pop_back();
+    _percent_change_7d.pop_back();
+    _last_updated.pop_back();
+    _seen.pop_back();
+}
+
+// end private methods
+
+void TickerTable::reserve(std::size_t n)
+{
+    _row.reserve(n);
+    _id.reserve(n);
+    _name.reserve(n);
+    _symbol.reserve(n);
+    _rank.reserve(n);
+    _price_usd.reserve(n);
+    _price_btc.reserve(n);
+    _day_volume_usd.reserve(n);
+    _market_cap_usd.reserve(n);
+    _available_supply.reserve(n);
+    _total_supply.reserve(n);
+    _percent_change_1h.reserve(n);
+    _percent_change_24h.reserve(n);
+    _percent_change_7d.reserve(n);
+    _last_updated.reserve(n);
+    _seen.reserve(n);
+}
+
+std::size_t TickerTable::find(const std::string& id) const
+{
+    auto it = _row.find(id);
+    if (it == _row.end()) {
+        return npos;
+    }
+    return it->second;
+}
+
+cm_ticker_t TickerTable::at(std::size_t idx) const
+{
+    if (idx >= size()) {
+        throw std::out_of_range("TickerTable: row " + std::to_string(idx) +
+                                " out of range");
+    }
+    return cm_ticker_t{
+        .id = _id[idx],
+        .name = _name[idx],
+        .symbol = _symbol[idx],
+        .rank = _rank[idx],
+        .price_usd = _price_usd[idx],
+        .price_btc = _price_btc[idx],
+        .day_volume_usd = _day_volume_usd[idx],
+        .market_cap_usd = _market_cap_usd[idx],
+        .available_supply = _available_supply[idx],
+        .total_supply = _total_supply[idx],
+        .percent_change_1h = _percent_change_1h[idx],
+        .percent_change_24h = _percent_change_24h[idx],
+        .percent_change_7d = _percent_change_7d[idx],
+        .last_updated = _last_updated[idx],
+    };
+}
+
+void TickerTable::apply(const json& rows, cm_ticker_changes_t& changes,
+                        bool prune)
+{
+    changes.added.clear();
+    changes.updated.clear();
+    changes.removed.clear();
+
+    ++_epoch;
+    if (size() == 0) {
+        reserve(rows.size());
+    }
+
+    for (const auto& row : rows) {
+        const auto& id = row.at("id").get_ref<const std::string&>();
+        std::time_t last_updated =
+            std::stol(numeric_string(row.at("last_updated")));
+
+        std::size_t idx = find(id);
+        if (idx != npos) {
+            _seen[idx] = _epoch;
+            if (_last_updated[idx] == last_updated) {
+                continue;
+            }
+        }
+        // parsed first: a malformed row leaves the table untouched
+        const auto values = _parse(row);
+        if (idx == npos) {
+            idx = _insert(id, row);
+            changes.added.push_back(idx);
+        }
+        else {
+            changes.updated.push_back(idx);
+        }
+        _set(idx, values);
+        _last_updated[idx] = last_updated;
+    }
+
+    if (!prune) {
+        return;
+    }
+
+    // Remove the rows not seen. _erase moves the last row in the
+    // removed position: origin[idx] is the index of the row in idx before
+    // the first removal, and the indices in changes are remapped once
+    std::vector<std::size_t> origin;
+    for (std::size_t idx = 0; idx < size();) {
+        if (_seen[idx] == _epoch) {
+            ++idx;
+            continue;
+        }
+        if (origin.empty()) {
+            origin.resize(size());
+            std::iota(origin.begin(), origin.end(), 0);
+        }
+        changes.removed.push_back(_id[idx]);
+        _erase(idx);
+        origin[idx] = origin.back();
+        origin.pop_back();
+    }
+    if (origin.empty()) {
+        return;
+    }
+    // every row in changes has been seen, thus it is still present
+    std::vector<std::size_t> position(origin.size() + changes.removed.size());
+    for (std::size_t idx = 0; idx < origin.size(); ++idx) {
+        position[origin[idx]] = idx;
+    }
+    for (auto& idx : changes.added) {
+        idx = position[idx];
+    }
+    for (auto& idx : changes.updated) {
+        idx = position[idx];
+    }
+}
+
+cm_ticker_changes_t TickerTable::apply(const json& rows, bool prune)
+{
+    cm_ticker_changes_t changes;
+    apply(rows, changes, prune);
+    return changes;
+}
+
+}  // namespace at
@@ -0,0 +1,428 @@
+/* Copyright 2017 Paolo Galeone <nessuno@nerdz.eu>. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.*/
+
+#include <fcntl.h>
+#include <strings.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <at/transport.hpp>
+#include <cerrno>
+#include <cstring>
+#include <curlpp/Easy.hpp>
+#include <curlpp/Infos.hpp>
+#include <utility>
+
+namespace at {
+
+namespace {
+
+const uint32_t version = 1;
+
+typedef struct {
+    char magic[4];
+    uint32_t version;
+} header_t;
+
+typedef struct {
+    uint32_t method, url, body, response;
+    int32_t status;
+} record_t;
+
+// Removes the parameters in ignored from a query string or a form body
+std::string strip(const std::string& params,
+                  const std::set<std::string>& ignored)
+{
+    std::string ret;
+    std::size_t begin = 0;
+    while (begin <= params.size()) {
+        std::size_t end = params.find('&', begin);
+        if (end == std::string::npos) {
+            end = params.size();
+        }
+        auto param = params.substr(begin, end - begin);
+        if (ignored.find(param.substr(0, param.find('='))) == ignored.end()) {
+            ret += ret.empty() ? param : "&" + param;
+        }
+        begin = end + 1;
+    }
+    return ret;
+}
+
+// storage of the bodies recycled by the thread
+thread_local std::string recycled;
+
+// Value of the Content-Length header line, 0 if line is another header
+std::size_t content_length(const char* line, std::size_t size)
+{
+    static const char name[] = "content-length:";
+    const std::size_t length = sizeof(name) - 1;
+    if (size <= length || strncasecmp(line, name, length) != 0) {
+        return 0;
+    }
+    std::size_t ret = 0;
+    for (std::size_t i = length; i < size; ++i) {
+        if (line[i] >= '0' && line[i] <= '9') {
+            ret = ret * 10 + static_cast<std::size_t>(line[i] - '0');
+        }
+        else if (line[i] != ' ' && line[i] != '\t') {
+            break;
+        }
+    }
+    return ret;
+}
+
+// Host and port of url
+std::string host(const std::string& url)
+{
+    auto scheme = url.find("://");
+    auto begin = scheme == std::string::npos ? 0 : scheme + 3;
+    return url.substr(begin, url.find_first_of("/?", begin) - begin);
+}
+
+// DNS cache and TLS sessions shared by the curl handles of every thread
+class Share {
+private:
+    CURLSH* _share;
+    std::mutex _mux[CURL_LOCK_DATA_LAST];
+
+    static void _lock(CURL*, curl_lock_data data, curl_lock_access, void* ptr)
+    {
+        static_cast<Share*>(ptr)->_mux[data].lock();
+    }
+
+    static void _unlock(CURL*, curl_lock_data data, void* ptr)
+    {
+        static_cast<Share*>(ptr)->_mux[data].unlock();
+    }
+
+public:
+    Share() : _share(curl_share_init())
+    {
+        curl_share_setopt(_share, CURLSHOPT_LOCKFUNC, _lock);
+        curl_share_setopt(_share, CURLSHOPT_UNLOCKFUNC, _unlock);
+        curl_share_setopt(_share, CURLSHOPT_USERDATA, this);
+        curl_share_setopt(_share, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+        curl_share_setopt(_share, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+    }
+
+    ~Share() { curl_share_cleanup(_share); }
+
+    CURLSH* get() const { return _share; }
+};
+
+CURLSH* share()
+{
+    static Share share;
+    return share.get();
+}
+
+}  // namespace
+
+std::string Transport::buffer()
+{
+    std::string ret = std::move(recycled);
+    recycled = std::string();
+    ret.clear();
+    return ret;
+}
+
+void Transport::recycle(std::string&& body)
+{
+    if (body.capacity() > recycled.capacity() &&
+        body.capacity() <= max_recycled) {
+        recycled = std::move(body);
+    }
+}
+
+void CurlTransport::configure(const std::string& host,
+                              http_host_config_t config)
+{
+    std::lock_guard<std::mutex> lock(_mux);
+    _hosts[host] = config;
+}
+
+http_host_config_t CurlTransport::config(const std::string& host) const
+{
+    std::lock_guard<std::mutex> lock(_mux);
+    auto it = _hosts.find(host);
+    return it == _hosts.end() ? _default : it->second;
+}
+
+http_response_t CurlTransport::perform(const http_request_t& request)
+{
+    using namespace curlpp::options;
+
+    // the handle keeps the connections of the thread alive
+    thread_local curlpp::Easy req;
+    req.reset();
+    curl_easy_setopt(req.getHandle(), CURLOPT_SHARE, share());
+    const auto config = this->config(host(request.url));
+    std::string body = buffer();
+    try {
+        req.setOpt(Url(request.url));
+        req.setOpt(FollowLocation(true));
+        // TLS 1.2 or later
+        req.setOpt(SslVersion(CURL_SSLVERSION_TLSv1_2));
+        if (config.compression) {
+            // every encoding supported
+            req.setOpt(Encoding(""));
+        }
+        req.setOpt(HttpVersion(config.version == http_version_t::http2
+                                   ? CURL_HTTP_VERSION_2TLS
+                                   : CURL_HTTP_VERSION_1_1));
+        req.setOpt(DnsCacheTimeout(_dns_ttl.load()));
+        // timeouts without signals, safe in multithreaded programs
+        const auto& timeouts = request.timeouts;
+        req.setOpt(NoSignal(true));
+        if (timeouts.connect.count() > 0) {
+            req.setOpt(ConnectTimeoutMs(timeouts.connect.count()));
+        }
+        if (timeouts.total.count() > 0) {
+            req.setOpt(TimeoutMs(timeouts.total.count()));
+        }
+        if (timeouts.low_speed_limit > 0 &&
+            timeouts.low_speed_time.count() > 0) {
+            req.setOpt(LowSpeedLimit(timeouts.low_speed_limit));
+            req.setOpt(LowSpeedTime(timeouts.low_speed_time.count()));
+        }
+        for (auto opt : request.options) {
+            req.setOpt(*opt);
+        }
+        if (!request.headers.empty()) {
+            req.setOpt(HttpHeader(request.headers));
+        }
+        if (request.method == "POST") {
+            req.setOpt(PostFields(request.body));
+            req.setOpt(PostFieldSize(request.body.length()));
+        }
+        else if (request.method == "HEAD") {
+            req.setOpt(NoBody(true));
+        }
+        req.setOpt(HeaderFunction([&body](char* line, size_t size,
+                                          size_t count) {
+            auto length = content_length(line, size * count);
+            if (length > body.capacity() && length <= max_recycled) {
+                body.reserve(length);
+            }
+            return size * count;
+        }));
+        req.setOpt(WriteFunction([&body](char* data, size_t size,
+                                         size_t count) {
+            body.append(data, size * count);
+            return size * count;
+        }));
+        req.perform();
+    }
+    catch (const curlpp::LibcurlRuntimeError& e) {
+        switch (e.whatCode()) {
+            case CURLE_COULDNT_RESOLVE_PROXY:
+            case CURLE_COULDNT_RESOLVE_HOST:
+            case CURLE_COULDNT_CONNECT:
+            case CURLE_SSL_CONNECT_ERROR:
+                throw connection_error(e.what());
+            default:
+                throw server_error(e.what());
+        }
+    }
+
+    // cumulative times from the start of the transfer, in seconds
+    double lookup = 0, connect = 0, tls = 0, first_byte = 0, total = 0;
+    curl_easy_getinfo(req.getHandle(), CURLINFO_NAMELOOKUP_TIME, &lookup);
+    curl_easy_getinfo(req.getHandle(), CURLINFO_CONNECT_TIME, &connect);
+    curl_easy_getinfo(req.getHandle(), CURLINFO_APPCONNECT_TIME, &tls);
+    curl_easy_getinfo(req.getHandle(), CURLINFO_STARTTRANSFER_TIME,
+                      &first_byte);
+    curl_easy_getinfo(req.getHandle(), CURLINFO_TOTAL_TIME, &total);
+    auto ns = [](double seconds) {
+        return std::chrono::nanoseconds(
+            static_cast<int64_t>(std::max(0., seconds) * 1e9));
+    };
+    double connected = std::max(connect, tls);
+    return http_response_t{
+        .status = curlpp::infos::ResponseCode::get(req),
+        .body = std::move(body),
+        .timing =
+            http_timing_t{
+                .dns = ns(lookup),
+                .connect = ns(connect - lookup),
+                .tls = tls > 0 ? ns(tls - connect) : ns(0),
+                .first_byte = ns(first_byte - connected),
+                .transfer = ns(total - first_byte),
+                .total = ns(total),
+            },
+    };
+}
+
+void CurlTransport::warmup(const http_request_t& request)
+{
+    http_request_t head = request;
+    head.method = "HEAD";
+    head.body.clear();
+    recycle(std::move(perform(head).body));
+}
+
+RecordingTransport::RecordingTransport(std::shared_ptr<Transport> transport,
+                                       const std::string& path)
+    : _transport(transport)
+{
+    bool exists = std::ifstream(path).good();
+    _out.open(path, std::ios::binary | std::ios::app);
+    if (!_out) {
+        throw std::runtime_error("RecordingTransport: unable to open " + path);
+    }
+    if (!exists) {
+        header_t header = {};
+        std::memcpy(header.magic, "ATHT", 4);
+        header.version = version;
+        _out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        _out.flush();
+    }
+}
+
+http_response_t RecordingTransport::perform(const http_request_t& request)
+{
+    auto response = _transport->perform(request);
+
+    record_t record = {
+        .method = static_cast<uint32_t>(request.method.size()),
+        .url = static_cast<uint32_t>(request.url.size()),
+        .body = static_cast<uint32_t>(request.body.size()),
+        .response = static_cast<uint32_t>(response.body.size()),
+        .status = static_cast<int32_t>(response.status),
+    };
+    std::lock_guard<std::mutex> lock(_mux);
+    _out.write(reinterpret_cast<const char*>(&record), sizeof(record));
+    _out << request.method << request.url << request.body << response.body;
+    _out.flush();
+    return response;
+}
+
+// private methods
+
+std::string ReplayTransport::_key(const std::string& method,
+                                  const std::string& url,
+                                  const std::string& body) const
+{
+    std::string key = method + " ";
+    auto question = url.find('?');
+    key += url.substr(0, question);
+    if (question != std::string::npos) {
+        key += "?" + strip(url.substr(question + 1), _ignored);
+    }
+    // the batch methods send a JSON object: its ignored keys are removed
+    auto first = body.find_first_not_of(" \t\r\n");
+    if (first != std::string::npos && body[first] == '{') {
+        auto object = json::parse(body, nullptr, false);
+        if (object.is_object()) {
+            for (const auto& name : _ignored) {
+                object.erase(name);
+            }
+            return key + " " + object.dump();
+        }
+    }
+    return key + " " + strip(body, _ignored);
+}
+
+// end private methods
+
+ReplayTransport::ReplayTransport(const std::string& path,
+                                 std::set<std::string> ignored)
+    : _ignored(ignored)
+{
+    _fd = open(path.c_str(), O_RDONLY);
+    if (_fd < 0) {
+        throw std::runtime_error("ReplayTransport: unable to open " + path +
+                                 ": " + strerror(errno));
+    }
+    struct stat st;
+    if (fstat(_fd, &st) != 0 ||
+        static_cast<std::size_t>(st.st_size) < sizeof(header_t)) {
+        close(_fd);
+        throw std::runtime_error("ReplayTransport: invalid file " + path);
+    }
+    _size = static_cast<std::size_t>(st.st_size);
+    _data = mmap(nullptr, _size, PROT_READ, MAP_SHARED, _fd, 0);
+    if (_data == MAP_FAILED) {
+        close(_fd);
+        throw std::runtime_error("ReplayTransport: unable to mmap " + path +
+                                 ": " + strerror(errno));
+    }
+    auto header = static_cast<const header_t*>(_data);
+    if (std::memcmp(header->magic, "ATHT", 4) != 0 ||
+        header->version != version) {
+        munmap(_data, _size);
+        close(_fd);
+        throw std::runtime_error("ReplayTransport: invalid file " + path);
+    }
+
+    // index: a partially written record is ignored
+    const char* data = static_cast<const char*>(_data);
+    std::size_t offset = sizeof(header_t);
+    while (offset + sizeof(record_t) <= _size) {
+        record_t record;
+        std::memcpy(&record, data + offset, sizeof(record));
+        const char* method = data + offset + sizeof(record);
+        const char* url = method + record.method;
+        const char* body = url + record.url;
+        const char* response = body + record.body;
+        std::size_t end = static_cast<std::size_t>(response - data) +
+                          record.response;
+        if (end > _size) {
+            break;
+        }
+        auto& entry = _index[_key(std::string(method, record.method),
+                                  std::string(url, record.url),
+                                  std::string(body, record.body))];
+        entry.responses.push_back(
+            recorded_t{record.status, response, record.response});
+        offset = end;
+    }
+}
+
+ReplayTransport::~ReplayTransport()
+{
+    munmap(_data, _size);
+    close(_fd);
+}
+
+http_response_t ReplayTransport::perform(const http_request_t& request)
+{
+    auto key = _key(request.method, request.url, request.body);
+    recorded_t recorded;
+    {
+        std::lock_guard<std::mutex> lock(_mux);
+        auto it = _index.find(key);
+        if (it == _index.end()) {
+            throw server_error("ReplayTransport: no response recorded for " +
+                               request.method + " " + request.url);
+        }
+        auto& entry = it->second;
+        recorded = entry.responses[entry.next];
+        if (entry.next + 1 < entry.responses.size()) {
+            ++entry.next;
+        }
+    }
+    auto body = buffer();
+    body.assign(recorded.body, recorded.size);
+    return http_response_t{
+        .status = recorded.status,
+        .body = std::move(body),
+        .timing = {},
+    };
+}
+
+}  // namespace at
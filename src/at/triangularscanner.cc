@@ -0,0 +1,194 @@
+/* Copyright 2017 Paolo Galeone <nessuno@nerdz.eu>. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.*/
+
+#include <algorithm>
+#include <at/triangularscanner.hpp>
+#include <stdexcept>
+
+namespace at {
+
+namespace {
+
+// product[i] = rate[own[i]] * rate[first[i]] * rate[second[i]]. The arrays
+// never overlap: with __restrict the only store is product[i] and the
+// loop is vectorized
+void products(std::size_t n, const uint32_t* __restrict own,
+              const uint32_t* __restrict first,
+              const uint32_t* __restrict second,
+              const double* __restrict rate, double* __restrict product)
+{
+    for (std::size_t i = 0; i < n; ++i) {
+        product[i] = rate[own[i]] * rate[first[i]] * rate[second[i]];
+    }
+}
+
+}  // namespace
+
+TriangularScanner::TriangularScanner(const std::vector<market_info_t>& markets,
+                                     bool maker)
+{
+    std::map<std::string, uint32_t> ids;
+    auto id = [&](const std::string& currency) {
+        auto it = ids.find(currency);
+        if (it != ids.end()) {
+            return it->second;
+        }
+        uint32_t ret = static_cast<uint32_t>(_currencies.size());
+        ids[currency] = ret;
+        _currencies.push_back(currency);
+        return ret;
+    };
+
+    // conversion 2 * pair: base -> quote, 2 * pair + 1: quote -> base
+    std::vector<uint32_t> from, to;
+    for (const auto& market : markets) {
+        auto pair = normalize(market.pair);
+        if (pair.first == pair.second ||
+            _pair_id.find(pair.str()) != _pair_id.end()) {
+            continue;
+        }
+        _pair_id[pair.str()] = static_cast<uint32_t>(_pairs.size());
+        _pair_id[market.pair.str()] = static_cast<uint32_t>(_pairs.size());
+        _pairs.push_back(pair);
+        _fee.push_back((maker ? market.maker_fee : market.taker_fee) / 100);
+        uint32_t base = id(pair.first), quote = id(pair.second);
+        from.push_back(base);
+        to.push_back(quote);
+        from.push_back(quote);
+        to.push_back(base);
+    }
+    _rate.assign(from.size(), 0);
+    _touching.resize(_pairs.size());
+
+    std::vector<std::vector<uint32_t>> out(_currencies.size());
+    for (uint32_t edge = 0; edge < from.size(); ++edge) {
+        out[from[edge]].push_back(edge);
+    }
+
+    // every cycle is found starting from its smallest currency only
+    for (uint32_t a = 0; a < _currencies.size(); ++a) {
+        for (uint32_t ab : out[a]) {
+            uint32_t b = to[ab];
+            if (b < a) {
+                continue;
+            }
+            for (uint32_t bc : out[b]) {
+                uint32_t c = to[bc];
+                if (c <= a || c == b) {
+                    continue;
+                }
+                for (uint32_t ca : out[c]) {
+                    if (to[ca] != a) {
+                        continue;
+                    }
+                    auto cycle = static_cast<uint32_t>(_cycle_rate.size());
+                    uint32_t legs[3] = {ab, bc, ca};
+                    for (std::size_t i = 0; i < 3; ++i) {
+                        _legs[i].push_back(legs[i]);
+                        auto& touching = _touching[legs[i] / 2];
+                        touching.cycle.push_back(cycle);
+                        touching.own.push_back(legs[i]);
+                        touching.first.push_back(legs[(i + 1) % 3]);
+                        touching.second.push_back(legs[(i + 2) % 3]);
+                    }
+                    _cycle_rate.push_back(0);
+                }
+            }
+        }
+    }
+
+    std::size_t most = 0;
+    for (const auto& touching : _touching) {
+        most = std::max(most, touching.cycle.size());
+    }
+    _product.resize(most);
+}
+
+std::vector<std::size_t> TriangularScanner::update(const currency_pair_t& pair,
+                                                   const ticker_t& ticker,
+                                                   double threshold)
+{
+    auto it = _pair_id.find(pair.str());
+    if (it == _pair_id.end()) {
+        it = _pair_id.find(normalize(pair).str());
+    }
+    if (it == _pair_id.end()) {
+        throw std::out_of_range("TriangularScanner: unknown pair " +
+                                pair.str());
+    }
+    uint32_t id = it->second;
+    double keep = 1 - _fee[id];
+    _rate[2 * id] = ticker.bid.price > 0 ? ticker.bid.price * keep : 0;
+    _rate[2 * id + 1] = ticker.ask.price > 0 ? keep / ticker.ask.price : 0;
+
+    const auto& touching = _touching[id];
+    const std::size_t n = touching.cycle.size();
+    products(n, touching.own.data(), touching.first.data(),
+             touching.second.data(), _rate.data(), _product.data());
+    const uint32_t* cycle = touching.cycle.data();
+    const double* product = _product.data();
+    // scatter of the products to their cycles
+    double* cycle_rate = _cycle_rate.data();
+    for (std::size_t i = 0; i < n; ++i) {
+        cycle_rate[cycle[i]] = product[i];
+    }
+
+    std::vector<std::size_t> ret;
+    for (std::size_t i = 0; i < n; ++i) {
+        if (product[i] > threshold) {
+            ret.push_back(cycle[i]);
+        }
+    }
+    return ret;
+}
+
+std::vector<triangular_cycle_t> TriangularScanner::opportunities(
+    double threshold) const
+{
+    std::vector<std::size_t> found;
+    for (std::size_t i = 0; i < _cycle_rate.size(); ++i) {
+        if (_cycle_rate[i] > threshold) {
+            found.push_back(i);
+        }
+    }
+    std::sort(found.begin(), found.end(),
+              [this](std::size_t a, std::size_t b) {
+                  return _cycle_rate[a] > _cycle_rate[b];
+              });
+
+    std::vector<triangular_cycle_t> ret;
+    ret.reserve(found.size());
+    for (std::size_t i : found) {
+        ret.push_back(cycle(i));
+    }
+    return ret;
+}
+
+triangular_cycle_t TriangularScanner::cycle(std::size_t i) const
+{
+    triangular_cycle_t ret;
+    ret.rate = _cycle_rate.at(i);
+    for (std::size_t leg = 0; leg < 3; ++leg) {
+        uint32_t edge = _legs[leg][i];
+        const auto& pair = _pairs[edge / 2];
+        bool sell = edge % 2 == 0;
+        ret.path.push_back(sell ? pair.first : pair.second);
+        ret.pairs.push_back(pair);
+        ret.actions.push_back(sell ? order_action_t::sell
+                                   : order_action_t::buy);
+    }
+    return ret;
+}
+
+}  // namespace at
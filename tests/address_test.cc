@@ -0,0 +1,54 @@
+#include <at/address.hpp>
+#include <gtest/gtest.h>
+
+TEST(Address, ShouldValidateBase58Check)
+{
+    ASSERT_TRUE(
+        at::address::isValid("btc", "1A1zP1eP5QGefi2DMPTfTL5SLmv7DivfNa"));
+    ASSERT_TRUE(
+        at::address::isValid("BTC", "3J98t1WpEZ73CNmQviecrnyiWrnqRhWNLy"));
+    ASSERT_FALSE(
+        at::address::isValid("BTC", "1A1zP1eP5QGefi2DMPTfTL5SLmv7DivfNb"));
+    // valid bitcoin address, wrong version for dogecoin
+    ASSERT_FALSE(
+        at::address::isValid("DOGE", "1A1zP1eP5QGefi2DMPTfTL5SLmv7DivfNa"));
+    // checksum valid, but a 2 bytes version 0x0000 and a payload of 20
+    // bytes: not the 1 byte version 0x00 of bitcoin
+    ASSERT_FALSE(
+        at::address::isValid("BTC", "116L5yRNPTuciSgXGHqYwn9N6NeoGU45ux"));
+    ASSERT_TRUE(
+        at::address::isValid("XRP", "rHb9CJAWyB4rj91VRWn96DkukG4bwdtyTh"));
+}
+
+TEST(Address, ShouldValidateSegwit)
+{
+    ASSERT_TRUE(at::address::isValid(
+        "BTC", "bc1qar0srrr7xfkvy5l643lydnw9re59gtzzwf5mdq"));
+    ASSERT_TRUE(at::address::isValid(
+        "BTC",
+        "bc1p0xlxvlhemja6c4dqv22uapctqupfhlxm9h8z3k2e72q4k9hcz7vqzk5jj0"));
+    ASSERT_FALSE(at::address::isValid(
+        "BTC", "bc1qar0srrr7xfkvy5l643lydnw9re59gtzzwf5mdr"));
+}
+
+TEST(Address, ShouldValidateEIP55AndMonero)
+{
+    ASSERT_TRUE(at::address::isValid(
+        "ETH", "0x5aAeb6053F3E94C9b9A09f33669435E7Ef1BeAed"));
+    ASSERT_FALSE(at::address::isValid(
+        "ETH", "0x5aAeb6053F3E94C9b9A09f33669435E7Ef1BeAeD"));
+    ASSERT_TRUE(at::address::isValid(
+        "XMR",
+        "44AFFq5kSiGBoZ4NMDwYtN18obc8AemS33DBLWs3H7otXft3XjrpDtQGv7SqSsaBYBb98u"
+        "Nbr2VBBEt7f2wfn3RVGQBEP3A"));
+}
+
+TEST(Address, ShouldValidateInBatch)
+{
+    auto valid = at::address::isValid(
+        "BTC", std::vector<at::hash_t>{"1A1zP1eP5QGefi2DMPTfTL5SLmv7DivfNa",
+                                       "not an address"});
+    ASSERT_EQ(std::vector<bool>({true, false}), valid);
+    ASSERT_THROW(at::address::isValid("NOPE", "address"),
+                 std::invalid_argument);
+}
@@ -0,0 +1,119 @@
+#include <at/arbitragedetector.hpp>
+#include <at/papermarket.hpp>
+#include <gtest/gtest.h>
+
+namespace {
+
+class NoExchange : public at::Exchange {
+public:
+    double rate(at::currency_pair_t) override { return 0; }
+    std::vector<at::exchange_info_t> info() override { return {}; }
+    at::exchange_info_t info(at::currency_pair_t) override { return {}; }
+    at::min_max_t depositLimit(at::currency_pair_t) override { return {}; }
+    at::json recentTransaction(uint32_t) override { return {}; }
+    at::deposit_status_t depositStatus(at::hash_t) override
+    {
+        return at::deposit_status_t::no_deposists;
+    }
+    std::pair<at::deposit_status_t, uint32_t> timeRemeaningForTransaction(
+        at::hash_t) override
+    {
+        return {at::deposit_status_t::no_deposists, 0};
+    }
+    std::map<std::string, at::coin_t> coins() override { return {}; }
+};
+
+}  // end namespace
+
+TEST(ArbitrageDetector, ShouldEmitOpportunitiesAfterFees)
+{
+    const at::currency_pair_t pair("XBT", "EUR");
+    at::market_info_t info{.pair = pair,
+                           .limit = {.min = 0, .max = 0},
+                           .maker_fee = 0.16,
+                           .taker_fee = 0.26};
+    at::PaperMarket market({info}, {});
+    NoExchange exchange;
+
+    std::vector<at::arbitrage_t> found;
+    at::ArbitrageDetector detector(
+        market, exchange,
+        [&](const at::arbitrage_t& arbitrage) { found.push_back(arbitrage); },
+        0.01);
+
+    detector.update(info, at::ticker_t{
+                              .bid = {.price = 1000, .amount = 2, .time = 0},
+                              .ask = {.price = 1010, .amount = 1, .time = 0},
+                          });
+    ASSERT_TRUE(found.empty());
+
+    // BTC -> EUR on the market (sell at 1000), EUR -> BTC on the exchange
+    // at a rate 5% better than the market
+    detector.update(at::exchange_info_t{
+        .pair = at::currency_pair_t("EUR", "BTC"),
+        .limit = {.min = 10, .max = 1500},
+        .rate = 1.05 / 1000,
+        .miner_fee = 0.0005,
+    });
+    ASSERT_EQ(found.size(), 1);
+    const auto& arbitrage = found[0];
+    ASSERT_EQ(arbitrage.from, "BTC");
+    ASSERT_EQ(arbitrage.to, "EUR");
+    ASSERT_EQ(arbitrage.market_pair, pair);
+    ASSERT_EQ(arbitrage.action, at::order_action_t::sell);
+    // limited by the deposit limit of the exchange (1500 EUR)
+    double keep = 1 - 0.0026;
+    ASSERT_DOUBLE_EQ(arbitrage.amount, 1500 / (1000 * keep));
+    ASSERT_DOUBLE_EQ(arbitrage.output, 1500 * 1.05 / 1000 - 0.0005);
+
+    // the exchange rate is no more profitable after the market fee
+    detector.update(at::exchange_info_t{
+        .pair = at::currency_pair_t("EUR", "BTC"),
+        .limit = {.min = 10, .max = 1500},
+        .rate = 1.001 / 1000,
+        .miner_fee = 0.0005,
+    });
+    ASSERT_EQ(found.size(), 1);
+    ASSERT_EQ(detector.latency().count, 1);
+}
+
+TEST(ArbitrageDetector, ShouldKeepTheCellsWhenGrowing)
+{
+    auto info = [](const std::string& base) {
+        return at::market_info_t{.pair = at::currency_pair_t(base, "EUR"),
+                                 .limit = {.min = 0, .max = 0},
+                                 .maker_fee = 0,
+                                 .taker_fee = 0};
+    };
+    at::PaperMarket market({info("C0")}, {});
+    NoExchange exchange;
+    std::vector<at::arbitrage_t> found;
+    at::ArbitrageDetector detector(
+        market, exchange,
+        [&](const at::arbitrage_t& arbitrage) { found.push_back(arbitrage); },
+        0.01);
+
+    // EUR -> C0 on the exchange, 5% better than the market
+    detector.update(at::exchange_info_t{
+        .pair = at::currency_pair_t("EUR", "C0"),
+        .limit = {.min = 0, .max = 0},
+        .rate = 1.05 / 10,
+        .miner_fee = 0,
+    });
+    // many more currencies than the initial capacity of the matrix
+    const at::ticker_t ticker = {
+        .bid = {.price = 10, .amount = 1, .time = 0},
+        .ask = {.price = 10, .amount = 1, .time = 0},
+    };
+    for (int i = 1; i <= 100; ++i) {
+        detector.update(info("C" + std::to_string(i)), ticker);
+    }
+    ASSERT_TRUE(found.empty());
+
+    // the exchange rate survived the growth of the matrix
+    detector.update(info("C0"), ticker);
+    ASSERT_EQ(found.size(), 1);
+    ASSERT_EQ(found[0].from, "C0");
+    ASSERT_EQ(found[0].to, "EUR");
+    ASSERT_DOUBLE_EQ(found[0].output, 10 * 1.05 / 10);
+}
@@ -0,0 +1,122 @@
+#include <at/consolidatedbook.hpp>
+#include <at/papermarket.hpp>
+#include <gtest/gtest.h>
+
+TEST(ConsolidatedBook, ShouldRouteToTheBestEffectivePrice)
+{
+    const at::currency_pair_t xbt("XBT", "EUR"), btc("BTC", "EUR");
+    auto venue = [](const at::currency_pair_t& pair, double fee) {
+        return at::PaperMarket({at::market_info_t{.pair = pair,
+                                                  .limit = {.min = 0.1,
+                                                            .max = 0},
+                                                  .maker_fee = fee,
+                                                  .taker_fee = fee}},
+                               {{"EUR", 100000}});
+    };
+    // same prices, different fees
+    auto kraken = venue(xbt, 0.26), other = venue(btc, 1);
+    std::vector<at::ticker_t> book = {
+        at::ticker_t{.bid = {.price = 99, .amount = 1, .time = 0},
+                     .ask = {.price = 100, .amount = 1, .time = 0}},
+        at::ticker_t{.bid = {.price = 98, .amount = 1, .time = 0},
+                     .ask = {.price = 102, .amount = 1, .time = 0}},
+    };
+    kraken.feed(xbt, book);
+    other.feed(btc, book);
+
+    at::ConsolidatedBook consolidated({&kraken, &other});
+    consolidated.update(0, xbt);
+    consolidated.update(1, btc);
+
+    auto asks = consolidated.asks(btc, 4);
+    ASSERT_EQ(asks.size(), 4);
+    ASSERT_EQ(asks[0].venue, 0);
+    ASSERT_DOUBLE_EQ(asks[0].effective, 100 * 1.0026);
+    ASSERT_EQ(asks[1].venue, 1);  // 101 < 102.26
+    ASSERT_EQ(consolidated.bids(xbt)[0].venue, 0);
+
+    at::order_t parent = {};
+    parent.pair = btc;
+    parent.type = at::order_type_t::market;
+    parent.action = at::order_action_t::buy;
+    parent.volume = 2.5;
+    auto children = consolidated.route(parent);
+    ASSERT_EQ(children.size(), 2);
+    ASSERT_EQ(children[0].order.pair, xbt);
+    ASSERT_DOUBLE_EQ(children[0].order.volume, 1.5);
+    ASSERT_DOUBLE_EQ(children[0].order.price, 102);
+    ASSERT_DOUBLE_EQ(children[1].order.volume, 1);
+    ASSERT_DOUBLE_EQ(children[1].order.price, 100);
+
+    for (const auto& error : consolidated.place(children)) {
+        ASSERT_EQ(error, nullptr);
+    }
+    ASSERT_DOUBLE_EQ(kraken.balance("XBT"), 1.5);
+    ASSERT_DOUBLE_EQ(other.balance("BTC"), 1);
+
+    // a new book of a venue replaces only its levels
+    consolidated.update(0, xbt);
+    asks = consolidated.asks(btc, 4);
+    ASSERT_EQ(asks.size(), 3);
+    ASSERT_EQ(asks[0].venue, 1);
+    ASSERT_EQ(asks[1].venue, 0);
+    ASSERT_DOUBLE_EQ(asks[1].price, 102);
+    ASSERT_DOUBLE_EQ(asks[1].amount, 0.5);
+
+    // the outcome of every child, in the same order
+    std::vector<at::child_order_t> failing = {children[0], children[1],
+                                              children[0]};
+    failing[0].order.volume = 0.05;  // below the minimum of the venue
+    failing[1].venue = 2;
+    auto placed = consolidated.place(failing);
+    ASSERT_EQ(placed.size(), 3);
+    EXPECT_THROW(std::rethrow_exception(placed[0]), at::response_error);
+    EXPECT_THROW(std::rethrow_exception(placed[1]), std::out_of_range);
+    EXPECT_EQ(placed[2], nullptr);
+}
+
+TEST(ConsolidatedBook, ShouldRerouteTheSharesBelowTheMinimum)
+{
+    const at::currency_pair_t btc("BTC", "EUR");
+    auto venue = [&btc](double min) {
+        return at::PaperMarket({at::market_info_t{.pair = btc,
+                                                  .limit = {.min = min,
+                                                            .max = 0},
+                                                  .maker_fee = 0,
+                                                  .taker_fee = 0}},
+                               {{"EUR", 100000}});
+    };
+    auto level = [](double bid, double ask, double amount) {
+        return at::ticker_t{.bid = {.price = bid, .amount = amount, .time = 0},
+                            .ask = {.price = ask, .amount = amount, .time = 0}};
+    };
+    // the best levels are on a venue with a minimum of 1 BTC
+    auto small = venue(1), large = venue(0.1);
+    small.feed(btc, {level(99, 100, 0.5)});
+    large.feed(btc, {level(98, 101, 1), level(97, 102, 5)});
+    at::ConsolidatedBook consolidated({&small, &large});
+    consolidated.update(0, btc);
+    consolidated.update(1, btc);
+
+    // 0.5 BTC of the 2 would go to the small venue: they are bought on the
+    // next best level of the large one instead
+    at::order_t parent = {};
+    parent.pair = btc;
+    parent.type = at::order_type_t::market;
+    parent.action = at::order_action_t::buy;
+    parent.volume = 2;
+    auto children = consolidated.route(parent);
+    ASSERT_EQ(children.size(), 1);
+    ASSERT_EQ(children[0].venue, 1);
+    ASSERT_DOUBLE_EQ(children[0].order.volume, 2);
+    ASSERT_DOUBLE_EQ(children[0].order.price, 102);
+
+    // the same on the bids: selling 0.5 BTC at 99 is below the minimum
+    parent.volume = 0.5;
+    parent.action = at::order_action_t::sell;
+    children = consolidated.route(parent);
+    ASSERT_EQ(children.size(), 1);
+    ASSERT_EQ(children[0].venue, 1);
+    ASSERT_DOUBLE_EQ(children[0].order.volume, 0.5);
+    ASSERT_DOUBLE_EQ(children[0].order.price, 98);
+}
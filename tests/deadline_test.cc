@@ -0,0 +1,74 @@
+#include <at/deadline.hpp>
+#include <at/exceptions.hpp>
+#include <at/kraken.hpp>
+#include <at/request.hpp>
+#include <gtest/gtest.h>
+
+#include "mockserver.hpp"
+
+TEST(Deadline, Scope)
+{
+    EXPECT_FALSE(at::Deadline::active());
+    {
+        at::Deadline outer(std::chrono::milliseconds(100));
+        EXPECT_TRUE(at::Deadline::active());
+        {
+            // can't extend the outer deadline
+            at::Deadline inner(std::chrono::seconds(10));
+            EXPECT_LE(at::Deadline::remaining(),
+                      std::chrono::milliseconds(100));
+        }
+        EXPECT_GT(at::Deadline::remaining(), std::chrono::milliseconds(0));
+    }
+    EXPECT_FALSE(at::Deadline::active());
+}
+
+TEST(Deadline, Kraken)
+{
+    at::MockServer server;
+    server.kraken();
+    at::Kraken kraken("key", "c2VjcmV0", server.url());
+    server.latency(std::chrono::milliseconds(300),
+                   std::chrono::milliseconds(300));
+
+    // a slow server
+    auto start = std::chrono::steady_clock::now();
+    {
+        at::Deadline deadline(std::chrono::milliseconds(50));
+        EXPECT_THROW(kraken.time(), at::deadline_exceeded);
+    }
+    EXPECT_LT(std::chrono::steady_clock::now() - start,
+              std::chrono::milliseconds(250));
+
+    // over: nothing is sent
+    auto requests = server.requests();
+    {
+        at::Deadline deadline(std::chrono::steady_clock::now());
+        EXPECT_THROW(kraken.balance(), at::deadline_exceeded);
+    }
+    EXPECT_EQ(server.requests(), requests);
+
+    // no retry past the deadline
+    server.latency(std::chrono::milliseconds(0),
+                   std::chrono::milliseconds(0));
+    server.errors(1, {200, R"({"error":["EService:Busy"]})",
+                      "application/json"});
+    at::RetryPolicyGuard guard;
+    at::Request::retry_policy(at::RetryPolicy(
+        3, std::chrono::seconds(1), std::chrono::seconds(1)));
+    start = std::chrono::steady_clock::now();
+    {
+        at::Deadline deadline(std::chrono::milliseconds(100));
+        try {
+            kraken.time();
+            ADD_FAILURE();
+        }
+        catch (const at::deadline_exceeded&) {
+        }
+        catch (const at::server_error&) {
+            // the random backoff fit in the deadline, the next did not
+        }
+    }
+    EXPECT_LT(std::chrono::steady_clock::now() - start,
+              std::chrono::milliseconds(250));
+}
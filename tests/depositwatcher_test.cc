@@ -0,0 +1,209 @@
+#include <at/depositwatcher.hpp>
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <stdexcept>
+#include <thread>
+
+// MockExchange returns the statuses of the deposits set by the test
+class MockExchange : public at::Exchange {
+public:
+    std::mutex mux;
+    std::map<at::hash_t, at::deposit_status_t> status;
+    std::atomic<int> polls{0};
+    std::atomic<bool> fail{false};
+
+    double rate(at::currency_pair_t) override { return 0; }
+    std::vector<at::exchange_info_t> info() override { return {}; }
+    at::exchange_info_t info(at::currency_pair_t) override { return {}; }
+    at::min_max_t depositLimit(at::currency_pair_t) override { return {}; }
+    at::json recentTransaction(uint32_t) override { return {}; }
+    at::deposit_status_t depositStatus(at::hash_t address) override
+    {
+        ++polls;
+        if (fail) {
+            throw std::runtime_error("depositStatus: unavailable");
+        }
+        std::lock_guard<std::mutex> lock(mux);
+        return status.at(address);
+    }
+    std::pair<at::deposit_status_t, uint32_t> timeRemeaningForTransaction(
+        at::hash_t) override
+    {
+        return {at::deposit_status_t::pending, 600};
+    }
+    std::map<std::string, at::coin_t> coins() override { return {}; }
+};
+
+TEST(DepositWatcher, ShouldNotifyStatusChanges)
+{
+    MockExchange exchange;
+    exchange.status["addr"] = at::deposit_status_t::no_deposists;
+
+    std::mutex mux;
+    std::condition_variable cv;
+    std::vector<at::deposit_event_t> events;
+    at::deposit_watcher_intervals_t intervals;
+    intervals.tick = std::chrono::milliseconds(1);
+    intervals.min = std::chrono::milliseconds(2);
+    intervals.max = std::chrono::milliseconds(5);
+
+    at::DepositWatcher watcher(
+        exchange,
+        [&](const at::deposit_event_t& event) {
+            std::lock_guard<std::mutex> lock(mux);
+            events.push_back(event);
+            cv.notify_all();
+        },
+        2, intervals);
+    watcher.watch("addr");
+    ASSERT_EQ(1, watcher.size());
+
+    {
+        std::lock_guard<std::mutex> lock(exchange.mux);
+        exchange.status["addr"] = at::deposit_status_t::received;
+    }
+    {
+        std::unique_lock<std::mutex> lock(mux);
+        ASSERT_TRUE(cv.wait_for(lock, std::chrono::seconds(5),
+                                [&] { return events.size() == 1; }));
+    }
+    ASSERT_EQ(at::deposit_status_t::no_deposists, events[0].previous);
+    ASSERT_EQ(at::deposit_status_t::received, events[0].current);
+
+    {
+        std::lock_guard<std::mutex> lock(exchange.mux);
+        exchange.status["addr"] = at::deposit_status_t::complete;
+    }
+    {
+        std::unique_lock<std::mutex> lock(mux);
+        ASSERT_TRUE(cv.wait_for(lock, std::chrono::seconds(5),
+                                [&] { return events.size() == 2; }));
+    }
+    ASSERT_EQ(at::deposit_status_t::complete, events[1].current);
+    // complete is a final status: the address is no more watched
+    ASSERT_EQ(0, watcher.size());
+}
+
+TEST(DepositWatcher, ShouldDeliverEventsInOrder)
+{
+    MockExchange exchange;
+    exchange.status["addr"] = at::deposit_status_t::received;
+
+    std::mutex mux;
+    std::condition_variable cv;
+    std::vector<at::deposit_event_t> events;
+    std::atomic<bool> delivering{false}, overlapped{false}, polled{false};
+    at::deposit_watcher_intervals_t intervals;
+    intervals.tick = std::chrono::milliseconds(1);
+    intervals.min = std::chrono::milliseconds(1);
+    intervals.max = std::chrono::milliseconds(2);
+
+    at::DepositWatcher watcher(
+        exchange,
+        [&](const at::deposit_event_t& event) {
+            if (delivering.exchange(true)) {
+                overlapped = true;
+            }
+            const int polls = exchange.polls;
+            {
+                // the status changes while the callback is running
+                std::lock_guard<std::mutex> lock(exchange.mux);
+                exchange.status["addr"] = at::deposit_status_t::complete;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            if (exchange.polls != polls) {
+                polled = true;
+            }
+            delivering = false;
+            std::lock_guard<std::mutex> lock(mux);
+            events.push_back(event);
+            cv.notify_all();
+        },
+        4, intervals);
+    watcher.watch("addr");
+    {
+        std::unique_lock<std::mutex> lock(mux);
+        ASSERT_TRUE(cv.wait_for(lock, std::chrono::seconds(5),
+                                [&] { return events.size() == 2; }));
+    }
+    EXPECT_FALSE(overlapped);
+    EXPECT_FALSE(polled);
+    EXPECT_EQ(at::deposit_status_t::received, events[0].current);
+    EXPECT_EQ(events[0].current, events[1].previous);
+    EXPECT_EQ(at::deposit_status_t::complete, events[1].current);
+}
+
+TEST(DepositWatcher, ShouldNotShortenTheIntervalOnFailures)
+{
+    MockExchange exchange;
+    exchange.status["addr"] = at::deposit_status_t::settled;
+
+    std::mutex mux;
+    std::condition_variable cv;
+    bool settled = false;
+    at::deposit_watcher_intervals_t intervals;
+    intervals.tick = std::chrono::milliseconds(1);
+    intervals.min = std::chrono::milliseconds(1);
+    intervals.max = std::chrono::milliseconds(2);
+    intervals.settled = std::chrono::milliseconds(200);
+
+    at::DepositWatcher watcher(
+        exchange,
+        [&](const at::deposit_event_t&) {
+            exchange.fail = true;
+            std::lock_guard<std::mutex> lock(mux);
+            settled = true;
+            cv.notify_all();
+        },
+        1, intervals);
+    watcher.watch("addr");
+    {
+        std::unique_lock<std::mutex> lock(mux);
+        ASSERT_TRUE(cv.wait_for(lock, std::chrono::seconds(5),
+                                [&] { return settled; }));
+    }
+    // a settled address is polled every 200ms, also when the polls fail
+    // and the backoff is capped at the 2ms of intervals.max
+    std::this_thread::sleep_for(std::chrono::milliseconds(300));
+    EXPECT_LE(exchange.polls, 3);
+}
+
+TEST(DepositWatcher, ShouldKeepPollingWhenTheCallbackThrows)
+{
+    MockExchange exchange;
+    exchange.status["addr"] = at::deposit_status_t::received;
+
+    std::mutex mux;
+    std::condition_variable cv;
+    std::vector<at::deposit_event_t> events;
+    at::deposit_watcher_intervals_t intervals;
+    intervals.tick = std::chrono::milliseconds(1);
+    intervals.min = std::chrono::milliseconds(1);
+    intervals.max = std::chrono::milliseconds(2);
+
+    at::DepositWatcher watcher(
+        exchange,
+        [&](const at::deposit_event_t& event) {
+            {
+                std::lock_guard<std::mutex> lock(mux);
+                events.push_back(event);
+                cv.notify_all();
+            }
+            if (event.current == at::deposit_status_t::received) {
+                std::lock_guard<std::mutex> lock(exchange.mux);
+                exchange.status["addr"] = at::deposit_status_t::complete;
+                throw std::runtime_error("callback failure");
+            }
+        },
+        1, intervals);
+    watcher.watch("addr");
+    {
+        // the worker survives and the address is rescheduled
+        std::unique_lock<std::mutex> lock(mux);
+        ASSERT_TRUE(cv.wait_for(lock, std::chrono::seconds(5),
+                                [&] { return events.size() == 2; }));
+    }
+    EXPECT_EQ(at::deposit_status_t::received, events[0].current);
+    EXPECT_EQ(at::deposit_status_t::complete, events[1].current);
+}
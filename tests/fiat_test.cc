@@ -0,0 +1,171 @@
+#include <at/fiat.hpp>
+#include <gtest/gtest.h>
+
+#include <cmath>
+
+#include "../bench/fixtures.hpp"
+#include "mockserver.hpp"
+
+namespace at {
+
+class FiatTest {
+public:
+    static std::time_t next_publication(std::time_t now)
+    {
+        return Fiat::_next_publication(now);
+    }
+};
+
+}  // namespace at
+
+// Returns the UTC time of the date
+static std::time_t utc(int year, int month, int day, int hour = 0,
+                       int min = 0)
+{
+    std::tm tm{};
+    tm.tm_year = year - 1900;
+    tm.tm_mon = month - 1;
+    tm.tm_mday = day;
+    tm.tm_hour = hour;
+    tm.tm_min = min;
+    return timegm(&tm);
+}
+
+// Serves the recorded eurofxref-daily.xml
+static void serve_fixture(at::MockServer& server)
+{
+    server.route("GET", "/stats/eurofxref/eurofxref-daily.xml",
+                 at::mock_response_t{200, fixture("eurofxref-daily.xml"),
+                                     "text/xml"});
+}
+
+TEST(Fiat, Parse)
+{
+    const auto rates = at::Fiat::parse(fixture("eurofxref-daily.xml"));
+    EXPECT_EQ(rates.date, utc(2018, 10, 19));
+    // 32 published currencies plus EUR
+    EXPECT_EQ(rates.eur_to_currency.size(), 33);
+    EXPECT_DOUBLE_EQ(rates.eur_to_currency.at("EUR"), 1);
+    EXPECT_DOUBLE_EQ(rates.eur_to_currency.at("USD"), 1.1470);
+    EXPECT_DOUBLE_EQ(rates.eur_to_currency.at("JPY"), 129.05);
+
+    EXPECT_THROW(at::Fiat::parse("<gesmes:Envelope></gesmes:Envelope>"),
+                 std::runtime_error);
+}
+
+TEST(Fiat, NextPublication)
+{
+    // 2018-10-19 is a friday, in CEST: 14:15 in Frankfurt is 12:15 UTC
+    EXPECT_EQ(at::FiatTest::next_publication(utc(2018, 10, 19, 10)),
+              utc(2018, 10, 19, 12, 15));
+    EXPECT_EQ(at::FiatTest::next_publication(utc(2018, 10, 18, 14)),
+              utc(2018, 10, 19, 12, 15));
+    // exactly at the publication time the next one is on monday
+    EXPECT_EQ(at::FiatTest::next_publication(utc(2018, 10, 19, 12, 15)),
+              utc(2018, 10, 22, 12, 15));
+    EXPECT_EQ(at::FiatTest::next_publication(utc(2018, 10, 19, 12, 15) - 1),
+              utc(2018, 10, 19, 12, 15));
+    EXPECT_EQ(at::FiatTest::next_publication(utc(2018, 10, 20, 10)),
+              utc(2018, 10, 22, 12, 15));
+    EXPECT_EQ(at::FiatTest::next_publication(utc(2018, 10, 21, 23, 59)),
+              utc(2018, 10, 22, 12, 15));
+    // CET from 2018-10-28: 13:15 UTC
+    EXPECT_EQ(at::FiatTest::next_publication(utc(2018, 10, 26, 12, 15)),
+              utc(2018, 10, 29, 13, 15));
+    EXPECT_EQ(at::FiatTest::next_publication(utc(2018, 12, 3, 13)),
+              utc(2018, 12, 3, 13, 15));
+    // CEST from 2019-03-31
+    EXPECT_EQ(at::FiatTest::next_publication(utc(2019, 3, 29, 13, 15)),
+              utc(2019, 4, 1, 12, 15));
+    // after 12:15 UTC of a winter day the publication of the day is due
+    EXPECT_EQ(at::FiatTest::next_publication(utc(2019, 3, 28, 12, 30)),
+              utc(2019, 3, 28, 13, 15));
+}
+
+TEST(Fiat, Snapshot)
+{
+    at::MockServer server;
+    serve_fixture(server);
+    at::Fiat fiat(server.url());
+
+    auto before = fiat.snapshot();
+    EXPECT_EQ(before->date, utc(2018, 10, 19));
+    fiat.update();
+    auto after = fiat.snapshot();
+    // a refresh publishes a new snapshot and leaves the old one untouched
+    EXPECT_NE(before.get(), after.get());
+    EXPECT_EQ(before->eur_to_currency, after->eur_to_currency);
+    EXPECT_EQ(before->ids, after->ids);
+    EXPECT_EQ(server.requests(), 2);
+
+    EXPECT_DOUBLE_EQ(fiat.rate(at::currency_pair_t("usd", "eur")), 1.1470);
+    EXPECT_DOUBLE_EQ(fiat.rate(at::currency_pair_t("USD", "JPY")),
+                     1.1470 / 129.05);
+    EXPECT_THROW(fiat.rate(at::currency_pair_t("USD", "XXX")),
+                 std::out_of_range);
+    EXPECT_THROW(fiat.rate(at::currency_pair_t("XXX", "EUR")),
+                 std::out_of_range);
+}
+
+TEST(Fiat, CrossRates)
+{
+    at::MockServer server;
+    serve_fixture(server);
+    at::Fiat fiat(server.url());
+    const auto rates = fiat.snapshot();
+    const std::size_t n = rates->currencies.size();
+    ASSERT_EQ(n, 33);
+    ASSERT_EQ(rates->cross.size(), n * n);
+
+    for (const auto& base : rates->currencies) {
+        for (const auto& quote : rates->currencies) {
+            EXPECT_DOUBLE_EQ(fiat.rate(fiat.id(base), fiat.id(quote)),
+                             fiat.rate(at::currency_pair_t(base, quote)))
+                << base << "/" << quote;
+        }
+    }
+    EXPECT_EQ(fiat.id("usd"), fiat.id("USD"));
+    EXPECT_EQ(rates->currencies[fiat.id("JPY")], "JPY");
+    EXPECT_THROW(fiat.id("XXX"), std::out_of_range);
+
+    // every id is checked on its own, not the position in the matrix
+    const auto usd = fiat.id("USD");
+    const auto last = static_cast<at::fiat_id_t>(n - 1);
+    EXPECT_THROW(fiat.rate(usd, static_cast<at::fiat_id_t>(n)),
+                 std::out_of_range);
+    EXPECT_THROW(fiat.rate(static_cast<at::fiat_id_t>(n), usd),
+                 std::out_of_range);
+    EXPECT_NO_THROW(fiat.rate(last, last));
+
+    const std::vector<double> amounts = {1, 100, 2.5};
+    const std::vector<at::fiat_id_t> from = {fiat.id("EUR"), fiat.id("JPY"),
+                                             usd};
+    auto out = fiat.convert(amounts, from, usd);
+    ASSERT_EQ(out.size(), 3);
+    EXPECT_DOUBLE_EQ(out[0], 1.1470);
+    EXPECT_DOUBLE_EQ(out[1], 100 * 1.1470 / 129.05);
+    EXPECT_DOUBLE_EQ(out[2], 2.5);
+
+    EXPECT_THROW(fiat.convert(amounts, from, static_cast<at::fiat_id_t>(n)),
+                 std::out_of_range);
+    EXPECT_THROW(fiat.convert({1}, {static_cast<at::fiat_id_t>(n)}, usd),
+                 std::out_of_range);
+    EXPECT_THROW(fiat.convert({1, 2}, {usd}, usd), std::invalid_argument);
+}
+
+TEST(Fiat, StableIds)
+{
+    const std::string xml = fixture("eurofxref-daily.xml");
+    at::fiat_rates_t previous = at::Fiat::parse(xml);
+    // a currency no more published keeps its id, with NaN rates
+    previous.ids["XXX"] =
+        static_cast<at::fiat_id_t>(previous.currencies.size());
+    previous.currencies.push_back("XXX");
+
+    const auto rates = at::Fiat::parse(xml, &previous);
+    EXPECT_EQ(rates.ids, previous.ids);
+    const std::size_t n = rates.currencies.size();
+    const auto xxx = rates.ids.at("XXX"), usd = rates.ids.at("USD");
+    EXPECT_TRUE(std::isnan(rates.cross[xxx * n + usd]));
+    EXPECT_DOUBLE_EQ(rates.cross[usd * n + rates.ids.at("EUR")], 1.1470);
+}
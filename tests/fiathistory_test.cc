@@ -0,0 +1,158 @@
+#include <at/fiathistory.hpp>
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+
+#include "mockserver.hpp"
+
+// Returns the time of the day at 00:00 UTC plus hours
+static std::time_t day(int year, int month, int mday, int hours = 0)
+{
+    std::tm tm{};
+    tm.tm_year = year - 1900;
+    tm.tm_mon = month - 1;
+    tm.tm_mday = mday;
+    tm.tm_hour = hours;
+    return timegm(&tm);
+}
+
+// ECB history, newest day first. 2018-10-17 and 2018-10-18 are missing
+// like an holiday, GBP is not published on 2018-10-15.
+static const std::string history_xml = R"(<?xml version="1.0" encoding="UTF-8"?>
+<gesmes:Envelope xmlns:gesmes="http://www.gesmes.org/xml/2002-08-01" xmlns="http://www.ecb.int/vocabulary/2002-08-01/eurofxref">
+    <gesmes:subject>Reference rates</gesmes:subject>
+    <Cube>
+        <Cube time="2018-10-22">
+            <Cube currency="USD" rate="1.1500"/>
+            <Cube currency="GBP" rate="0.8800"/>
+        </Cube>
+        <Cube time="2018-10-19">
+            <Cube currency="USD" rate="1.1470"/>
+            <Cube currency="GBP" rate="0.8782"/>
+        </Cube>
+        <Cube time="2018-10-16">
+            <Cube currency="USD" rate="1.1578"/>
+            <Cube currency="GBP" rate="0.8775"/>
+        </Cube>
+        <Cube time="2018-10-15">
+            <Cube currency="usd" rate="1.1585"/>
+        </Cube>
+    </Cube>
+</gesmes:Envelope>)";
+
+TEST(FiatHistory, ShouldRoundtrip)
+{
+    const std::string path = ::testing::TempDir() + "fiathistory_test.bin";
+    std::remove(path.c_str());
+    at::FiatHistory::write(path, history_xml);
+
+    at::FiatHistory history(path);
+    EXPECT_EQ(history.begin(), day(2018, 10, 15));
+    EXPECT_EQ(history.end(), day(2018, 10, 22));
+    EXPECT_EQ(history.currencies(), std::vector<std::string>({"GBP", "USD"}));
+
+    const at::currency_pair_t usd_eur("USD", "EUR"), usd_gbp("USD", "GBP");
+    // on a published day, at any time of the day
+    EXPECT_DOUBLE_EQ(history.rate(usd_eur, day(2018, 10, 15)), 1.1585);
+    EXPECT_DOUBLE_EQ(history.rate(usd_eur, day(2018, 10, 16, 23)), 1.1578);
+    EXPECT_DOUBLE_EQ(history.rate(at::currency_pair_t("eur", "usd"),
+                                  day(2018, 10, 19)),
+                     1 / 1.1470);
+    EXPECT_DOUBLE_EQ(history.rate(usd_gbp, day(2018, 10, 22)),
+                     1.1500 / 0.8800);
+    // between two published days: holidays and weekends use the last one
+    EXPECT_DOUBLE_EQ(history.rate(usd_eur, day(2018, 10, 17)), 1.1578);
+    EXPECT_DOUBLE_EQ(history.rate(usd_gbp, day(2018, 10, 18, 12)),
+                     1.1578 / 0.8775);
+    EXPECT_DOUBLE_EQ(history.rate(usd_eur, day(2018, 10, 20)), 1.1470);
+    EXPECT_DOUBLE_EQ(history.rate(usd_eur, day(2018, 10, 21, 23)), 1.1470);
+    // after the last day
+    EXPECT_DOUBLE_EQ(history.rate(usd_eur, day(2018, 12, 25)), 1.1500);
+
+    // before the first day
+    EXPECT_THROW(history.rate(usd_eur, day(2018, 10, 15) - 1),
+                 std::out_of_range);
+    // not published in that day
+    EXPECT_THROW(history.rate(usd_gbp, day(2018, 10, 15, 12)),
+                 std::out_of_range);
+    // unknown currency
+    EXPECT_THROW(history.rate(at::currency_pair_t("USD", "JPY"),
+                              day(2018, 10, 19)),
+                 std::out_of_range);
+
+    std::remove(path.c_str());
+}
+
+TEST(FiatHistory, ShouldRejectInvalidFiles)
+{
+    const std::string path = ::testing::TempDir() + "fiathistory_test.bin";
+    const std::string invalid =
+        ::testing::TempDir() + "fiathistory_test_invalid.bin";
+    std::remove(path.c_str());
+    at::FiatHistory::write(path, history_xml);
+    std::string content;
+    {
+        std::ifstream in(path, std::ios::binary);
+        content.assign(std::istreambuf_iterator<char>(in),
+                       std::istreambuf_iterator<char>());
+    }
+    auto write = [&](const std::string& data) {
+        std::ofstream out(invalid, std::ios::binary | std::ios::trunc);
+        out.write(data.data(), data.size());
+    };
+
+    EXPECT_THROW(at::FiatHistory{::testing::TempDir() +
+                                  "fiathistory_test_missing.bin"},
+                 std::runtime_error);
+    // truncated rates
+    write(content.substr(0, content.size() - 1));
+    EXPECT_THROW(at::FiatHistory{invalid}, std::runtime_error);
+    // shorter than the header
+    write(content.substr(0, 8));
+    EXPECT_THROW(at::FiatHistory{invalid}, std::runtime_error);
+    // wrong magic
+    write("XXXX" + content.substr(4));
+    EXPECT_THROW(at::FiatHistory{invalid}, std::runtime_error);
+    // sizes in the header that overflow the offsets: 2^30 currencies of
+    // 4 bytes, and 2^32 - 1 days and currencies
+    auto header = [](uint32_t currencies, uint32_t days) {
+        std::string data("ATFX", 4);
+        for (uint32_t field : {uint32_t(1), currencies, days}) {
+            data.append(reinterpret_cast<const char*>(&field), sizeof(field));
+        }
+        return data;
+    };
+    write(header(uint32_t(1) << 30, 0));
+    EXPECT_THROW(at::FiatHistory{invalid}, std::runtime_error);
+    write(header(UINT32_MAX, UINT32_MAX) + std::string(64, '\0'));
+    EXPECT_THROW(at::FiatHistory{invalid}, std::runtime_error);
+    // the original file is still valid
+    EXPECT_NO_THROW(at::FiatHistory{path});
+
+    EXPECT_THROW(at::FiatHistory::write(invalid, "<Envelope></Envelope>"),
+                 std::runtime_error);
+
+    std::remove(path.c_str());
+    std::remove(invalid.c_str());
+}
+
+TEST(FiatHistory, Download)
+{
+    const std::string path = ::testing::TempDir() + "fiathistory_test.bin";
+    std::remove(path.c_str());
+    at::MockServer server;
+    server.ecb();
+    at::FiatHistory::download(path, false, server.url());
+    EXPECT_EQ(server.requests(), 1);
+
+    at::FiatHistory history(path);
+    const auto now = std::time(nullptr);
+    EXPECT_EQ(history.end(), now - now % (24 * 60 * 60));
+    EXPECT_EQ(history.begin(), history.end() - 2 * 24 * 60 * 60);
+    EXPECT_DOUBLE_EQ(history.rate(at::currency_pair_t("USD", "EUR"), now),
+                     1.1470);
+    std::remove(path.c_str());
+}
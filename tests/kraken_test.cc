@@ -0,0 +1,27 @@
+#include <at/kraken.hpp>
+#include <gtest/gtest.h>
+
+#include "../bench/fixtures.hpp"
+
+TEST(Kraken, ParseOrderBook)
+{
+    const auto res = at::json::parse(fixture("kraken_depth.json"));
+    const auto book =
+        at::Kraken::parseOrderBook(res.at("result").at("XXBTZEUR"));
+    ASSERT_EQ(book.size(), 100);
+    EXPECT_DOUBLE_EQ(book[0].ask.price, 6528.1);
+    EXPECT_DOUBLE_EQ(book[0].ask.amount, 3.197);
+    EXPECT_EQ(book[0].ask.time, 1539899898);
+    EXPECT_DOUBLE_EQ(book[0].bid.price, 6527.9);
+    EXPECT_DOUBLE_EQ(book[0].bid.amount, 1.225);
+    EXPECT_EQ(book[0].bid.time, 1539899429);
+    EXPECT_DOUBLE_EQ(book[99].ask.price, 6638.5);
+
+    // the levels beyond the shorter side are dropped
+    const auto asymmetric = at::json::parse(R"({
+        "asks": [["2.0", "1", 1], ["3.0", "1", 1]],
+        "bids": [["1.0", "1", 1]]})");
+    ASSERT_EQ(at::Kraken::parseOrderBook(asymmetric).size(), 1);
+    EXPECT_THROW(at::Kraken::parseOrderBook(at::json::object()),
+                 at::json::out_of_range);
+}
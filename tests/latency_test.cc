@@ -0,0 +1,95 @@
+#include <at/kraken.hpp>
+#include <at/latency.hpp>
+#include <at/shapeshift.hpp>
+#include <gtest/gtest.h>
+
+#include "mockserver.hpp"
+
+TEST(LatencyHistogram, Percentiles)
+{
+    at::LatencyHistogram histogram;
+    for (int64_t us = 1; us <= 1000; ++us) {
+        histogram.record(std::chrono::microseconds(us));
+    }
+    auto summary = histogram.summary();
+    EXPECT_EQ(summary.count, 1000);
+    EXPECT_EQ(summary.min, std::chrono::microseconds(1));
+    EXPECT_EQ(summary.max, std::chrono::microseconds(1000));
+    // relative error <= 1/16
+    EXPECT_NEAR(summary.p50.count(), 500000, 500000 / 16);
+    EXPECT_NEAR(summary.p99.count(), 990000, 990000 / 16);
+    EXPECT_LE(summary.p999, summary.max);
+    EXPECT_EQ(summary.sum, std::chrono::microseconds(500500));
+
+    histogram.reset();
+    EXPECT_EQ(histogram.summary().count, 0);
+
+    // the sum is exact, the mean is truncated
+    histogram.record(std::chrono::nanoseconds(1));
+    histogram.record(std::chrono::nanoseconds(2));
+    summary = histogram.summary();
+    EXPECT_EQ(summary.sum, std::chrono::nanoseconds(3));
+    EXPECT_EQ(summary.mean, std::chrono::nanoseconds(1));
+}
+
+TEST(Latency, Endpoints)
+{
+    at::MockServer server;
+    server.kraken();
+    at::Kraken kraken("key", "c2VjcmV0", server.url());
+    at::Latency::reset();
+    for (int i = 0; i < 10; ++i) {
+        kraken.ticker(at::currency_pair_t("BTC", "EUR"));
+    }
+    kraken.balance();
+
+    const std::string ticker =
+        "GET 127.0.0.1:" + std::to_string(server.port()) + "/0/public/Ticker";
+    auto total = at::Latency::summary(ticker, at::latency_phase_t::total);
+    EXPECT_EQ(total.count, 10);
+    auto parse = at::Latency::summary(ticker, at::latency_phase_t::parse);
+    EXPECT_EQ(parse.count, 10);
+    EXPECT_LE(parse.mean, total.mean);
+    EXPECT_EQ(at::Latency::summary(ticker, at::latency_phase_t::convert).count,
+              10);
+    EXPECT_EQ(
+        at::Latency::summary(ticker, at::latency_phase_t::first_byte).count,
+        10);
+    EXPECT_EQ(at::Latency::summary(ticker, at::latency_phase_t::tls).count,
+              0);
+    EXPECT_EQ(at::Latency::summary("POST 127.0.0.1:" +
+                                       std::to_string(server.port()) +
+                                       "/0/private/Balance",
+                                   at::latency_phase_t::total)
+                  .count,
+              1);
+    EXPECT_THROW(at::Latency::summary("GET nowhere", at::latency_phase_t::dns),
+                 std::out_of_range);
+}
+
+TEST(Latency, PathParameters)
+{
+    at::MockServer server;
+    server.shapeshift();
+    at::Shapeshift shapeshift("", server.url());
+    at::Latency::reset();
+    for (auto address : {"addr1", "addr2", "addr3"}) {
+        shapeshift.depositStatus(address);
+    }
+    shapeshift.rate(at::currency_pair_t("BTC", "ETH"));
+    shapeshift.rate(at::currency_pair_t("ETH", "LTC"));
+
+    // the addresses and the pairs are not endpoints
+    const std::string host = "GET 127.0.0.1:" + std::to_string(server.port());
+    EXPECT_EQ(at::Latency::summary(host + "/txStat/",
+                                   at::latency_phase_t::total)
+                  .count,
+              3);
+    EXPECT_EQ(
+        at::Latency::summary(host + "/rate/", at::latency_phase_t::total)
+            .count,
+        2);
+    EXPECT_THROW(at::Latency::summary(host + "/txStat/addr1",
+                                      at::latency_phase_t::total),
+                 std::out_of_range);
+}
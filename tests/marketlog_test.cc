@@ -0,0 +1,96 @@
+#include <at/marketlog.hpp>
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <fstream>
+
+TEST(MarketLog, ShouldRoundtripAndSeek)
+{
+    const std::string path = ::testing::TempDir() + "marketlog_test.bin";
+    std::remove(path.c_str());
+    const at::currency_pair_t btc("BTC", "EUR"), eth("ETH", "EUR");
+
+    {
+        // small blocks, to test the sync records and the seek
+        at::MarketRecorder recorder(path, 0.01, 8);
+        for (std::time_t t = 100; t < 110; ++t) {
+            at::ticker_t ticker = {
+                .bid = {.price = 8000.5 + t, .amount = 1.5, .time = t},
+                .ask = {.price = 8001.25 + t, .amount = 0.25, .time = t},
+            };
+            recorder.ticker(btc, ticker);
+        }
+        std::vector<at::ticker_t> book = {at::ticker_t{
+            .bid = {.price = 700, .amount = 3, .time = 0},
+            .ask = {.price = 701, .amount = 4, .time = 0},
+        }};
+        recorder.orderBook(eth, book, 110);
+    }
+    {
+        // append to the existing log
+        at::MarketRecorder recorder(path);
+        recorder.trade(
+            btc, at::order_action_t::sell,
+            at::quotation_t{.price = 8100, .amount = 2, .time = 120});
+    }
+
+    at::MarketLog log(path);
+    at::market_event_t event;
+    std::vector<at::market_event_t> events;
+    while (log.next(event)) {
+        events.push_back(event);
+    }
+    ASSERT_EQ(events.size(), 20 + 3 + 1);
+    ASSERT_EQ(events[0].type, at::market_event_type_t::bid);
+    ASSERT_EQ(log.pair(events[0].pair), btc);
+    ASSERT_EQ(events[19].type, at::market_event_type_t::ask);
+    ASSERT_DOUBLE_EQ(events[19].price, 8001.25 + 109);
+    ASSERT_EQ(events[19].time, 109);
+    ASSERT_EQ(events[20].type, at::market_event_type_t::book);
+    ASSERT_EQ(log.pair(events[20].pair), eth);
+    ASSERT_DOUBLE_EQ(events[21].price, 700);
+    ASSERT_DOUBLE_EQ(events[22].amount, 4);
+    ASSERT_EQ(events.back().type, at::market_event_type_t::sell);
+    ASSERT_DOUBLE_EQ(events.back().price, 8100);
+    ASSERT_EQ(events.back().time, 120);
+
+    log.seek(105);
+    ASSERT_TRUE(log.next(event));
+    ASSERT_EQ(event.time, 105);
+    ASSERT_EQ(event.type, at::market_event_type_t::bid);
+    ASSERT_DOUBLE_EQ(event.price, 8000.5 + 105);
+
+    log.seek(115);
+    ASSERT_TRUE(log.next(event));
+    ASSERT_EQ(event.time, 120);
+    ASSERT_FALSE(log.next(event));
+    std::remove(path.c_str());
+}
+
+TEST(MarketLog, ShouldStorePricesInTicks)
+{
+    const std::string path = ::testing::TempDir() + "marketlog_test.bin";
+    std::remove(path.c_str());
+    const at::currency_pair_t btc("BTC", "EUR");
+    {
+        at::MarketRecorder recorder(path, 0.01, 8);
+        recorder.trade(
+            btc, at::order_action_t::buy,
+            at::quotation_t{.price = 8000.5, .amount = 1, .time = 1});
+        recorder.trade(
+            btc, at::order_action_t::buy,
+            at::quotation_t{.price = 7999, .amount = 1, .time = 2});
+    }
+
+    // header, sync, pair definition, 2 trades
+    std::ifstream in(path, std::ios::binary);
+    at::market_log_header_t header;
+    ASSERT_TRUE(in.read(reinterpret_cast<char*>(&header), sizeof(header)));
+    std::vector<at::market_log_record_t> records(4);
+    ASSERT_TRUE(in.read(reinterpret_cast<char*>(records.data()),
+                        records.size() * sizeof(at::market_log_record_t)));
+    ASSERT_EQ(records[2].price, 800050);
+    ASSERT_EQ(records[3].price, 799900);
+    ASSERT_EQ(records[3].time, 1);
+    std::remove(path.c_str());
+}
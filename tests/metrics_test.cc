@@ -0,0 +1,105 @@
+#include <at/exceptions.hpp>
+#include <at/kraken.hpp>
+#include <at/metrics.hpp>
+#include <at/request.hpp>
+#include <gtest/gtest.h>
+#include <memory>
+
+#include "mockserver.hpp"
+
+TEST(Metrics, Kraken)
+{
+    at::MockServer server;
+    server.kraken();
+    at::Kraken kraken("key", "c2VjcmV0", server.url());
+    const std::string host = "127.0.0.1:" + std::to_string(server.port());
+    at::Metrics::reset();
+    at::RetryPolicyGuard guard;
+    at::Request::retry_policy(at::RetryPolicy::none());
+
+    kraken.ticker(at::currency_pair_t("BTC", "EUR"));
+    kraken.balance();
+    server.errors(1);
+    EXPECT_THROW(kraken.time(), at::server_error);
+    server.errors(1, {200, R"({"error":["EService:Busy"]})",
+                      "application/json"});
+    EXPECT_THROW(kraken.time(), at::server_error);
+    server.errors(1, {200, R"({"error":["EQuery:Unknown asset pair"]})",
+                      "application/json"});
+    EXPECT_THROW(kraken.time(), at::response_error);
+
+    EXPECT_EQ(at::Metrics::value(host, at::metric_t::requests), 5);
+    EXPECT_EQ(at::Metrics::value(host, at::metric_t::server_errors), 2);
+    EXPECT_EQ(at::Metrics::value(host, at::metric_t::response_errors), 1);
+    EXPECT_EQ(at::Metrics::value(host, at::metric_t::in_flight), 0);
+    EXPECT_GT(at::Metrics::value(host, at::metric_t::bytes_in), 0);
+    EXPECT_GT(at::Metrics::value(host, at::metric_t::bytes_out), 0);
+    EXPECT_THROW(at::Metrics::value("nowhere", at::metric_t::requests),
+                 std::out_of_range);
+
+    std::ostringstream stream;
+    at::Metrics::exposition(stream);
+    auto text = stream.str();
+    EXPECT_NE(text.find("# TYPE openat_requests_total counter\n"),
+              std::string::npos);
+    EXPECT_NE(text.find("openat_requests_total{host=\"" + host + "\"} 5\n"),
+              std::string::npos);
+    EXPECT_NE(text.find("openat_errors_total{host=\"" + host +
+                        "\",type=\"response_error\"} 1\n"),
+              std::string::npos);
+    EXPECT_NE(text.find("openat_request_duration_seconds_count{endpoint=\""
+                        "GET " +
+                        host + "/0/public/Ticker\"}"),
+              std::string::npos);
+}
+
+TEST(Metrics, RateLimitWaits)
+{
+    at::MockServer server;
+    server.kraken();
+    at::Kraken kraken("key", "c2VjcmV0", server.url());
+    const std::string host = "127.0.0.1:" + std::to_string(server.port());
+    at::Metrics::reset();
+    at::RetryPolicyGuard guard;
+    at::Request::retry_policy(at::RetryPolicy(
+        3, std::chrono::milliseconds(1), std::chrono::milliseconds(1)));
+
+    // the first call of Time answers with error, the retry with the time
+    auto fail_once = [&](at::mock_response_t error) {
+        auto failed = std::make_shared<bool>(false);
+        server.route("GET", "/0/public/Time",
+                     [=](const at::mock_request_t&) {
+                         if (*failed) {
+                             return at::mock_response_t{
+                                 200,
+                                 R"({"error":[],"result":{"unixtime":1}})",
+                                 "application/json"};
+                         }
+                         *failed = true;
+                         return error;
+                     });
+    };
+    fail_once({429, "Too Many Requests", "text/plain"});
+    EXPECT_NO_THROW(kraken.time());
+    fail_once({200, R"({"error":["EAPI:Rate limit exceeded"]})",
+               "application/json"});
+    EXPECT_NO_THROW(kraken.time());
+    // a server error is retried, but it is not a rate limit
+    fail_once({503, "Service Unavailable", "text/plain"});
+    EXPECT_NO_THROW(kraken.time());
+
+    EXPECT_EQ(at::Metrics::value(host, at::metric_t::retries), 3);
+    EXPECT_EQ(at::Metrics::value(host, at::metric_t::rate_limit_waits), 2);
+}
+
+TEST(MetricsServer, Exposition)
+{
+    at::MetricsServer server;
+    const std::string url =
+        "http://127.0.0.1:" + std::to_string(server.port()) + "/";
+    at::Request req;
+    auto text = req.getHTML(url + "metrics");
+    EXPECT_NE(text.find("# TYPE openat_requests_in_flight gauge"),
+              std::string::npos);
+    EXPECT_THROW(req.getHTML(url), at::server_error);
+}
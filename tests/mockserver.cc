@@ -0,0 +1,754 @@
+/* Copyright 2017 Paolo Galeone <nessuno@nerdz.eu>. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.*/
+
+#include "mockserver.hpp"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cstring>
+#include <ctime>
+#include <iomanip>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+
+namespace at {
+
+namespace {
+
+std::string reason(int status)
+{
+    switch (status) {
+        case 200:
+            return "OK";
+        case 400:
+            return "Bad Request";
+        case 404:
+            return "Not Found";
+        case 429:
+            return "Too Many Requests";
+        case 500:
+            return "Internal Server Error";
+        case 502:
+            return "Bad Gateway";
+        case 503:
+            return "Service Unavailable";
+        case 504:
+            return "Gateway Timeout";
+        default:
+            return "Unknown";
+    }
+}
+
+bool send_all(int fd, const std::string& data)
+{
+    std::size_t sent = 0;
+    while (sent < data.size()) {
+        ssize_t n =
+            ::send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+        if (n <= 0) {
+            if (n < 0 && errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        sent += static_cast<std::size_t>(n);
+    }
+    return true;
+}
+
+// Parses a Content-Length value: decimal digits only, without overflow
+bool parse_length(const std::string& value, std::size_t& length)
+{
+    if (value.empty()) {
+        return false;
+    }
+    length = 0;
+    for (char c : value) {
+        if (!std::isdigit(static_cast<unsigned char>(c))) {
+            return false;
+        }
+        std::size_t digit = static_cast<std::size_t>(c - '0');
+        if (length > (std::numeric_limits<std::size_t>::max() - digit) / 10) {
+            return false;
+        }
+        length = length * 10 + digit;
+    }
+    return true;
+}
+
+// Value of name in a query string or in a form encoded body
+std::string param(const std::string& query, const std::string& name)
+{
+    std::istringstream stream(query);
+    std::string pair;
+    while (std::getline(stream, pair, '&')) {
+        auto equal = pair.find('=');
+        if (pair.substr(0, equal) == name) {
+            return equal == std::string::npos ? "" : pair.substr(equal + 1);
+        }
+    }
+    return "";
+}
+
+mock_response_t ok(const json& body)
+{
+    return {200, body.dump(), "application/json"};
+}
+
+// Prices of the mocked markets, in EUR
+double price(std::string symbol)
+{
+    static const std::map<std::string, double> prices = {
+        {"XBT", 6500},  {"BTC", 6500}, {"ETH", 180}, {"LTC", 45},
+        {"XMR", 95},    {"ZEC", 110},  {"DASH", 140}, {"BCH", 390},
+        {"XRP", 0.4},   {"DOGE", 0.004}, {"EUR", 1},  {"USD", 0.87}};
+    symbol = normalize_symbol(symbol);
+    auto it = prices.find(symbol == "BTC" ? "XBT" : symbol);
+    return it != prices.end() ? it->second : 1;
+}
+
+// Splits a Kraken pair (XBTEUR, DASHEUR, XXBTZEUR) in base and quote
+std::pair<std::string, std::string> split_kraken(std::string pair)
+{
+    toupper(pair);
+    bool long_base =
+        pair.size() == 8 || (pair.size() == 7 && pair[0] != 'X');
+    std::size_t base = long_base ? 4 : 3;
+    return {pair.substr(0, base), pair.substr(base)};
+}
+
+// Kraken asset code of symbol: XXBT, ZEUR, DASH
+std::string kraken_asset(const std::string& symbol)
+{
+    if (symbol.size() != 3) {
+        return symbol;
+    }
+    bool fiat = symbol == "EUR" || symbol == "USD" || symbol == "GBP" ||
+                symbol == "JPY" || symbol == "CAD";
+    return (fiat ? "Z" : "X") + symbol;
+}
+
+std::string fixed(double value, int precision)
+{
+    std::ostringstream stream;
+    stream << std::fixed << std::setprecision(precision) << value;
+    return stream.str();
+}
+
+}  // namespace
+
+// private methods
+
+void MockServer::_accept_loop()
+{
+    while (!_stop) {
+        int fd = ::accept(_fd, nullptr, nullptr);
+        if (fd < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) {
+                continue;
+            }
+            break;
+        }
+        int one = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+        std::lock_guard<std::mutex> lock(_mux);
+        // join the finished connections
+        for (auto it = _connections.begin(); it != _connections.end();) {
+            if ((*it)->done) {
+                (*it)->thread.join();
+                ::close((*it)->fd);
+                it = _connections.erase(it);
+            }
+            else {
+                ++it;
+            }
+        }
+        if (_stop) {
+            ::close(fd);
+            break;
+        }
+        auto connection = std::make_unique<connection_t>();
+        connection->fd = fd;
+        connection->done = false;
+        connection_t* ptr = connection.get();
+        connection->thread = std::thread(&MockServer::_serve, this, ptr);
+        _connections.push_back(std::move(connection));
+    }
+}
+
+void MockServer::_serve(connection_t* connection)
+{
+    const int fd = connection->fd;
+    std::string buffer;
+    char chunk[16384];
+    bool keep_alive = true;
+    while (keep_alive && !_stop) {
+        // headers
+        std::size_t end;
+        while ((end = buffer.find("\r\n\r\n")) == std::string::npos) {
+            ssize_t n = ::recv(fd, chunk, sizeof(chunk), 0);
+            if (n <= 0) {
+                keep_alive = false;
+                break;
+            }
+            buffer.append(chunk, static_cast<std::size_t>(n));
+        }
+        if (!keep_alive) {
+            break;
+        }
+
+        mock_request_t request;
+        std::istringstream head(buffer.substr(0, end));
+        buffer.erase(0, end + 4);
+        std::string line, target, version;
+        std::getline(head, line);
+        std::istringstream(line) >> request.method >> target >> version;
+        auto question = target.find('?');
+        request.path = target.substr(0, question);
+        if (question != std::string::npos) {
+            request.query = target.substr(question + 1);
+        }
+        while (std::getline(head, line)) {
+            if (!line.empty() && line.back() == '\r') {
+                line.pop_back();
+            }
+            auto colon = line.find(':');
+            if (colon == std::string::npos) {
+                continue;
+            }
+            std::string name = line.substr(0, colon);
+            tolower(name);
+            auto value = line.substr(colon + 1);
+            value.erase(0, value.find_first_not_of(' '));
+            request.headers[name] = value;
+        }
+        keep_alive = version == "HTTP/1.1";
+        auto connection_header = request.headers.find("connection");
+        if (connection_header != request.headers.end()) {
+            std::string value = connection_header->second;
+            tolower(value);
+            keep_alive = value != "close";
+        }
+
+        // body
+        std::size_t length = 0;
+        auto content_length = request.headers.find("content-length");
+        if (content_length != request.headers.end() &&
+            !parse_length(content_length->second, length)) {
+            // the end of the body is unknown: answer and close
+            ++_requests;
+            send_all(fd,
+                     "HTTP/1.1 400 Bad Request\r\nContent-Type: text/plain"
+                     "\r\nContent-Length: 11\r\nConnection: close\r\n\r\n"
+                     "Bad Request");
+            break;
+        }
+        auto expect = request.headers.find("expect");
+        if (expect != request.headers.end() && length > buffer.size() &&
+            !send_all(fd, "HTTP/1.1 100 Continue\r\n\r\n")) {
+            break;
+        }
+        while (buffer.size() < length) {
+            ssize_t n = ::recv(fd, chunk, sizeof(chunk), 0);
+            if (n <= 0) {
+                keep_alive = false;
+                break;
+            }
+            buffer.append(chunk, static_cast<std::size_t>(n));
+        }
+        if (buffer.size() < length) {
+            break;
+        }
+        request.body = buffer.substr(0, length);
+        buffer.erase(0, length);
+
+        auto response = _respond(request);
+        ++_requests;
+        std::ostringstream out;
+        out << "HTTP/1.1 " << response.status << " " << reason(response.status)
+            << "\r\nContent-Type: " << response.content_type
+            << "\r\nContent-Length: " << response.body.size()
+            << "\r\nConnection: " << (keep_alive ? "keep-alive" : "close")
+            << "\r\n\r\n";
+        // the response to a HEAD has the headers of the response to a GET
+        if (request.method != "HEAD") {
+            out << response.body;
+        }
+        if (!send_all(fd, out.str())) {
+            break;
+        }
+    }
+    ::shutdown(fd, SHUT_RDWR);
+    connection->done = true;
+}
+
+mock_response_t MockServer::_respond(const mock_request_t& request)
+{
+    handler_t handler;
+    std::chrono::microseconds delay{0};
+    bool error = false;
+    mock_response_t error_response;
+    {
+        std::lock_guard<std::mutex> lock(_mux);
+        // longest prefix of the path among the routes of the method, a
+        // HEAD is routed as a GET
+        const std::string method =
+            request.method == "HEAD" ? "GET" : request.method;
+        std::string key = method + " " + request.path;
+        auto it = _routes.upper_bound(key);
+        while (it != _routes.begin()) {
+            --it;
+            if (key.compare(0, it->first.size(), it->first) == 0) {
+                handler = it->second;
+                break;
+            }
+            if (it->first.compare(0, method.size() + 1, method + " ") != 0) {
+                break;
+            }
+        }
+        if (_latency_max > _latency_min) {
+            std::uniform_int_distribution<int64_t> uniform(
+                _latency_min.count(), _latency_max.count());
+            delay = std::chrono::microseconds(uniform(_random));
+        }
+        else {
+            delay = _latency_min;
+        }
+        if (_error_probability > 0) {
+            error = std::uniform_real_distribution<double>(0, 1)(_random) <
+                    _error_probability;
+            error_response = _error;
+        }
+    }
+
+    if (delay.count() > 0) {
+        std::this_thread::sleep_for(delay);
+    }
+    if (error) {
+        return error_response;
+    }
+    if (!handler) {
+        return {404, "Not Found", "text/plain"};
+    }
+    try {
+        return handler(request);
+    }
+    catch (const std::exception& e) {
+        return {500, e.what(), "text/plain"};
+    }
+}
+
+// end private methods
+
+MockServer::MockServer(uint16_t port)
+{
+    _fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    if (_fd < 0) {
+        throw std::runtime_error(std::string("socket: ") + strerror(errno));
+    }
+    int one = 1;
+    setsockopt(_fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port = htons(port);
+    socklen_t size = sizeof(address);
+    if (::bind(_fd, reinterpret_cast<sockaddr*>(&address), size) != 0 ||
+        ::listen(_fd, SOMAXCONN) != 0 ||
+        ::getsockname(_fd, reinterpret_cast<sockaddr*>(&address), &size) !=
+            0) {
+        std::string message = strerror(errno);
+        ::close(_fd);
+        throw std::runtime_error("MockServer: " + message);
+    }
+    _port = ntohs(address.sin_port);
+    _acceptor = std::thread(&MockServer::_accept_loop, this);
+}
+
+MockServer::~MockServer()
+{
+    _stop = true;
+    ::shutdown(_fd, SHUT_RDWR);
+    _acceptor.join();
+    ::close(_fd);
+
+    // joined without _mux: a connection thread may be waiting for it in
+    // _respond
+    std::list<std::unique_ptr<connection_t>> connections;
+    {
+        std::lock_guard<std::mutex> lock(_mux);
+        connections.swap(_connections);
+    }
+    for (auto& connection : connections) {
+        ::shutdown(connection->fd, SHUT_RDWR);
+        connection->thread.join();
+        ::close(connection->fd);
+    }
+}
+
+std::string MockServer::url() const
+{
+    return "http://127.0.0.1:" + std::to_string(_port) + "/";
+}
+
+void MockServer::route(const std::string& method, const std::string& prefix,
+                       handler_t handler)
+{
+    std::lock_guard<std::mutex> lock(_mux);
+    _routes[method + " " + prefix] = handler;
+}
+
+void MockServer::route(const std::string& method, const std::string& prefix,
+                       const mock_response_t& response)
+{
+    route(method, prefix, [response](const mock_request_t&) {
+        return response;
+    });
+}
+
+void MockServer::latency(std::chrono::microseconds min,
+                         std::chrono::microseconds max)
+{
+    std::lock_guard<std::mutex> lock(_mux);
+    _latency_min = min;
+    _latency_max = std::max(min, max);
+}
+
+void MockServer::errors(double probability, mock_response_t error)
+{
+    std::lock_guard<std::mutex> lock(_mux);
+    _error_probability = probability;
+    _error = error;
+}
+
+void MockServer::kraken(const std::string& prefix)
+{
+    const std::string api = prefix + "0/";
+    route("GET", api + "public/Time", [](const mock_request_t&) {
+        return ok({{"error", json::array()},
+                   {"result", {{"unixtime", std::time(nullptr)}}}});
+    });
+    route("GET", api + "public/Assets", [](const mock_request_t&) {
+        json result;
+        for (auto symbol : {"XXBT", "XETH", "XLTC", "XXMR", "ZEUR", "ZUSD"}) {
+            result[symbol] = {{"aclass", "currency"},
+                              {"altname", std::string(symbol).substr(1)},
+                              {"decimals", 10},
+                              {"display_decimals", 5}};
+        }
+        return ok({{"error", json::array()}, {"result", result}});
+    });
+    route("GET", api + "public/AssetPairs", [](const mock_request_t& request) {
+        auto market = [](const std::string& base, const std::string& quote) {
+            return json{{"altname", base.substr(1) + quote.substr(1)},
+                        {"base", base},
+                        {"quote", quote},
+                        {"fees", {{0, 0.26}, {50000, 0.24}}},
+                        {"fees_maker", {{0, 0.16}, {50000, 0.14}}}};
+        };
+        json result;
+        for (auto base : {"XXBT", "XETH", "XLTC", "XXMR"}) {
+            for (auto quote : {"ZEUR", "ZUSD"}) {
+                result[std::string(base) + quote] = market(base, quote);
+            }
+        }
+        auto pair = param(request.query, "pair");
+        if (!pair.empty()) {
+            auto split = split_kraken(pair);
+            result = {{pair, market(kraken_asset(split.first),
+                                    kraken_asset(split.second))}};
+        }
+        return ok({{"error", json::array()}, {"result", result}});
+    });
+    route("GET", api + "public/Ticker", [](const mock_request_t& request) {
+        auto pair = param(request.query, "pair");
+        auto split = split_kraken(pair);
+        double mid = price(split.first) / price(split.second);
+        json ticker = {{"a", {fixed(mid * 1.0005, 5), "1", "1.000"}},
+                       {"b", {fixed(mid * 0.9995, 5), "2", "2.000"}},
+                       {"c", {fixed(mid, 5), "0.10000000"}},
+                       {"v", {"1000.00000000", "2000.00000000"}},
+                       {"p", {fixed(mid, 5), fixed(mid, 5)}},
+                       {"t", {1000, 2000}},
+                       {"l", {fixed(mid * 0.98, 5), fixed(mid * 0.97, 5)}},
+                       {"h", {fixed(mid * 1.02, 5), fixed(mid * 1.03, 5)}},
+                       {"o", fixed(mid, 5)}};
+        return ok({{"error", json::array()}, {"result", {{pair, ticker}}}});
+    });
+    route("GET", api + "public/Depth", [](const mock_request_t& request) {
+        auto pair = param(request.query, "pair");
+        auto split = split_kraken(pair);
+        double mid = price(split.first) / price(split.second);
+        auto now = std::time(nullptr);
+        json asks = json::array(), bids = json::array();
+        for (int i = 0; i < 100; ++i) {
+            asks.push_back({fixed(mid * (1.0005 + i * 0.0001), 5),
+                            fixed(1 + i % 7, 3), now - i});
+            bids.push_back({fixed(mid * (0.9995 - i * 0.0001), 5),
+                            fixed(1 + i % 5, 3), now - i});
+        }
+        return ok({{"error", json::array()},
+                   {"result", {{pair, {{"asks", asks}, {"bids", bids}}}}}});
+    });
+
+    route("POST", api + "private/Balance", [](const mock_request_t&) {
+        return ok({{"error", json::array()},
+                   {"result",
+                    {{"ZEUR", "10000.0000"}, {"XXBT", "1.0000000000"}}}});
+    });
+    route("POST", api + "private/DepositMethods", [](const mock_request_t&) {
+        return ok({{"error", json::array()},
+                   {"result",
+                    {{{"method", "Bitcoin"},
+                      {"limit", false},
+                      {"fee", "0.0000000000"},
+                      {"gen-address", true}}}}});
+    });
+    route("POST", api + "private/OpenOrders", [](const mock_request_t&) {
+        return ok({{"error", json::array()},
+                   {"result", {{"open", json::object()}}}});
+    });
+    route("POST", api + "private/ClosedOrders", [](const mock_request_t&) {
+        return ok({{"error", json::array()},
+                   {"result", {{"closed", json::object()}, {"count", 0}}}});
+    });
+    auto txid = std::make_shared<std::atomic<uint64_t>>(0);
+    route("POST", api + "private/AddOrder",
+          [txid](const mock_request_t& request) {
+              auto description = param(request.body, "type") + " " +
+                                 param(request.body, "volume") + " " +
+                                 param(request.body, "pair");
+              auto id = "OMOCK-" + std::to_string(++*txid);
+              return ok({{"error", json::array()},
+                         {"result",
+                          {{"descr", {{"order", description}}},
+                           {"txid", {id}}}}});
+          });
+    // the orders with a volume greater than 100 exceed the balance
+    route("POST", api + "private/AddOrderBatch",
+          [txid](const mock_request_t& request) {
+              auto body = json::parse(request.body);
+              json placed = json::array();
+              for (const auto& order : body.at("orders")) {
+                  auto volume = order.at("volume").get<std::string>();
+                  if (std::stod(volume) > 100) {
+                      placed.push_back(
+                          {{"error", "EOrder:Insufficient funds"}});
+                      continue;
+                  }
+                  auto description = order.at("type").get<std::string>() +
+                                     " " + volume + " " +
+                                     body.at("pair").get<std::string>();
+                  placed.push_back(
+                      {{"descr", {{"order", description}}},
+                       {"txid", "OMOCK-" + std::to_string(++*txid)}});
+              }
+              return ok({{"error", json::array()},
+                         {"result", {{"orders", placed}}}});
+          });
+    route("POST", api + "private/CancelOrder", [](const mock_request_t&) {
+        return ok({{"error", json::array()}, {"result", {{"count", 1}}}});
+    });
+    route("POST", api + "private/CancelOrderBatch",
+          [](const mock_request_t& request) {
+              auto count = json::parse(request.body).at("orders").size();
+              return ok({{"error", json::array()},
+                         {"result", {{"count", count}}}});
+          });
+    route("POST", api + "private/CancelAll", [](const mock_request_t&) {
+        return ok({{"error", json::array()}, {"result", {{"count", 0}}}});
+    });
+}
+
+void MockServer::shapeshift(const std::string& prefix)
+{
+    // the pair is the last component of the path, e.g. rate/btc_ltc
+    auto pair_of = [](const mock_request_t& request) {
+        return request.path.substr(request.path.find_last_of('/') + 1);
+    };
+    auto rate_of = [](std::string pair) {
+        auto delimiter = pair.find('_');
+        return price(pair.substr(0, delimiter)) /
+               price(pair.substr(delimiter + 1));
+    };
+    const std::vector<std::string> coins = {"BTC", "ETH", "LTC", "XMR",
+                                            "ZEC", "DASH", "DOGE"};
+
+    route("GET", prefix + "rate/", [=](const mock_request_t& request) {
+        auto pair = pair_of(request);
+        return ok({{"pair", pair}, {"rate", fixed(rate_of(pair), 8)}});
+    });
+    route("GET", prefix + "limit/", [=](const mock_request_t& request) {
+        auto pair = pair_of(request);
+        return ok({{"pair", pair},
+                   {"limit",
+                    fixed(1000 / price(pair.substr(0, pair.find('_'))), 8)},
+                   {"min", "0.00100000"}});
+    });
+    route("GET", prefix + "marketinfo/", [=](const mock_request_t& request) {
+        auto pair = pair_of(request);
+        if (!pair.empty()) {
+            return ok({{"pair", pair},
+                       {"rate", rate_of(pair)},
+                       {"limit", 10},
+                       {"maxLimit", 10},
+                       {"minimum", 0.001},
+                       {"minerFee", 0.0001}});
+        }
+        json markets = json::array();
+        for (const auto& from : coins) {
+            for (const auto& to : coins) {
+                if (from != to) {
+                    markets.push_back(
+                        {{"pair", from + "_" + to},
+                         {"rate", fixed(rate_of(from + "_" + to), 8)},
+                         {"limit", 10},
+                         {"maxLimit", 10},
+                         {"min", 0.001},
+                         {"minerFee", 0.0001}});
+                }
+            }
+        }
+        return ok(markets);
+    });
+    route("GET", prefix + "getcoins/", [=](const mock_request_t&) {
+        json result;
+        for (const auto& coin : coins) {
+            result[coin] = {{"name", coin},
+                            {"symbol", coin},
+                            {"status", "available"},
+                            {"minerFee", 0.0001}};
+        }
+        return ok(result);
+    });
+    route("GET", prefix + "txStat/", [=](const mock_request_t& request) {
+        return ok({{"status", "no_deposists"}, {"address", pair_of(request)}});
+    });
+}
+
+void MockServer::coinmarketcap(const std::string& prefix)
+{
+    auto row = [](std::size_t rank, const std::string& symbol) {
+        double usd = price(symbol) / price("USD");
+        std::string id = symbol;
+        tolower(id);
+        return json{{"id", id},
+                    {"name", symbol},
+                    {"symbol", symbol},
+                    {"rank", std::to_string(rank)},
+                    {"price_usd", fixed(usd, 6)},
+                    {"price_btc", fixed(usd / price("BTC"), 8)},
+                    {"24h_volume_usd", "1000000.0"},
+                    {"market_cap_usd", "100000000.0"},
+                    {"available_supply", "1000000.0"},
+                    {"total_supply", "1000000.0"},
+                    {"percent_change_1h", "0.1"},
+                    {"percent_change_24h", "-1.2"},
+                    {"percent_change_7d", "3.4"},
+                    {"last_updated", std::to_string(std::time(nullptr))}};
+    };
+    const std::vector<std::string> coins = {"BTC", "ETH",  "XRP", "BCH",
+                                            "LTC", "XMR",  "DASH", "ZEC",
+                                            "DOGE"};
+
+    route("GET", prefix + "ticker/", [=](const mock_request_t& request) {
+        json rows = json::array();
+        auto id = request.path.substr(prefix.size() + 7);
+        id = id.substr(0, id.find('/'));
+        auto start = param(request.query, "start");
+        auto limit = param(request.query, "limit");
+        std::size_t first = start.empty() ? 0 : std::stoul(start);
+        std::size_t last = limit.empty() ? coins.size()
+                                         : first + std::stoul(limit);
+        for (std::size_t i = first; i < std::min(last, coins.size()); ++i) {
+            std::string coin_id = coins[i];
+            tolower(coin_id);
+            if (id.empty() || id == coin_id) {
+                rows.push_back(row(i + 1, coins[i]));
+            }
+        }
+        if (rows.empty() && !id.empty()) {
+            return ok({{"error", "id not found"}});
+        }
+        return ok(rows);
+    });
+    route("GET", prefix + "global", [](const mock_request_t&) {
+        return ok({{"total_market_cap_usd", 200000000000.0},
+                   {"total_24h_volume_usd", 10000000000.0},
+                   {"bitcoin_percentage_of_market_cap", 52.3},
+                   {"active_currencies", 900},
+                   {"active_assets", 600},
+                   {"active_markets", 10000},
+                   {"last_updated", std::time(nullptr)}});
+    });
+}
+
+void MockServer::ecb(const std::string& prefix)
+{
+    route("GET", prefix + "stats/eurofxref/eurofxref-daily.xml",
+          [](const mock_request_t&) {
+              auto now = std::time(nullptr);
+              std::ostringstream xml;
+              xml << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>"
+                  << "<gesmes:Envelope "
+                     "xmlns:gesmes=\"http://www.gesmes.org/xml/2002-08-01\" "
+                     "xmlns=\"http://www.ecb.int/vocabulary/2002-08-01/"
+                     "eurofxref\">"
+                  << "<gesmes:subject>Reference rates</gesmes:subject>"
+                  << "<Cube><Cube time='"
+                  << std::put_time(std::gmtime(&now), "%Y-%m-%d") << "'>"
+                  << "<Cube currency='USD' rate='1.1470'/>"
+                  << "<Cube currency='JPY' rate='129.05'/>"
+                  << "<Cube currency='GBP' rate='0.87820'/>"
+                  << "<Cube currency='CHF' rate='1.1440'/>"
+                  << "</Cube></Cube></gesmes:Envelope>";
+              return mock_response_t{200, xml.str(), "text/xml"};
+          });
+    // eurofxref-hist.xml and eurofxref-hist-90d.xml: the last 3 days
+    route("GET", prefix + "stats/eurofxref/eurofxref-hist",
+          [](const mock_request_t&) {
+              auto now = std::time(nullptr);
+              std::ostringstream xml;
+              xml << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>"
+                  << "<gesmes:Envelope "
+                     "xmlns:gesmes=\"http://www.gesmes.org/xml/2002-08-01\" "
+                     "xmlns=\"http://www.ecb.int/vocabulary/2002-08-01/"
+                     "eurofxref\">"
+                  << "<gesmes:subject>Reference rates</gesmes:subject>"
+                  << "<Cube>";
+              for (int i = 0; i < 3; ++i) {
+                  std::time_t day = now - i * 24 * 60 * 60;
+                  xml << "<Cube time='"
+                      << std::put_time(std::gmtime(&day), "%Y-%m-%d") << "'>"
+                      << "<Cube currency='USD' rate='" << 1.1470 + i * 0.001
+                      << "'/>"
+                      << "<Cube currency='GBP' rate='0.87820'/>"
+                      << "</Cube>";
+              }
+              xml << "</Cube></gesmes:Envelope>";
+              return mock_response_t{200, xml.str(), "text/xml"};
+          });
+}
+
+}  // namespace at
@@ -0,0 +1,142 @@
+/* Copyright 2017 Paolo Galeone <nessuno@nerdz.eu>. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.*/
+
+#ifndef AT_MOCKSERVER_H_
+#define AT_MOCKSERVER_H_
+
+#include <at/request.hpp>
+#include <at/types.hpp>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+
+namespace at {
+
+typedef struct {
+    std::string method;
+    std::string path;   // without the query string
+    std::string query;  // without the leading ?
+    std::map<std::string, std::string> headers;  // lowercase names
+    std::string body;
+} mock_request_t;
+
+typedef struct {
+    int status;
+    std::string body;
+    std::string content_type;
+} mock_response_t;
+
+/* Local HTTP/1.1 server that mocks the APIs used by the clients of the
+ * library, for offline tests and load tests of the client stack.
+ *
+ * The clients use it through their host parameter, e.g.
+ *   MockServer server;
+ *   server.kraken();
+ *   Kraken kraken("key", "c2VjcmV0", server.url());
+ *
+ * Requests are routed by method and by the longest registered prefix of
+ * their path. Every response can be delayed by a random latency and
+ * replaced by an error with a given probability.
+ *
+ * The server listens on 127.0.0.1 and serves every connection (with
+ * keep-alive) on its own thread. All the methods are thread safe. */
+class MockServer {
+public:
+    typedef std::function<mock_response_t(const mock_request_t&)> handler_t;
+
+private:
+    typedef struct {
+        int fd;
+        std::thread thread;
+        std::atomic<bool> done;
+    } connection_t;
+
+    int _fd = -1;
+    uint16_t _port = 0;
+    std::thread _acceptor;
+    std::atomic<bool> _stop{false};
+    std::atomic<uint64_t> _requests{0};
+
+    std::mutex _mux;
+    std::list<std::unique_ptr<connection_t>> _connections;
+    std::map<std::string, handler_t> _routes;  // method + " " + prefix
+    std::chrono::microseconds _latency_min{0}, _latency_max{0};
+    double _error_probability = 0;
+    mock_response_t _error = {503, "Service Unavailable", "text/plain"};
+    std::mt19937_64 _random{42};
+
+    void _accept_loop();
+    void _serve(connection_t* connection);
+
+    // Returns the response to request, after the injected latency
+    mock_response_t _respond(const mock_request_t& request);
+
+public:
+    /* Listens on 127.0.0.1:port, port = 0 picks a free port.
+     * Throws std::runtime_error if the socket can't be bound. */
+    explicit MockServer(uint16_t port = 0);
+    ~MockServer();
+
+    uint16_t port() const { return _port; }
+
+    /* http://127.0.0.1:port/ */
+    std::string url() const;
+
+    /* Number of requests served */
+    uint64_t requests() const { return _requests; }
+
+    /* Serves the requests of method whose path starts with prefix */
+    void route(const std::string& method, const std::string& prefix,
+               handler_t handler);
+    void route(const std::string& method, const std::string& prefix,
+               const mock_response_t& response);
+
+    /* Delays every response by a random time in [min, max] */
+    void latency(std::chrono::microseconds min,
+                 std::chrono::microseconds max);
+
+    /* Replaces a response with error with the given probability */
+    void errors(double probability,
+                mock_response_t error = {503, "Service Unavailable",
+                                         "text/plain"});
+
+    /* Kraken, Shapeshift, CoinMarketCap and ECB compatible endpoints under
+     * prefix: the host of the client is url() + prefix without the
+     * leading /. The private Kraken endpoints don't check the
+     * signature. */
+    void kraken(const std::string& prefix = "/");
+    void shapeshift(const std::string& prefix = "/");
+    void coinmarketcap(const std::string& prefix = "/");
+    void ecb(const std::string& prefix = "/");
+};
+
+/* Restores the Request::retry_policy of its construction when destroyed:
+ * a test that replaces the global policy does not leak it into the next
+ * tests, even when an assertion or an exception ends it early */
+struct RetryPolicyGuard {
+    std::shared_ptr<const RetryPolicy> policy = Request::retry_policy();
+    ~RetryPolicyGuard() { Request::retry_policy(*policy); }
+};
+
+}  // end namespace at
+
+#endif  // AT_MOCKSERVER_H_
@@ -0,0 +1,282 @@
+#include <at/crypt/namespace.hpp>
+#include <at/exceptions.hpp>
+#include <at/kraken.hpp>
+#include <at/namespace.hpp>
+#include <at/request.hpp>
+#include <at/shapeshift.hpp>
+#include <gtest/gtest.h>
+
+#include "mockserver.hpp"
+
+TEST(MockServer, Kraken)
+{
+    at::MockServer server;
+    server.kraken();
+    at::Kraken kraken("key", "c2VjcmV0", server.url());
+
+    auto ticker = kraken.ticker(at::currency_pair_t("BTC", "EUR"));
+    EXPECT_GT(ticker.bid.price, 0);
+    EXPECT_LT(ticker.bid.price, ticker.ask.price);
+    EXPECT_EQ(kraken.orderBook(at::currency_pair_t("ETH", "EUR")).size(),
+              100);
+    EXPECT_EQ(kraken.balance("EUR"), 10000);
+
+    at::order_t order = {};
+    order.pair = at::currency_pair_t("BTC", "EUR");
+    order.action = at::order_action_t::buy;
+    order.type = at::order_type_t::limit;
+    order.volume = 0.01;
+    order.price = 6000;
+    kraken.place(order);
+    EXPECT_EQ(order.txid, "OMOCK-1");
+    kraken.cancel(order);
+    EXPECT_EQ(server.requests(), 5);
+}
+
+TEST(FormBody, Encode)
+{
+    at::FormBody body;
+    EXPECT_TRUE(body.empty());
+    body.add("pair", "XBTEUR").add("note", "a b&c=d/~é");
+    EXPECT_EQ(body.str(), "pair=XBTEUR&note=a%20b%26c%3Dd%2F~%C3%A9");
+    body.clear();
+    body.add("nonce", "1");
+    EXPECT_EQ(body.str(), "nonce=1");
+}
+
+TEST(MockServer, KrakenSignature)
+{
+    at::MockServer server;
+    server.kraken();
+    at::mock_request_t signed_request;
+    server.route("POST", "/0/private/Balance",
+                 [&](const at::mock_request_t& request) {
+                     signed_request = request;
+                     return at::mock_response_t{
+                         200, R"({"error":[],"result":{"ZEUR":"1"}})",
+                         "application/json"};
+                 });
+    at::Kraken kraken("key", "c2VjcmV0", server.url());
+    EXPECT_EQ(kraken.balance("EUR"), 1);
+
+    // the signature covers the body as sent
+    const auto& body = signed_request.body;
+    auto nonce = body.substr(body.find("nonce=") + 6);
+    std::string path = "/0/private/Balance";
+    std::vector<unsigned char> data(path.begin(), path.end());
+    auto digest = at::crypt::sha256(nonce + body);
+    data.insert(data.end(), digest.begin(), digest.end());
+    EXPECT_EQ(signed_request.headers.at("api-sign"),
+              at::crypt::base64_encode(at::crypt::hmac_sha512(
+                  data, at::crypt::base64_decode("c2VjcmV0"))));
+}
+
+TEST(MockServer, KrakenBatch)
+{
+    at::MockServer server;
+    server.kraken();
+    at::Kraken kraken("key", "c2VjcmV0", server.url());
+
+    // 20 BTC orders, the last one too large, and a single ETH order
+    std::vector<at::order_t> orders(21);
+    for (std::size_t i = 0; i < orders.size(); ++i) {
+        orders[i].pair = at::currency_pair_t(i < 20 ? "BTC" : "ETH", "EUR");
+        orders[i].action = at::order_action_t::buy;
+        orders[i].type = at::order_type_t::limit;
+        orders[i].volume = i == 19 ? 1000 : 0.01;
+        orders[i].price = 6000 - static_cast<double>(i);
+    }
+    auto placed = kraken.place(orders);
+    ASSERT_EQ(placed.size(), orders.size());
+    for (std::size_t i = 0; i < orders.size(); ++i) {
+        EXPECT_EQ(placed[i] == nullptr, i != 19) << i;
+        EXPECT_EQ(orders[i].txid.empty(), i == 19) << i;
+    }
+    EXPECT_THROW(std::rethrow_exception(placed[19]), at::response_error);
+    // two batches of BTC orders and an AddOrder
+    EXPECT_EQ(server.requests(), 3);
+
+    orders.pop_back();
+    for (const auto& error : kraken.cancel(orders)) {
+        EXPECT_EQ(error, nullptr);
+    }
+    EXPECT_EQ(orders[0].txid, "");
+    kraken.cancelAll();
+    EXPECT_EQ(server.requests(), 5);
+}
+
+TEST(MockServer, KrakenPartialCancel)
+{
+    at::MockServer server;
+    server.kraken();
+    at::Kraken kraken("key", "c2VjcmV0", server.url());
+
+    std::vector<at::order_t> orders(3);
+    for (auto& order : orders) {
+        order.pair = at::currency_pair_t("BTC", "EUR");
+        order.action = at::order_action_t::buy;
+        order.type = at::order_type_t::limit;
+        order.volume = 0.01;
+        order.price = 6000;
+    }
+    for (const auto& error : kraken.place(orders)) {
+        ASSERT_EQ(error, nullptr);
+    }
+
+    // only 2 of the 3 orders are canceled, the second one is still open
+    const std::string live = orders[1].txid;
+    server.route("POST", "/0/private/CancelOrderBatch",
+                 at::mock_response_t{
+                     200, R"({"error":[],"result":{"count":2}})",
+                     "application/json"});
+    server.route("POST", "/0/private/OpenOrders",
+                 at::mock_response_t{200,
+                                     R"({"error":[],"result":{"open":{")" +
+                                         live + R"(":{}}}})",
+                                     "application/json"});
+    auto canceled = kraken.cancel(orders);
+    ASSERT_EQ(canceled.size(), 3);
+    EXPECT_EQ(canceled[0], nullptr);
+    EXPECT_EQ(canceled[2], nullptr);
+    EXPECT_THROW(std::rethrow_exception(canceled[1]), at::response_error);
+    EXPECT_EQ(orders[0].txid, "");
+    EXPECT_EQ(orders[1].txid, live);
+    EXPECT_EQ(orders[2].txid, "");
+
+    // the outcome is unknown if the open orders can't be listed
+    server.route("POST", "/0/private/OpenOrders",
+                 at::mock_response_t{
+                     200, R"({"error":["EGeneral:Internal error"]})",
+                     "application/json"});
+    orders[0].txid = "A";
+    orders[2].txid = "C";
+    canceled = kraken.cancel(orders);
+    ASSERT_EQ(canceled.size(), 3);
+    for (std::size_t i = 0; i < canceled.size(); ++i) {
+        ASSERT_NE(canceled[i], nullptr);
+        try {
+            std::rethrow_exception(canceled[i]);
+        }
+        catch (const at::response_error& e) {
+            EXPECT_EQ(std::string(e.what()),
+                      "cancel outcome unknown: " + orders[i].txid);
+        }
+    }
+    EXPECT_EQ(orders[1].txid, live);
+}
+
+TEST(MockServer, KrakenMalformedBatch)
+{
+    at::MockServer server;
+    server.kraken();
+    at::Kraken kraken("key", "c2VjcmV0", server.url());
+
+    std::vector<at::order_t> orders(3);
+    for (auto& order : orders) {
+        order.pair = at::currency_pair_t("BTC", "EUR");
+        order.action = at::order_action_t::buy;
+        order.type = at::order_type_t::limit;
+        order.volume = 0.01;
+        order.price = 6000;
+    }
+    // fewer results than orders: no order is known to be live
+    server.route("POST", "/0/private/AddOrderBatch",
+                 at::mock_response_t{
+                     200, R"({"error":[],"result":{"orders":[{"txid":"A"}]}})",
+                     "application/json"});
+    for (const auto& error : kraken.place(orders)) {
+        ASSERT_NE(error, nullptr);
+        EXPECT_THROW(std::rethrow_exception(error), at::response_error);
+    }
+    for (const auto& order : orders) {
+        EXPECT_EQ(order.txid, "");
+    }
+
+    // a result without txid fails only its order
+    server.route("POST", "/0/private/AddOrderBatch",
+                 at::mock_response_t{200,
+                                     R"({"error":[],"result":{"orders":[)"
+                                     R"({"txid":"A"},{},{"txid":"C"}]}})",
+                                     "application/json"});
+    auto placed = kraken.place(orders);
+    ASSERT_NE(placed[1], nullptr);
+    EXPECT_EQ(placed[0], nullptr);
+    EXPECT_THROW(std::rethrow_exception(placed[1]), at::response_error);
+    EXPECT_EQ(placed[2], nullptr);
+    EXPECT_EQ(orders[0].txid, "A");
+    EXPECT_EQ(orders[1].txid, "");
+    EXPECT_EQ(orders[2].txid, "C");
+}
+
+TEST(MockServer, Shapeshift)
+{
+    at::MockServer server;
+    server.shapeshift("/shapeshift/");
+    at::Shapeshift shapeshift("", server.url() + "shapeshift/");
+
+    EXPECT_GT(shapeshift.rate(at::currency_pair_t("BTC", "LTC")), 1);
+    EXPECT_EQ(shapeshift.info().size(), 7 * 6);
+    EXPECT_EQ(shapeshift.coins().size(), 7);
+}
+
+TEST(MockServer, ValidateAddress)
+{
+    at::MockServer server;
+    server.route("GET", "/validateAddress/",
+                 at::mock_response_t{200, R"({"isvalid":true})",
+                                     "application/json"});
+    EXPECT_TRUE(at::isValidAddress("NXT", "NXT-TEST", server.url()));
+
+    // a 200 that's not JSON (e.g. a maintenance page) is a server_error
+    at::RetryPolicyGuard guard;
+    at::Request::retry_policy(at::RetryPolicy::none());
+    server.route("GET", "/validateAddress/",
+                 at::mock_response_t{200, "<html>maintenance</html>",
+                                     "text/html"});
+    EXPECT_THROW(at::isValidAddress("NXT", "NXT-TEST", server.url()),
+                 at::server_error);
+}
+
+TEST(MockServer, MalformedContentLength)
+{
+    at::MockServer server;
+    server.kraken();
+    at::RetryPolicyGuard guard;
+    at::Request::retry_policy(at::RetryPolicy::none());
+    at::Request req({"Content-Length: abc"});
+    try {
+        req.post(server.url() + "0/private/Balance", at::FormBody());
+        FAIL() << "expected a server_error";
+    }
+    catch (const at::server_error& e) {
+        EXPECT_NE(std::string(e.what()).find("status = 400"),
+                  std::string::npos);
+    }
+    // the server keeps serving the other connections
+    at::Kraken kraken("key", "c2VjcmV0", server.url());
+    EXPECT_NO_THROW(kraken.time());
+}
+
+TEST(MockServer, Errors)
+{
+    at::MockServer server;
+    server.kraken();
+    at::Kraken kraken("key", "c2VjcmV0", server.url());
+    at::RetryPolicyGuard guard;
+    at::Request::retry_policy(at::RetryPolicy::none());
+
+    server.errors(1);
+    EXPECT_THROW(kraken.time(), at::server_error);
+
+    server.errors(1, {200, R"({"error":["EService:Busy"]})",
+                      "application/json"});
+    EXPECT_THROW(kraken.time(), at::server_error);
+
+    server.errors(0);
+    server.latency(std::chrono::milliseconds(20),
+                   std::chrono::milliseconds(20));
+    auto start = std::chrono::steady_clock::now();
+    kraken.time();
+    EXPECT_GE(std::chrono::steady_clock::now() - start,
+              std::chrono::milliseconds(20));
+}
@@ -0,0 +1,117 @@
+#include <at/papermarket.hpp>
+#include <gtest/gtest.h>
+
+namespace {
+
+at::PaperMarket market()
+{
+    return at::PaperMarket(
+        {at::market_info_t{
+            .pair = at::currency_pair_t("BTC", "EUR"),
+            .limit = at::min_max_t{.min = 0.001, .max = 0},
+            .maker_fee = 0.16,
+            .taker_fee = 0.26,
+        }},
+        {{"EUR", 10000}, {"BTC", 1}});
+}
+
+at::order_t order(at::order_type_t type, at::order_action_t action,
+                  double volume, double price)
+{
+    at::order_t ret = {};
+    ret.type = type;
+    ret.action = action;
+    ret.pair = at::currency_pair_t("BTC", "EUR");
+    ret.volume = volume;
+    ret.price = price;
+    return ret;
+}
+
+}  // end namespace
+
+TEST(PaperMarket, MatchesWithPriceTimePriority)
+{
+    auto paper = market();
+    paper.feed(at::currency_pair_t("btc", "eur"),
+               {at::ticker_t{.bid = {.price = 99, .amount = 1, .time = 0},
+                             .ask = {.price = 101, .amount = 1, .time = 0}},
+                at::ticker_t{.bid = {.price = 98, .amount = 2, .time = 0},
+                             .ask = {.price = 102, .amount = 2, .time = 0}}});
+
+    auto ticker = paper.ticker(at::currency_pair_t("BTC", "EUR"));
+    ASSERT_EQ(ticker.bid.price, 99);
+    ASSERT_EQ(ticker.ask.price, 101);
+
+    // market buy sweeps the first ask level and part of the second
+    auto buy = order(at::order_type_t::market, at::order_action_t::buy, 2, 0);
+    paper.place(buy);
+    ASSERT_EQ(buy.status, at::tx_status_t::closed);
+    ASSERT_DOUBLE_EQ(buy.cost, 101 + 102);
+    ASSERT_DOUBLE_EQ(buy.fee, (101 + 102) * 0.26 / 100);
+    ASSERT_DOUBLE_EQ(paper.balance("BTC"), 3);
+    ASSERT_DOUBLE_EQ(paper.balance("EUR"), 10000 - buy.cost - buy.fee);
+
+    // resting limit sell, ahead of the fed ask at the same price
+    auto sell =
+        order(at::order_type_t::limit, at::order_action_t::sell, 1, 102);
+    paper.place(sell);
+    ASSERT_EQ(sell.status, at::tx_status_t::open);
+    ASSERT_EQ(paper.openOrders().size(), 1);
+    ASSERT_DOUBLE_EQ(paper.ticker(at::currency_pair_t("BTC", "EUR")).ask.amount,
+                     2);
+
+    // a new book crossing the resting sell executes it
+    paper.feed(at::currency_pair_t("BTC", "EUR"),
+               {at::ticker_t{.bid = {.price = 103, .amount = 0.5, .time = 0},
+                             .ask = {.price = 104, .amount = 1, .time = 0}}});
+    auto open = paper.openOrders();
+    ASSERT_EQ(open.size(), 1);
+    ASSERT_DOUBLE_EQ(open[0].cost, 0.5 * 102);
+
+    paper.cancel(open[0]);
+    ASSERT_TRUE(paper.openOrders().empty());
+    auto closed = paper.closedOrders();
+    ASSERT_EQ(closed.size(), 2);
+    ASSERT_EQ(closed[1].status, at::tx_status_t::canceled);
+    ASSERT_DOUBLE_EQ(paper.balance("BTC"), 2.5);
+}
+
+TEST(PaperMarket, ShouldRejectOrdersWithoutFunds)
+{
+    auto paper = market();
+    auto buy =
+        order(at::order_type_t::limit, at::order_action_t::buy, 1, 10000);
+    ASSERT_THROW(paper.place(buy), at::response_error);
+
+    // locked balance can't be used twice
+    auto sell =
+        order(at::order_type_t::limit, at::order_action_t::sell, 1, 200);
+    paper.place(sell);
+    ASSERT_THROW(paper.place(sell), at::response_error);
+
+    auto unknown = order(at::order_type_t::limit, at::order_action_t::sell, 1,
+                         200);
+    unknown.pair = at::currency_pair_t("ETH", "EUR");
+    ASSERT_THROW(paper.place(unknown), at::response_error);
+}
+
+TEST(PaperMarket, PlacesAndCancelsBatches)
+{
+    auto paper = market();
+    std::vector<at::order_t> orders = {
+        order(at::order_type_t::limit, at::order_action_t::sell, 0.5, 200),
+        order(at::order_type_t::limit, at::order_action_t::sell, 1, 201),
+        order(at::order_type_t::limit, at::order_action_t::sell, 0.5, 202),
+    };
+    // the second order exceeds the balance left by the first one
+    auto placed = paper.place(orders);
+    ASSERT_EQ(placed.size(), 3);
+    ASSERT_EQ(placed[0], nullptr);
+    ASSERT_THROW(std::rethrow_exception(placed[1]), at::response_error);
+    ASSERT_EQ(placed[2], nullptr);
+    ASSERT_EQ(paper.openOrders().size(), 2);
+
+    paper.cancelAll();
+    ASSERT_TRUE(paper.openOrders().empty());
+    ASSERT_DOUBLE_EQ(paper.balance("BTC"), 1);
+}
@@ -0,0 +1,190 @@
+#include <at/rategraph.hpp>
+#include <gtest/gtest.h>
+
+#include <limits>
+
+static at::exchange_info_t market(const std::string& base,
+                                  const std::string& quote, double rate,
+                                  double miner_fee = 0, double min = 0,
+                                  double max =
+                                      std::numeric_limits<double>::max())
+{
+    return at::exchange_info_t{
+        .pair = at::currency_pair_t(base, quote),
+        .limit = {.min = min, .max = max},
+        .rate = rate,
+        .miner_fee = miner_fee,
+    };
+}
+
+TEST(RateGraph, MultiHop)
+{
+    at::RateGraph graph({
+        market("BTC", "ETH", 30),
+        market("ETH", "LTC", 3),
+        market("BTC", "LTC", 80),
+        market("LTC", "DOGE", 1000),
+    });
+    EXPECT_EQ(graph.size(), 4);
+
+    auto conversion = graph.best("btc", "ltc", 2);
+    EXPECT_EQ(conversion.path,
+              std::vector<std::string>({"BTC", "ETH", "LTC"}));
+    EXPECT_DOUBLE_EQ(conversion.input, 2);
+    EXPECT_DOUBLE_EQ(conversion.output, 2 * 30 * 3);
+
+    conversion = graph.best("BTC", "DOGE", 1);
+    EXPECT_EQ(conversion.path,
+              std::vector<std::string>({"BTC", "ETH", "LTC", "DOGE"}));
+    EXPECT_DOUBLE_EQ(conversion.output, 30 * 3 * 1000);
+
+    // no conversion towards BTC
+    conversion = graph.best("DOGE", "BTC", 1);
+    EXPECT_TRUE(conversion.path.empty());
+    EXPECT_DOUBLE_EQ(conversion.output, 0);
+}
+
+TEST(RateGraph, MaxHops)
+{
+    at::RateGraph graph({
+        market("BTC", "ETH", 30),
+        market("ETH", "LTC", 3),
+        market("BTC", "LTC", 80),
+        market("LTC", "DOGE", 1000),
+    });
+    auto conversion = graph.best("BTC", "LTC", 1, 1);
+    EXPECT_EQ(conversion.path, std::vector<std::string>({"BTC", "LTC"}));
+    EXPECT_DOUBLE_EQ(conversion.output, 80);
+
+    conversion = graph.best("BTC", "DOGE", 1, 2);
+    EXPECT_EQ(conversion.path,
+              std::vector<std::string>({"BTC", "LTC", "DOGE"}));
+    EXPECT_DOUBLE_EQ(conversion.output, 80 * 1000);
+
+    EXPECT_TRUE(graph.best("BTC", "DOGE", 1, 1).path.empty());
+    EXPECT_TRUE(graph.best("BTC", "LTC", 1, 0).path.empty());
+}
+
+TEST(RateGraph, MinerFees)
+{
+    at::RateGraph graph({
+        market("BTC", "ETH", 30, 5),
+        market("ETH", "LTC", 3, 1),
+        market("BTC", "LTC", 80, 0.5),
+    });
+    // 1 BTC: (30 - 5) * 3 - 1 = 74 < 80 - 0.5
+    auto conversion = graph.best("BTC", "LTC", 1);
+    EXPECT_EQ(conversion.path, std::vector<std::string>({"BTC", "LTC"}));
+    EXPECT_DOUBLE_EQ(conversion.output, 79.5);
+    // 10 BTC: (300 - 5) * 3 - 1 = 884 > 800 - 0.5
+    conversion = graph.best("BTC", "LTC", 10);
+    EXPECT_EQ(conversion.path,
+              std::vector<std::string>({"BTC", "ETH", "LTC"}));
+    EXPECT_DOUBLE_EQ(conversion.output, 884);
+    // the fee takes everything
+    EXPECT_TRUE(graph.best("BTC", "ETH", 0.1).path.empty());
+}
+
+TEST(RateGraph, Limits)
+{
+    at::RateGraph graph({
+        market("BTC", "ETH", 30, 0, 0.5, 5),
+        market("ETH", "LTC", 3, 0, 0, 100),
+        // better rate, but a smaller output that's in the limits
+        market("BTC", "XMR", 20, 0, 0, 10),
+        market("XMR", "LTC", 4, 0, 0, 50),
+    });
+    // below the minimum of BTC -> ETH
+    auto conversion = graph.best("BTC", "ETH", 0.1);
+    EXPECT_TRUE(conversion.path.empty());
+    EXPECT_DOUBLE_EQ(conversion.output, 0);
+    // above the maximum of BTC -> ETH
+    EXPECT_TRUE(graph.best("BTC", "ETH", 6).path.empty());
+
+    // 1 BTC: 30 * 3 = 90 > 20 * 4 = 80
+    conversion = graph.best("BTC", "LTC", 1);
+    EXPECT_EQ(conversion.path,
+              std::vector<std::string>({"BTC", "ETH", "LTC"}));
+    EXPECT_DOUBLE_EQ(conversion.output, 90);
+
+    // 2 BTC: the 60 ETH of the largest path are above the maximum of
+    // ETH -> LTC, while the 40 XMR of the smaller one are in the limits
+    graph.update({
+        market("BTC", "ETH", 30, 0, 0.5, 5),
+        market("ETH", "LTC", 3, 0, 0, 50),
+        market("BTC", "XMR", 20, 0, 0, 10),
+        market("XMR", "LTC", 4, 0, 0, 50),
+    });
+    conversion = graph.best("BTC", "LTC", 2);
+    EXPECT_EQ(conversion.path,
+              std::vector<std::string>({"BTC", "XMR", "LTC"}));
+    EXPECT_DOUBLE_EQ(conversion.output, 160);
+}
+
+TEST(RateGraph, ShouldReachThroughSmallerAmounts)
+{
+    // 2 BTC reach LTC in 2 conversions both with 60 (via ETH) and with 40
+    // (via XMR): only 40 is in the limits of LTC -> DOGE
+    at::RateGraph graph({
+        market("BTC", "ETH", 30),
+        market("BTC", "XMR", 20),
+        market("ETH", "LTC", 1),
+        market("XMR", "LTC", 1),
+        market("LTC", "DOGE", 1000, 0, 0, 50),
+    });
+    auto conversion = graph.best("BTC", "DOGE", 2);
+    EXPECT_EQ(conversion.path,
+              std::vector<std::string>({"BTC", "XMR", "LTC", "DOGE"}));
+    EXPECT_DOUBLE_EQ(conversion.output, 40000);
+}
+
+TEST(RateGraph, Update)
+{
+    at::RateGraph graph({
+        market("BTC", "ETH", 30),
+        market("ETH", "LTC", 3),
+        market("BTC", "LTC", 80),
+    });
+    // same snapshot: nothing changes
+    EXPECT_EQ(graph.update({
+                  market("BTC", "ETH", 30),
+                  market("ETH", "LTC", 3),
+                  market("BTC", "LTC", 80),
+              }),
+              0);
+    // BTC -> ETH changes, ETH -> LTC disappears
+    EXPECT_EQ(graph.update({
+                  market("BTC", "ETH", 31),
+                  market("BTC", "LTC", 80),
+              }),
+              2);
+    auto conversion = graph.best("BTC", "LTC", 1);
+    EXPECT_EQ(conversion.path, std::vector<std::string>({"BTC", "LTC"}));
+    EXPECT_DOUBLE_EQ(conversion.output, 80);
+}
+
+TEST(RateGraph, UnknownSymbol)
+{
+    at::RateGraph graph({market("BTC", "ETH", 30)});
+    auto conversion = graph.best("BTC", "XYZ", 1);
+    EXPECT_TRUE(conversion.path.empty());
+    EXPECT_DOUBLE_EQ(conversion.output, 0);
+    EXPECT_DOUBLE_EQ(conversion.input, 1);
+    EXPECT_TRUE(graph.best("XYZ", "ETH", 1).path.empty());
+    EXPECT_EQ(graph.size(), 2);
+}
+
+TEST(RateGraph, ShouldNotVisitACurrencyTwice)
+{
+    // BTC -> ETH -> BTC gains 20%, but a path can't loop over it
+    at::RateGraph graph({
+        market("BTC", "ETH", 30),
+        market("ETH", "BTC", 0.04),
+        market("ETH", "LTC", 3),
+    });
+    auto conversion = graph.best("BTC", "LTC", 1, 5);
+    EXPECT_EQ(conversion.path,
+              std::vector<std::string>({"BTC", "ETH", "LTC"}));
+    EXPECT_DOUBLE_EQ(conversion.output, 90);
+    EXPECT_TRUE(graph.best("BTC", "BTC", 1, 5).path.empty());
+}
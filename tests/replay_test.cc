@@ -0,0 +1,77 @@
+#include <at/replay.hpp>
+#include <gtest/gtest.h>
+
+#include <cstdio>
+
+TEST(Replay, ShouldMergeLogsByTime)
+{
+    const at::currency_pair_t btc("BTC", "EUR"), eth("ETH", "EUR");
+    const std::vector<std::string> paths = {
+        ::testing::TempDir() + "replay_test_0.bin",
+        ::testing::TempDir() + "replay_test_1.bin"};
+    for (const auto& path : paths) {
+        std::remove(path.c_str());
+    }
+    {
+        at::MarketRecorder first(paths[0]), second(paths[1]);
+        for (std::time_t t = 0; t < 10; ++t) {
+            at::ticker_t ticker = {
+                .bid = {.price = 100. + t, .amount = 1, .time = t},
+                .ask = {.price = 101. + t, .amount = 1, .time = t},
+            };
+            // even times in the first log, odd times in the second one
+            (t % 2 == 0 ? first : second).ticker(btc, ticker);
+            // unknown to the market
+            first.ticker(eth, ticker);
+        }
+    }
+
+    at::PaperMarket market(
+        {at::market_info_t{.pair = btc,
+                           .limit = {.min = 0, .max = 0},
+                           .maker_fee = 0,
+                           .taker_fee = 0}},
+        {{"EUR", 1000}});
+    at::Replay replay(market, paths);
+
+    std::vector<std::time_t> times;
+    auto events = replay.run(
+        [&](const at::market_event_t& event, const at::currency_pair_t& pair) {
+            ASSERT_EQ(pair, btc);
+            ASSERT_EQ(market.time(), event.time);
+            times.push_back(event.time);
+            if (event.time == 4) {
+                auto order = at::order_t{};
+                order.pair = btc;
+                order.type = at::order_type_t::limit;
+                order.action = at::order_action_t::buy;
+                order.volume = 1;
+                order.price = 105;
+                market.place(order);
+            }
+        },
+        8);
+    // bid and ask of both pairs
+    ASSERT_EQ(events, 2 * 8 + 2 * 8);
+    ASSERT_EQ(times, std::vector<std::time_t>({0, 1, 2, 3, 4, 5, 6, 7}));
+
+    // the buy at 105 is executed against the ask of t = 4
+    auto closed = market.closedOrders();
+    ASSERT_EQ(closed.size(), 1);
+    ASSERT_EQ(closed[0].close, 4);
+    ASSERT_DOUBLE_EQ(market.balance("BTC"), 1);
+
+    ASSERT_EQ(replay.run(), 2 * 2 + 2 * 2);
+
+    replay.seek(5);
+    times.clear();
+    replay.run(
+        [&](const at::market_event_t& event, const at::currency_pair_t&) {
+            times.push_back(event.time);
+        });
+    ASSERT_EQ(times, std::vector<std::time_t>({5, 6, 7, 8, 9}));
+
+    for (const auto& path : paths) {
+        std::remove(path.c_str());
+    }
+}
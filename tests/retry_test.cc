@@ -0,0 +1,141 @@
+#include <at/exceptions.hpp>
+#include <at/kraken.hpp>
+#include <at/request.hpp>
+#include <at/retry.hpp>
+#include <gtest/gtest.h>
+
+#include "mockserver.hpp"
+
+TEST(RetryPolicy, Run)
+{
+    at::RetryPolicy policy(3, std::chrono::milliseconds(1),
+                           std::chrono::milliseconds(4));
+    for (unsigned attempt = 1; attempt < 10; ++attempt) {
+        EXPECT_LE(policy.backoff(attempt), std::chrono::milliseconds(4));
+    }
+
+    int calls = 0;
+    auto fail = [&]() -> int {
+        ++calls;
+        throw at::server_error("fail");
+    };
+    EXPECT_THROW(policy.run(true, fail), at::server_error);
+    EXPECT_EQ(calls, 3);
+
+    // not idempotent: retried only if not sent
+    calls = 0;
+    EXPECT_THROW(policy.run(false, fail), at::server_error);
+    EXPECT_EQ(calls, 1);
+    calls = 0;
+    EXPECT_THROW(policy.run(false,
+                            [&]() -> int {
+                                ++calls;
+                                throw at::connection_error("refused");
+                            }),
+                 at::connection_error);
+    EXPECT_EQ(calls, 3);
+
+    // nested runs do not multiply the attempts
+    calls = 0;
+    EXPECT_THROW(policy.run(true, [&]() { return policy.run(true, fail); }),
+                 at::server_error);
+    EXPECT_EQ(calls, 3);
+
+    calls = 0;
+    EXPECT_EQ(policy.run(true,
+                         [&]() {
+                             if (++calls < 2) {
+                                 throw at::server_error("fail");
+                             }
+                             return calls;
+                         }),
+              2);
+}
+
+TEST(CircuitBreaker, Kraken)
+{
+    at::MockServer server;
+    server.kraken();
+    at::Kraken kraken("key", "c2VjcmV0", server.url());
+    at::RetryPolicyGuard guard;
+    at::Request::retry_policy(at::RetryPolicy(
+        3, std::chrono::milliseconds(1), std::chrono::milliseconds(1)));
+    auto breaker = at::CircuitBreaker::host(
+        "127.0.0.1:" + std::to_string(server.port()));
+    breaker->configure(4, std::chrono::milliseconds(50));
+
+    // Kraken overloaded: retried, then the circuit opens
+    server.errors(1, {200, R"({"error":["EService:Busy"]})",
+                      "application/json"});
+    EXPECT_THROW(kraken.time(), at::server_error);
+    EXPECT_EQ(server.requests(), 3);
+    EXPECT_THROW(kraken.balance(), at::server_error);
+    EXPECT_EQ(server.requests(), 4);
+    EXPECT_EQ(breaker->state(), at::CircuitBreaker::state_t::open);
+    EXPECT_THROW(kraken.time(), at::circuit_open_error);
+    EXPECT_EQ(server.requests(), 4);
+
+    // an order is never sent twice
+    std::this_thread::sleep_for(std::chrono::milliseconds(60));
+    at::order_t order = {};
+    order.pair = at::currency_pair_t("BTC", "EUR");
+    order.action = at::order_action_t::buy;
+    order.type = at::order_type_t::limit;
+    order.volume = 0.01;
+    order.price = 6000;
+    EXPECT_THROW(kraken.place(order), at::server_error);
+    EXPECT_EQ(server.requests(), 5);
+
+    // the trial request closes the circuit
+    std::this_thread::sleep_for(std::chrono::milliseconds(60));
+    server.errors(0);
+    kraken.time();
+    EXPECT_EQ(breaker->state(), at::CircuitBreaker::state_t::closed);
+}
+
+TEST(RetryPolicy, ShouldRetryOnlyTheReadOnlyKrakenMethods)
+{
+    at::MockServer server;
+    server.kraken();
+    at::Kraken kraken("key", "c2VjcmV0", server.url());
+    at::RetryPolicyGuard guard;
+    at::Request::retry_policy(at::RetryPolicy(
+        3, std::chrono::milliseconds(1), std::chrono::milliseconds(1)));
+    at::CircuitBreaker::host("127.0.0.1:" + std::to_string(server.port()))
+        ->configure(100, std::chrono::milliseconds(50));
+
+    server.errors(1, {200, R"({"error":["EService:Busy"]})",
+                      "application/json"});
+    EXPECT_THROW(kraken.balance(), at::server_error);
+    EXPECT_EQ(server.requests(), 3);
+    EXPECT_THROW(kraken.openOrders(), at::server_error);
+    EXPECT_EQ(server.requests(), 6);
+    // cancelling every order is not idempotent
+    EXPECT_THROW(kraken.cancelAll(), at::server_error);
+    EXPECT_EQ(server.requests(), 7);
+}
+
+TEST(CircuitBreaker, ShouldOpenOnPagesThatAreNotJSON)
+{
+    at::MockServer server;
+    server.kraken();
+    at::Kraken kraken("key", "c2VjcmV0", server.url());
+    auto breaker = at::CircuitBreaker::host(
+        "127.0.0.1:" + std::to_string(server.port()));
+    breaker->configure(2, std::chrono::milliseconds(50));
+
+    // maintenance page served with a 200
+    server.errors(1, {200, "<html><body>Maintenance</body></html>",
+                      "text/html"});
+    EXPECT_THROW(kraken.time(), at::json::parse_error);
+    EXPECT_THROW(kraken.time(), at::json::parse_error);
+    EXPECT_EQ(breaker->state(), at::CircuitBreaker::state_t::open);
+    EXPECT_THROW(kraken.time(), at::circuit_open_error);
+    EXPECT_EQ(server.requests(), 2);
+
+    // the trial request gets the page again: the circuit stays open
+    std::this_thread::sleep_for(std::chrono::milliseconds(60));
+    EXPECT_THROW(kraken.time(), at::json::parse_error);
+    EXPECT_EQ(breaker->state(), at::CircuitBreaker::state_t::open);
+    EXPECT_EQ(server.requests(), 3);
+}
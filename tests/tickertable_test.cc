@@ -0,0 +1,107 @@
+#include <at/tickertable.hpp>
+#include <gtest/gtest.h>
+
+static at::json row(std::string id, std::string price, std::string updated)
+{
+    return at::json{{"id", id},
+                    {"name", id},
+                    {"symbol", id},
+                    {"rank", "1"},
+                    {"price_usd", price},
+                    {"price_btc", "1.0"},
+                    {"24h_volume_usd", "10"},
+                    {"market_cap_usd", "100"},
+                    {"available_supply", "10"},
+                    {"total_supply", "10"},
+                    {"percent_change_1h", "0.1"},
+                    {"percent_change_24h", nullptr},
+                    {"percent_change_7d", "0.3"},
+                    {"last_updated", updated}};
+}
+
+TEST(TickerTable, ShouldApplyOnlyChangedRows)
+{
+    at::TickerTable table;
+    auto changes = table.apply(at::json::array(
+        {row("bitcoin", "10.0", "1"), row("ethereum", "2.0", "1")}));
+    ASSERT_EQ(2, changes.added.size());
+    ASSERT_EQ(2, table.size());
+
+    changes = table.apply(at::json::array(
+        {row("bitcoin", "11.0", "2"), row("ethereum", "3.0", "1")}));
+    ASSERT_TRUE(changes.added.empty());
+    ASSERT_EQ(1, changes.updated.size());
+    ASSERT_EQ(table.find("bitcoin"), changes.updated[0]);
+    ASSERT_EQ(11.0, table.price_usd()[table.find("bitcoin")]);
+    // ethereum last_updated did not change: the row is untouched
+    ASSERT_EQ(2.0, table.price_usd()[table.find("ethereum")]);
+}
+
+TEST(TickerTable, ShouldPruneMissingRows)
+{
+    at::TickerTable table;
+    table.apply(at::json::array({row("bitcoin", "10.0", "1"),
+                                 row("ethereum", "2.0", "1"),
+                                 row("litecoin", "1.0", "1")}));
+    auto changes = table.apply(at::json::array({row("litecoin", "1.5", "2"),
+                                                row("ethereum", "2.0", "1")}),
+                               true);
+    ASSERT_EQ(1, changes.removed.size());
+    ASSERT_EQ("bitcoin", changes.removed[0]);
+    ASSERT_EQ(2, table.size());
+    ASSERT_EQ(at::TickerTable::npos, table.find("bitcoin"));
+    ASSERT_EQ(1, changes.updated.size());
+    ASSERT_EQ("litecoin", table.at(changes.updated[0]).id);
+}
+
+TEST(TickerTable, ShouldNotInsertMalformedRows)
+{
+    at::TickerTable table;
+    table.apply(at::json::array({row("bitcoin", "10.0", "1")}));
+    auto malformed = row("ethereum", "2.0", "1");
+    malformed["market_cap_usd"] = "not a number";
+    at::cm_ticker_changes_t changes;
+    ASSERT_THROW(table.apply(at::json::array({malformed}), changes),
+                 std::invalid_argument);
+    ASSERT_EQ(1, table.size());
+    ASSERT_EQ(at::TickerTable::npos, table.find("ethereum"));
+    ASSERT_TRUE(changes.added.empty());
+
+    // an updated row is left as it was
+    malformed = row("bitcoin", "11.0", "2");
+    malformed["price_btc"] = "not a number";
+    ASSERT_THROW(table.apply(at::json::array({malformed})),
+                 std::invalid_argument);
+    ASSERT_EQ(10.0, table.price_usd()[table.find("bitcoin")]);
+}
+
+TEST(TickerTable, ShouldRemapTheChangesWhenPruning)
+{
+    at::TickerTable table;
+    at::json rows = at::json::array();
+    for (int i = 0; i < 100; ++i) {
+        rows.push_back(row("coin" + std::to_string(i), "1.0", "1"));
+    }
+    table.apply(rows);
+
+    // a mass delisting: only a coin out of 3 is left, half of them updated
+    rows = at::json::array();
+    for (int i = 0; i < 100; i += 3) {
+        rows.push_back(row("coin" + std::to_string(i), "2.0",
+                           i % 2 == 0 ? "2" : "1"));
+    }
+    rows.push_back(row("new", "3.0", "1"));
+    auto changes = table.apply(rows, true);
+    ASSERT_EQ(34 + 1, table.size());
+    ASSERT_EQ(66, changes.removed.size());
+    ASSERT_EQ(1, changes.added.size());
+    ASSERT_EQ("new", table.at(changes.added[0]).id);
+    ASSERT_EQ(17, changes.updated.size());
+    for (auto idx : changes.updated) {
+        ASSERT_EQ(2.0, table.price_usd()[idx]);
+        ASSERT_EQ(2, table.last_updated()[idx]);
+    }
+    for (std::size_t idx = 0; idx < table.size(); ++idx) {
+        ASSERT_EQ(idx, table.find(table.id()[idx]));
+    }
+}
@@ -0,0 +1,170 @@
+#include <at/exceptions.hpp>
+#include <at/kraken.hpp>
+#include <at/request.hpp>
+#include <at/transport.hpp>
+#include <gtest/gtest.h>
+
+#include <cstdio>
+
+#include "mockserver.hpp"
+
+// Restores the transport of Request
+struct TransportGuard {
+    std::shared_ptr<at::Transport> transport = at::Request::transport();
+    ~TransportGuard() { at::Request::transport(transport); }
+};
+
+TEST(Transport, RecordReplay)
+{
+    const std::string path = ::testing::TempDir() + "transport_test.bin";
+    std::remove(path.c_str());
+    TransportGuard guard;
+    const at::currency_pair_t pair("BTC", "EUR");
+
+    std::string host;
+    at::ticker_t ticker;
+    std::map<std::string, double> balance;
+    {
+        at::MockServer server;
+        server.kraken();
+        host = server.url();
+        at::Kraken kraken("key", "c2VjcmV0", host);
+        at::Request::transport(
+            std::make_shared<at::RecordingTransport>(guard.transport, path));
+        ticker = kraken.ticker(pair);
+        balance = kraken.balance();
+        kraken.balance();
+        EXPECT_EQ(server.requests(), 3);
+    }
+
+    // the server is gone: the responses come from the recording
+    auto replay = std::make_shared<at::ReplayTransport>(path);
+    EXPECT_EQ(replay->size(), 2);
+    at::Request::transport(replay);
+    at::Kraken kraken("key", "c2VjcmV0", host);
+    EXPECT_EQ(kraken.ticker(pair).ask.price, ticker.ask.price);
+    // different nonce, same response
+    EXPECT_EQ(kraken.balance(), balance);
+    EXPECT_THROW(kraken.orderBook(pair), at::server_error);
+
+    std::remove(path.c_str());
+}
+
+TEST(Transport, RecordReplayBatch)
+{
+    const std::string path =
+        ::testing::TempDir() + "transport_test_batch.bin";
+    std::remove(path.c_str());
+    TransportGuard guard;
+
+    // 3 BTC orders placed in a batch, the last one too large
+    std::vector<at::order_t> orders(3);
+    for (std::size_t i = 0; i < orders.size(); ++i) {
+        orders[i].pair = at::currency_pair_t("BTC", "EUR");
+        orders[i].action = at::order_action_t::buy;
+        orders[i].type = at::order_type_t::limit;
+        orders[i].volume = i == 2 ? 1000 : 0.01;
+        orders[i].price = 6000 - static_cast<double>(i);
+    }
+    auto recorded = orders;
+
+    std::string host;
+    {
+        at::MockServer server;
+        server.kraken();
+        host = server.url();
+        at::Kraken kraken("key", "c2VjcmV0", host);
+        at::Request::transport(
+            std::make_shared<at::RecordingTransport>(guard.transport, path));
+        auto placed = kraken.place(recorded);
+        EXPECT_EQ(placed[0], nullptr);
+        EXPECT_NE(placed[2], nullptr);
+        recorded.pop_back();
+        auto canceled = recorded;
+        for (const auto& error : kraken.cancel(canceled)) {
+            EXPECT_EQ(error, nullptr);
+        }
+        EXPECT_EQ(server.requests(), 2);
+    }
+
+    // the nonce in the JSON bodies is ignored too
+    at::Request::transport(std::make_shared<at::ReplayTransport>(path));
+    at::Kraken kraken("key", "c2VjcmV0", host);
+    auto placed = kraken.place(orders);
+    ASSERT_EQ(placed.size(), 3);
+    EXPECT_EQ(placed[0], nullptr);
+    EXPECT_EQ(placed[1], nullptr);
+    EXPECT_THROW(std::rethrow_exception(placed[2]), at::response_error);
+    EXPECT_EQ(orders[0].txid, recorded[0].txid);
+    EXPECT_EQ(orders[1].txid, recorded[1].txid);
+    orders.pop_back();
+    for (const auto& error : kraken.cancel(orders)) {
+        EXPECT_EQ(error, nullptr);
+    }
+
+    std::remove(path.c_str());
+}
+
+TEST(Transport, Buffer)
+{
+    std::string body(1 << 20, 'x');
+    const char* storage = body.data();
+    at::Transport::recycle(std::move(body));
+    auto buffer = at::Transport::buffer();
+    EXPECT_TRUE(buffer.empty());
+    EXPECT_GE(buffer.capacity(), 1 << 20);
+    EXPECT_EQ(buffer.data(), storage);
+    // the storage is handed out once
+    EXPECT_NE(at::Transport::buffer().data(), storage);
+}
+
+TEST(CurlTransport, Config)
+{
+    at::MockServer server;
+    std::string encoding;
+    server.route("GET", "/", [&](const at::mock_request_t& request) {
+        auto it = request.headers.find("accept-encoding");
+        encoding = it == request.headers.end() ? "" : it->second;
+        return at::mock_response_t{200, "{}", "application/json"};
+    });
+    const std::string host = "127.0.0.1:" + std::to_string(server.port());
+    at::CurlTransport transport;
+    at::http_request_t request = {};
+    request.method = "GET";
+    request.url = server.url();
+
+    auto response = transport.perform(request);
+    EXPECT_EQ(response.status, 200);
+    EXPECT_FALSE(encoding.empty());
+    // the connection is kept alive
+    response = transport.perform(request);
+    EXPECT_EQ(response.timing.connect.count(), 0);
+
+    transport.configure(host, {false, at::http_version_t::http1_1});
+    EXPECT_FALSE(transport.config(host).compression);
+    EXPECT_TRUE(transport.config("api.kraken.com").compression);
+    transport.perform(request);
+    EXPECT_TRUE(encoding.empty());
+}
+
+TEST(CurlTransport, Warmup)
+{
+    at::MockServer server;
+    server.kraken();
+    at::Kraken kraken("key", "c2VjcmV0", server.url());
+    kraken.warmup();
+    EXPECT_EQ(server.requests(), 1);
+
+    // the first call reuses the connection
+    at::Latency::reset();
+    kraken.time();
+    EXPECT_EQ(at::Latency::summary("GET 127.0.0.1:" +
+                                       std::to_string(server.port()) +
+                                       "/0/public/Time",
+                                   at::latency_phase_t::connect)
+                  .max.count(),
+              0);
+
+    at::Kraken down("key", "c2VjcmV0", "http://127.0.0.1:1/");
+    EXPECT_THROW(down.warmup(), at::connection_error);
+}
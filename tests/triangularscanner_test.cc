@@ -0,0 +1,50 @@
+#include <at/triangularscanner.hpp>
+#include <gtest/gtest.h>
+
+TEST(TriangularScanner, ShouldRecomputeTheCyclesOfTheUpdatedPair)
+{
+    auto market = [](const std::string& base, const std::string& quote) {
+        return at::market_info_t{.pair = at::currency_pair_t(base, quote),
+                                 .limit = {.min = 0, .max = 0},
+                                 .maker_fee = 0,
+                                 .taker_fee = 0.1};
+    };
+    at::TriangularScanner scanner({market("XXBT", "ZEUR"),
+                                   market("XETH", "XXBT"),
+                                   market("XETH", "ZEUR"),
+                                   market("XLTC", "ZEUR")});
+    // EUR -> BTC -> ETH -> EUR and the opposite direction
+    ASSERT_EQ(scanner.size(), 2);
+
+    auto ticker = [](double bid, double ask) {
+        return at::ticker_t{.bid = {.price = bid, .amount = 1, .time = 0},
+                            .ask = {.price = ask, .amount = 1, .time = 0}};
+    };
+    scanner.update(at::currency_pair_t("BTC", "EUR"), ticker(1000, 1001));
+    scanner.update(at::currency_pair_t("ETH", "BTC"), ticker(0.1, 0.1001));
+    ASSERT_TRUE(scanner.update(at::currency_pair_t("LTC", "EUR"),
+                               ticker(50, 51))
+                    .empty());
+    ASSERT_TRUE(scanner.opportunities().empty());
+
+    // ETH is overpriced in EUR: BTC -> ETH -> EUR -> BTC
+    auto found =
+        scanner.update(at::currency_pair_t("ETH", "EUR"), ticker(110, 111));
+    ASSERT_EQ(found.size(), 1);
+    auto cycle = scanner.cycle(found[0]);
+    double keep = 1 - 0.001;
+    ASSERT_NEAR(cycle.rate, keep / 1001 * keep / 0.1001 * keep * 110, 1e-12);
+
+    auto opportunities = scanner.opportunities(1.05);
+    ASSERT_EQ(opportunities.size(), 1);
+    ASSERT_EQ(opportunities[0].path,
+              std::vector<std::string>({"BTC", "ETH", "EUR"}));
+    ASSERT_EQ(opportunities[0].actions,
+              std::vector<at::order_action_t>({at::order_action_t::buy,
+                                               at::order_action_t::sell,
+                                               at::order_action_t::buy}));
+
+    ASSERT_THROW(scanner.update(at::currency_pair_t("XMR", "EUR"),
+                                ticker(1, 2)),
+                 std::out_of_range);
+}
@@ -6,3 +6,22 @@ TEST(CurrencyPair, ShouldPrintCorrectly) {
     ASSERT_EQ("USD_BTC", p.str());
 }
 
+
+TEST(CurrencyPair, ShouldNormalizeKrakenAssets) {
+    ASSERT_EQ("BTC", at::normalize_symbol("XXBT"));
+    ASSERT_EQ("BTC", at::normalize_symbol("xbt"));
+    ASSERT_EQ("DOGE", at::normalize_symbol("XXDG"));
+    ASSERT_EQ("ETH", at::normalize_symbol("XETH"));
+    ASSERT_EQ("EUR", at::normalize_symbol("ZEUR"));
+    ASSERT_EQ("USD", at::normalize_symbol("ZUSD"));
+    ASSERT_EQ("DASH", at::normalize_symbol("DASH"));
+    // not Kraken asset codes
+    ASSERT_EQ("XAUT", at::normalize_symbol("XAUT"));
+    ASSERT_EQ("ZEUS", at::normalize_symbol("ZEUS"));
+    ASSERT_EQ("XTZ", at::normalize_symbol("XTZ"));
+
+    auto p = at::normalize(at::currency_pair_t("XXBT", "ZEUR"));
+    ASSERT_EQ("BTC_EUR", p.str());
+    p = at::normalize(at::currency_pair_t("XAUT", "ZUSD"));
+    ASSERT_EQ("XAUT_USD", p.str());
+}